@@ -0,0 +1,385 @@
+// 解释器热点路径的基准测试
+// 用法: ./bench [--min-time=秒] [名字过滤]
+// 结果以 JSON 输出到标准输出，便于和基线对比
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "cache.h"
+#include "evaluator.h"
+#include "lexer.h"
+#include "parser.h"
+
+namespace {
+
+std::atomic<size_t> g_allocations{0};
+
+}
+
+// 统计堆分配次数
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+using namespace autumn;
+
+struct Benchmark {
+    std::string name;
+    // 计时前的准备工作，不计入耗时
+    std::function<void()> setup;
+    std::function<void()> run;
+};
+
+struct Result {
+    std::string name;
+    size_t iterations = 0;
+    double ns_per_op = 0;
+    double allocs_per_op = 0;
+    long peak_rss_kb = 0;
+};
+
+// 进程从启动以来的内存峰值，每个基准测试都在自己的子进程中运行，因此只反映这一项
+long peak_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+Result measure(const Benchmark& bench, double min_time) {
+    using Clock = std::chrono::steady_clock;
+
+    if (bench.setup) {
+        bench.setup();
+    }
+    // 预热
+    bench.run();
+
+    Result result;
+    result.name = bench.name;
+
+    size_t iterations = 1;
+    while (true) {
+        size_t allocations = g_allocations.load();
+        auto begin = Clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            bench.run();
+        }
+        auto end = Clock::now();
+        allocations = g_allocations.load() - allocations;
+
+        double elapsed = std::chrono::duration<double, std::nano>(end - begin).count();
+        if (elapsed >= min_time * 1e9 || iterations >= (1u << 30)) {
+            result.iterations = iterations;
+            result.ns_per_op = elapsed / iterations;
+            result.allocs_per_op = double(allocations) / iterations;
+            break;
+        }
+        iterations *= 2;
+    }
+
+    result.peak_rss_kb = peak_rss_kb();
+    return result;
+}
+
+// 在子进程中运行 measure，结果通过管道传回，创建进程失败时在当前进程中运行
+Result measure_isolated(const Benchmark& bench, double min_time) {
+    struct Sample {
+        size_t iterations;
+        double ns_per_op;
+        double allocs_per_op;
+        long peak_rss_kb;
+    };
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return measure(bench, min_time);
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return measure(bench, min_time);
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        auto result = measure(bench, min_time);
+        Sample sample = {result.iterations, result.ns_per_op, result.allocs_per_op, result.peak_rss_kb};
+        bool ok = write(fds[1], &sample, sizeof(sample)) == ssize_t(sizeof(sample));
+        // 不运行析构函数，避免子进程写出缓冲的输出
+        _exit(ok ? 0 : 1);
+    }
+
+    close(fds[1]);
+    Sample sample = {};
+    size_t got = 0;
+    while (got < sizeof(sample)) {
+        ssize_t n = read(fds[0], reinterpret_cast<char*>(&sample) + got, sizeof(sample) - got);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        got += n;
+    }
+    close(fds[0]);
+    waitpid(pid, nullptr, 0);
+
+    Result result;
+    result.name = bench.name;
+    if (got == sizeof(sample)) {
+        result.iterations = sample.iterations;
+        result.ns_per_op = sample.ns_per_op;
+        result.allocs_per_op = sample.allocs_per_op;
+        result.peak_rss_kb = sample.peak_rss_kb;
+    }
+    return result;
+}
+
+std::string repeat(const std::string& s, size_t n) {
+    std::string ret;
+    ret.reserve(s.size() * n);
+    for (size_t i = 0; i < n; ++i) {
+        ret.append(s);
+    }
+    return ret;
+}
+
+// 词法/语法分析使用的脚本
+const std::string SOURCE = repeat(R"(
+let fib = fn(n) {
+    if (n < 2) {
+        return n;
+    }
+    return fib(n - 1) + fib(n - 2);
+};
+let names = {"one": 1, "two": 2, "three": 3};
+let arr = [1, 2 * 3, "hello" + "world", names["one"]];
+let adder = fn(x) { fn(y) { x + y } };
+puts(adder(1)(2) >= 3, !true, -arr[0]);
+)", 20);
+
+std::vector<Benchmark> benchmarks() {
+    static Evaluator evaluator;
+
+    auto prepare = [](const std::string& prelude) {
+        return [prelude] {
+            evaluator.reset_env();
+            evaluator.eval(prelude);
+        };
+    };
+
+    auto eval = [](const std::string& input) {
+        return [input] {
+            evaluator.eval(input);
+        };
+    };
+
+    return {
+        {"lexer", nullptr, [] {
+            Lexer lexer(SOURCE);
+            while (lexer.next_token().type != Token::END) {
+            }
+        }},
+        {"parser", nullptr, [] {
+            Parser parser;
+            parser.parse(SOURCE);
+        }},
+        {"cache_decode", nullptr, [] {
+            // 与 parser 对比：同一份脚本从 .atmc 缓存解码
+            static const std::string encoded = cache::encode(*Parser().parse(SOURCE));
+            cache::decode(encoded);
+        }},
+        {"fib", prepare(R"(
+            let fib = fn(n) {
+                if (n < 2) {
+                    return n;
+                }
+                return fib(n - 1) + fib(n - 2);
+            };
+        )"), eval("fib(15)")},
+        {"fib_interpreter", prepare(R"(
+            let fib = fn(n) {
+                if (n < 2) {
+                    return n;
+                }
+                return fib(n - 1) + fib(n - 2);
+            };
+        )"), [] {
+            // 与 fib 对比：关闭 JIT，始终由解释器执行
+            evaluator.set_jit(false);
+            evaluator.eval("fib(15)");
+            evaluator.set_jit(true);
+        }},
+        {"fib_closure", [] {
+            // 与 fib_interpreter 对比：函数由闭包后端转换后执行
+            evaluator.reset_env();
+            evaluator.set_backend(Evaluator::Backend::CLOSURE);
+            evaluator.eval(R"(
+                let fib = fn(n) {
+                    if (n < 2) {
+                        return n;
+                    }
+                    return fib(n - 1) + fib(n - 2);
+                };
+            )");
+            evaluator.set_backend(Evaluator::Backend::TREE);
+        }, [] {
+            evaluator.set_jit(false);
+            evaluator.eval("fib(15)");
+            evaluator.set_jit(true);
+        }},
+        {"closure", prepare(R"(
+            let make = fn(x) { fn(y) { x + y } };
+            let go = fn(n, acc) {
+                if (n == 0) { acc } else { go(n - 1, make(n)(acc)) }
+            };
+        )"), eval("go(500, 0)")},
+        {"array_push_rest", prepare(R"(
+            let build = fn(n, a) {
+                if (n == 0) { a } else { build(n - 1, push(a, n)) }
+            };
+            let drain = fn(a, s) {
+                if (len(a) == 0) { s } else { drain(rest(a), s + first(a)) }
+            };
+        )"), eval("drain(build(200, []), 0)")},
+        {"hash_build", nullptr, eval("{" + [] {
+            std::string pairs;
+            for (int i = 0; i < 500; ++i) {
+                if (i != 0) {
+                    pairs.append(", ");
+                }
+                pairs.append(std::to_string(i) + ": " + std::to_string(i));
+            }
+            return pairs;
+        }() + "}")},
+        {"hash_lookup", prepare("let h = {" + [] {
+            std::string pairs;
+            for (int i = 0; i < 500; ++i) {
+                if (i != 0) {
+                    pairs.append(", ");
+                }
+                pairs.append(std::to_string(i) + ": " + std::to_string(i));
+            }
+            return pairs;
+        }() + R"(};
+            let sum = fn(i, s) {
+                if (i == 500) { s } else { sum(i + 1, s + h[i]) }
+            };
+        )"), eval("sum(0, 0)")},
+        {"string_concat", prepare(R"(
+            let cat = fn(n, s) {
+                if (n == 0) { s } else { cat(n - 1, s + "ab") }
+            };
+        )"), eval(R"(cat(500, ""))")},
+        {"builtin_call", prepare(R"(
+            let a = [1, 2, 3];
+            let go = fn(n, s) {
+                if (n == 0) { s } else { go(n - 1, s + len(a)) }
+            };
+        )"), eval("go(500, 0)")},
+        {"int_array_sum", prepare(R"(
+            let a = int_array(100000) + 3;
+        )"), eval("sum(a * a) + dot(a, a) + max(a)")},
+        {"float_math", prepare(R"(
+            let score = fn(x, w) { x * w + 0.5 * x / (w + 1.0) };
+        )"), eval(R"(
+            let s = 0.0;
+            let i = 0;
+            while (i < 1000) {
+                s = s + score(1.5, 0.25);
+                i = i + 1;
+            }
+        )")},
+        {"inspect_nested", prepare(R"(
+            let row = fn(i) { {"id": i, "tags": ["a", "b", "c"], "scores": [i, i * 2, i * 3, 1.5]} };
+            let build = fn(n, a) {
+                if (n == 0) { a } else { build(n - 1, push(a, [row(n), row(n + 1)])) }
+            };
+            let data = build(200, []);
+        )"), [] {
+            evaluator.lookup("data")->inspect();
+        }},
+        {"histogram", nullptr, eval(R"(
+            let counts = {};
+            let keys = [0, 1, 2, 3, 4, 5, 6, 7];
+            let i = 0;
+            while (i < 1000) {
+                for (k in keys) {
+                    counts[k] = i;
+                }
+                i = i + 1;
+            }
+        )")},
+    };
+}
+
+void print_json(const std::vector<Result>& results) {
+    std::cout << "{\"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto& r = results[i];
+        if (i != 0) {
+            std::cout << ',';
+        }
+        std::cout << "\n  {\"name\": \"" << r.name << '"'
+            << ", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << r.ns_per_op
+            << ", \"allocs_per_op\": " << r.allocs_per_op
+            << ", \"peak_rss_kb\": " << r.peak_rss_kb
+            << '}';
+    }
+    std::cout << "\n]}" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    double min_time = 0.5;
+    std::string filter;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--min-time=", 11) == 0) {
+            min_time = atof(argv[i] + 11);
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    std::vector<Result> results;
+    for (auto& bench : benchmarks()) {
+        if (!filter.empty() && bench.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        results.push_back(measure_isolated(bench, min_time));
+    }
+
+    print_json(results);
+    return 0;
+}
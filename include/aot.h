@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "environment.h"
+#include "evaluator.h"
+#include "object.h"
+#include "program.h"
+
+namespace autumn {
+namespace aot {
+
+// autumn compile 生成的 C++ 代码所使用的运行时
+// 生成的代码只负责控制流、求值顺序和变量绑定，各种运算仍然调用求值器中的实现，
+// 所以编译前后的结果（包括错误信息、统计和分析器的栈帧）完全相同。
+
+using Value = std::shared_ptr<object::Object>;
+using Env = std::shared_ptr<object::Environment>;
+
+// 整数快速路径放弃（溢出、除以 0）超过这个次数后不再尝试，一直执行通用版本
+constexpr uint32_t MAX_FAST_FAILURES = 100;
+
+inline bool is_error(const Value& val) {
+    return val != nullptr && val->type() == object::Type::ERROR_OBJECT;
+}
+
+class Runtime {
+public:
+    explicit Runtime(const Evaluator& evaluator) : _evaluator(evaluator) {
+    }
+
+    static Value integer(int64_t value) {
+        return std::make_shared<object::Integer>(value);
+    }
+    // 超出 int64_t 范围的整数字面量
+    static Value big_integer(std::string_view literal);
+    static Value floating(double value);
+    static Value string(const std::string& value) {
+        return std::make_shared<object::String>(value);
+    }
+    static Value boolean(bool value) {
+        return value ? object::constants::True : object::constants::False;
+    }
+
+    Value identifier(Env& env, const std::string& name, int builtin) const;
+    Value prefix(const std::string& op, const Value& right, Env& env) const;
+    Value infix(const std::string& op, const Value& left, const Value& right, Env& env) const;
+    Value index(const Value& left, const Value& index) const;
+    // frame 是分析器中的栈帧名
+    Value call(const std::string& frame, const Value& fn, object::Arguments args) const;
+    Value assign(Env& env, const std::string& name, const Value& val) const;
+    // indexes 按从外到内的顺序排列，与求值器相同
+    Value assign_index(
+            Env& env,
+            const std::string& name,
+            const std::vector<Value>& indexes,
+            const Value& val) const;
+    Value invalid_target(const std::string& target) const;
+    Value not_iterable(const Value& iterable) const;
+
+    bool truthy(const Value& val) const {
+        return _evaluator.is_truthy(val.get());
+    }
+
+    // 整数快速路径的入口守卫：当前调用帧中的参数是整数，函数名仍然绑定到自身
+    static bool integer_argument(const Env& env, const std::string& name, int64_t& out);
+    static bool bound_to(const Env& env, const std::string& name, const object::Object* target);
+private:
+    // 求值器通过 _signal 传递错误，生成的代码直接检查返回值，每次操作之后清除
+    Value done(Value&& val) const;
+private:
+    const Evaluator& _evaluator;
+};
+
+// 按先序遍历收集程序中所有的函数字面量，生成代码和运行时用同样的编号
+std::vector<const ast::FunctionLiteral*> function_literals(const ast::Program& program);
+
+// 生成代码中嵌入的语法树
+// 函数对象仍然带着形参和函数体，inspect、堆快照、JIT 和内置函数的回调都不受影响
+class Module {
+public:
+    Module(std::string_view encoded, std::vector<object::Function::Native> natives);
+
+    // 第 index 个函数字面量在 env 中求值得到的闭包
+    Value function(size_t index, Env& env) const;
+private:
+    std::unique_ptr<ast::Program> _program;
+    std::vector<const ast::FunctionLiteral*> _literals;
+    std::vector<object::Function::Native> _natives;
+};
+
+// 生成程序的入口，行为与 autumn run 相同：命令行参数放在 args 中，出错时退出码为 1
+int main(int argc, char* argv[], Evaluator::Native program);
+
+} // namespace aot
+} // namespace autumn
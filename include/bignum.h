@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace autumn {
+
+// 任意精度整数，Integer 运算溢出时使用
+// 符号 + 绝对值表示，绝对值按 2^32 进制小端存放，0 的绝对值为空
+class Bignum {
+public:
+    Bignum() = default;
+    explicit Bignum(int64_t value);
+
+    // 解析十进制整数，可以带负号，格式错误时返回 false
+    static bool parse(std::string_view text, Bignum& out);
+
+    bool negative() const {
+        return _negative;
+    }
+
+    bool is_zero() const {
+        return _digits.empty();
+    }
+
+    // 能否无损转换为 int64_t
+    bool fits_int64() const;
+    int64_t to_int64() const;
+    // 超出 double 范围时得到 inf
+    double to_double() const;
+
+    std::string to_string() const;
+    size_t hash() const;
+
+    Bignum operator-() const;
+
+    friend Bignum operator+(const Bignum& lhs, const Bignum& rhs);
+    friend Bignum operator-(const Bignum& lhs, const Bignum& rhs);
+    friend Bignum operator*(const Bignum& lhs, const Bignum& rhs);
+    // 向零取整，与 int64_t 的除法一致；除数不能为 0
+    friend Bignum operator/(const Bignum& lhs, const Bignum& rhs);
+
+    // 返回 -1, 0, 1
+    friend int compare(const Bignum& lhs, const Bignum& rhs);
+private:
+    using Digits = std::vector<uint32_t>;
+
+    static int compare_magnitude(const Digits& lhs, const Digits& rhs);
+    static Digits add_magnitude(const Digits& lhs, const Digits& rhs);
+    // 要求 lhs >= rhs
+    static Digits sub_magnitude(const Digits& lhs, const Digits& rhs);
+    static Digits mul_magnitude(const Digits& lhs, const Digits& rhs);
+    static Digits div_magnitude(const Digits& lhs, const Digits& rhs);
+    // 原地计算 digits = digits * mul + add
+    static void mul_add_small(Digits& digits, uint32_t mul, uint32_t add);
+    // 原地计算 digits /= div，返回余数
+    static uint32_t div_small(Digits& digits, uint32_t div);
+
+    // 去掉高位的 0，并保证 0 没有负号
+    void trim();
+private:
+    bool _negative = false;
+    Digits _digits;
+};
+
+} // namespace autumn
@@ -1,21 +1,53 @@
 #pragma once
 
 #include <memory>
-#include <map>
+#include <vector>
 
 #include "object.h"
 
 namespace autumn {
 namespace builtin {
 
-extern std::map<std::string, object::BuiltinFunction> BUILTINS;
+// 所有内置函数对象，下标在进程内固定不变
+extern const std::vector<std::shared_ptr<object::Object>> BUILTINS;
 
-std::shared_ptr<object::Object> len(const std::vector<std::shared_ptr<object::Object>>& args);
-std::shared_ptr<object::Object> first(const std::vector<std::shared_ptr<object::Object>>& args);
-std::shared_ptr<object::Object> last(const std::vector<std::shared_ptr<object::Object>>& args);
-std::shared_ptr<object::Object> push(const std::vector<std::shared_ptr<object::Object>>& args);
-std::shared_ptr<object::Object> rest(const std::vector<std::shared_ptr<object::Object>>& args);
-std::shared_ptr<object::Object> puts(const std::vector<std::shared_ptr<object::Object>>& args);
+// 返回内置函数在 BUILTINS 中的下标，不存在时返回 -1
+int lookup(const std::string& name);
+
+std::shared_ptr<object::Object> len(object::Arguments args);
+std::shared_ptr<object::Object> first(object::Arguments args);
+std::shared_ptr<object::Object> last(object::Arguments args);
+std::shared_ptr<object::Object> push(object::Arguments args);
+std::shared_ptr<object::Object> rest(object::Arguments args);
+std::shared_ptr<object::Object> puts(object::Arguments args);
+// 立即写出 puts 缓冲的输出
+std::shared_ptr<object::Object> flush(object::Arguments args);
+// 中断求值并请求退出，参数为退出码，默认为 0。
+// 库本身不结束进程，宿主通过 Evaluator::exit_requested() 和 exit_status() 处理
+std::shared_ptr<object::Object> exit(object::Arguments args);
+
+// 并行版本的 map/filter/reduce，大数组会被切块后交给工作窃取线程池执行
+// 结果保持原有顺序。fn 在多个线程上同时执行，只能修改自己创建的变量，
+// 给全局变量或捕获的变量赋值（包括下标赋值）会返回错误
+// arr 可以是 Array 或 IntArray，IntArray 的元素在各分块中装箱，pfilter 的结果仍是 IntArray
+// preduce(arr, fn, init[, combine])：fn(acc, elem) 归约；只有给出 combine(left, right) 时才并行，
+// combine 为 true 表示 fn 满足结合律，直接用 fn 合并。
+// 各块都从 init 开始归约，再用 combine 按顺序合并，因此 init 须是 combine 的单位元
+std::shared_ptr<object::Object> pmap(object::Arguments args);
+std::shared_ptr<object::Object> pfilter(object::Arguments args);
+std::shared_ptr<object::Object> preduce(object::Arguments args);
+
+// 整数数组：int_array 把只包含整数的数组转换为 IntArray，或创建 n 个 0
+// 其余函数同时接受 IntArray 和只包含整数的 Array，内部使用 SIMD 实现，溢出时和整数运算一样得到大整数
+std::shared_ptr<object::Object> int_array(object::Arguments args);
+std::shared_ptr<object::Object> sum(object::Arguments args);
+std::shared_ptr<object::Object> min(object::Arguments args);
+std::shared_ptr<object::Object> max(object::Arguments args);
+std::shared_ptr<object::Object> dot(object::Arguments args);
+std::shared_ptr<object::Object> filter_gt(object::Arguments args);
+
+// 返回当前求值器的运行时计数器
+std::shared_ptr<object::Object> stats(object::Arguments args);
 
 } // namespace builtin
 } // namespace autumn
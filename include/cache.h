@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "program.h"
+
+namespace autumn {
+namespace cache {
+
+// 语法树缓存（.atmc 文件）
+// 文件头记录源码指纹，源码改变后缓存自然失效；
+// 读取时把文件 mmap 到内存中直接解码出语法树，跳过词法和语法分析。
+
+// 语法树的结构或编码方式变化时需要加一
+constexpr uint32_t VERSION = 1;
+
+// 源码指纹（64 位 FNV-1a）
+uint64_t fingerprint(std::string_view source);
+
+// 语法树与字节串的相互转换，数据不完整或已损坏时 decode 返回 nullptr
+std::string encode(const ast::Program& program);
+std::unique_ptr<ast::Program> decode(std::string_view data);
+
+// 函数的形参和函数体，堆快照用它保存函数对象
+std::string encode(
+        const std::vector<std::shared_ptr<ast::Identifier>>& parameters,
+        const ast::BlockStatment& body);
+bool decode(
+        std::string_view data,
+        std::vector<std::shared_ptr<ast::Identifier>>& parameters,
+        std::shared_ptr<ast::BlockStatment>& body);
+
+// 读取缓存，文件不存在、已损坏或指纹不符时返回 nullptr
+std::unique_ptr<ast::Program> load(const std::string& path, uint64_t fingerprint);
+// 写入缓存，先写临时文件再改名，同时运行的其它进程不会读到写了一半的文件
+bool store(const std::string& path, uint64_t fingerprint, const ast::Program& program);
+
+// 脚本对应的缓存路径：rules.atm -> rules.atmc
+std::string path_for(const std::string& script);
+
+} // namespace cache
+} // namespace autumn
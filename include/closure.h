@@ -0,0 +1,50 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+#include "environment.h"
+#include "object.h"
+#include "program.h"
+
+namespace autumn {
+
+class Evaluator;
+
+namespace closure {
+
+// 闭包编译后端
+// 语法树在执行前一次性转换为预先绑定好的 C++ 闭包树：运算符、变量名、内置函数和常量在转换时确定，
+// 求值时沿着闭包逐层直接调用，不再按节点类型逐个比较 typeid。
+// return 和错误与树遍历一样通过求值器的 _signal 传递，两种后端的结果完全相同。
+
+using Value = std::shared_ptr<object::Object>;
+using Env = std::shared_ptr<object::Environment>;
+
+class Code {
+public:
+    using Fn = std::function<Value(const Evaluator&, Env&)>;
+
+    Code() = default;
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Code>>>
+    Code(F fn) : _fn(std::move(fn)) {
+    }
+
+    Value operator()(const Evaluator& evaluator, Env& env) const {
+        return _fn(evaluator, env);
+    }
+
+    explicit operator bool() const {
+        return static_cast<bool>(_fn);
+    }
+private:
+    Fn _fn;
+};
+
+// 闭包中直接引用语法树的节点，执行期间语法树必须存活
+// 函数字面量的函数体在转换时一并转换，由创建出的函数对象持有
+Code compile(const ast::Node* node);
+
+} // namespace closure
+} // namespace autumn
@@ -8,6 +8,12 @@ namespace color {
 class Color {
 public:
     Color(const std::string_view& c);
+
+    // 控制序列，设置了 AUTUMN_COLOR_OFF 时为空
+    std::string_view code() const {
+        return _color_env ? _color : std::string_view();
+    }
+
     friend std::string operator+(const Color& c, const std::string& rhs);
     friend std::string operator+(const std::string& rhs, const Color& c);
     friend std::ostream& operator<<(std::ostream&, const Color&);
@@ -1,24 +1,40 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <map>
 
+#include "pool.h"
+#include "stats.h"
+
 namespace autumn {
 namespace object {
 
 class Object;
 class Environment {
 public:
-    Environment() {}
-    Environment(std::shared_ptr<Environment>& outer) :
-            _outer(outer) {}
+    // 变量的节点从当前线程的空闲链表中分配，调用返回后释放的节点留给下一次调用
+    using Store = std::map<std::string, std::shared_ptr<Object>, std::less<std::string>,
+            PoolAllocator<std::pair<const std::string, std::shared_ptr<Object>>>>;
+
+    Environment() : _version(next_version()), _owner(current_owner) {
+        count();
+    }
+    Environment(const std::shared_ptr<Environment>& outer) :
+            _outer(outer), _owner(current_owner) {
+        count();
+    }
     std::shared_ptr<Object> get(const std::string& name) {
         auto it = _store.find(name);
         if (it == _store.end()) {
             if (_outer != nullptr) {
                 return _outer->get(name);
             }
+            if (Stats::current != nullptr) {
+                ++Stats::current->env_misses;
+            }
             return nullptr;
         }
 
@@ -26,13 +42,118 @@ public:
     }
 
     std::shared_ptr<Object> set(const std::string& name,
-            std::shared_ptr<Object>& val) {
-        _store[name] = val;
+            const std::shared_ptr<Object>& val) {
+        auto [it, inserted] = _store.try_emplace(name);
+        if (inserted && _outer == nullptr) {
+            _version = next_version();
+        }
+        it->second = val;
         return val;
     }
+
+    // 重新绑定最近一层作用域中已定义的变量，没有定义过时返回 false
+    bool assign(const std::string& name, const std::shared_ptr<Object>& val) {
+        auto slot = find(name);
+        if (slot == nullptr) {
+            return false;
+        }
+        *slot = val;
+        return true;
+    }
+
+    // 最近一层作用域中保存该变量的位置，没有定义过时返回 nullptr
+    std::shared_ptr<Object>* find(const std::string& name) {
+        for (auto env = this; env != nullptr; env = env->_outer.get()) {
+            auto it = env->_store.find(name);
+            if (it != env->_store.end()) {
+                return &it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    // 与 find 相同，但变量所在的环境在当前线程上不可修改时返回 nullptr 并把 shared 设为 true
+    std::shared_ptr<Object>* find_writable(const std::string& name, bool& shared) {
+        for (auto env = this; env != nullptr; env = env->_outer.get()) {
+            auto it = env->_store.find(name);
+            if (it != env->_store.end()) {
+                shared = !env->writable();
+                return shared ? nullptr : &it->second;
+            }
+        }
+        shared = false;
+        return nullptr;
+    }
+
+    // 并行分块执行期间把当前线程的 owner 设为分块自己的编号，期间创建的环境都记下这个编号。
+    // 分块中只能修改自己创建的环境，其它环境（全局变量、捕获的变量）被多个线程共享；
+    // 不在分块中时不做限制
+    static inline thread_local uint64_t current_owner = 0;
+
+    static uint64_t next_owner() {
+        static std::atomic<uint64_t> next{0};
+        return next.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    bool writable() const {
+        return current_owner == 0 || _owner == current_owner;
+    }
+
+    // 在作用域内把 owner 设为当前线程的编号
+    class OwnerScope {
+    public:
+        explicit OwnerScope(uint64_t owner) : _prev(current_owner) {
+            current_owner = owner;
+        }
+
+        ~OwnerScope() {
+            current_owner = _prev;
+        }
+    private:
+        uint64_t _prev;
+    };
+
+    // 当前这一层作用域中的变量，不包括外层
+    const Store& store() const {
+        return _store;
+    }
+
+    const std::shared_ptr<Environment>& outer() const {
+        return _outer;
+    }
+
+    // 全局环境每新增一个变量就换一个新的版本号，版本号在所有环境之间都不重复
+    // 重新绑定已有的变量不改变变量的位置，版本号不变
+    uint64_t version() const {
+        return _version;
+    }
+
+    // 帧栈上的环境对象被多次调用复用：进入时指定外层，返回时清空变量和外层
+    void enter(const std::shared_ptr<Environment>& outer) {
+        _outer = outer;
+    }
+
+    void leave() {
+        _store.clear();
+        _outer.reset();
+    }
+private:
+    static uint64_t next_version() {
+        static std::atomic<uint64_t> next{0};
+        return next.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    void count() {
+        if (Stats::current != nullptr) {
+            ++Stats::current->environments;
+        }
+    }
 private:
-    std::map<std::string, std::shared_ptr<Object>> _store;
+    Store _store;
     std::shared_ptr<Environment> _outer;
+    uint64_t _version = 0;
+    // 创建这个环境的并行分块，不在分块中创建时为 0
+    uint64_t _owner = 0;
 };
 
 } // namespace object
@@ -2,21 +2,144 @@
 
 #include "environment.h"
 #include "format.h"
+#include "jit.h"
 #include "object.h"
+#include "output.h"
 #include "parser.h"
+#include "profiler.h"
+#include "small_vector.h"
+#include "stats.h"
 
 namespace autumn {
- 
+
+namespace aot {
+class Runtime;
+}
+
+namespace closure {
+class Compiler;
+}
+
+// 实参个数不超过 4 个时不需要堆分配
+using ArgumentList = SmallVector<std::shared_ptr<object::Object>, 4>;
+
 class Evaluator {
 public:
+    // AOT 编译生成的顶层代码，在全局环境中执行
+    using Native = std::shared_ptr<object::Object> (*)(
+            const Evaluator& evaluator,
+            std::shared_ptr<object::Environment>& env);
+
     Evaluator();
     // 使用 shared_ptr 的原因是有些对象是可以共享复用的
     // 比如 true/false/null
     std::shared_ptr<const object::Object> eval(const std::string& input);
 
+    // 执行脚本文件，语法树缓存在同目录的 .atmc 文件中，源码没有变化时不再重新解析
+    std::shared_ptr<const object::Object> eval_file(const std::string& path);
+
+    // 执行 autumn compile 生成的程序，结果与 eval 同一份源码相同
+    std::shared_ptr<const object::Object> eval_native(Native program);
+
+    // 在全局环境中定义变量，比如 run 模式下的命令行参数 args
+    void define(const std::string& name, const std::shared_ptr<object::Object>& value);
+    // 读取全局环境中的变量，未定义时返回 nullptr
+    std::shared_ptr<object::Object> lookup(const std::string& name) const;
+
     void reset_env();
+
+    // 把全局环境及其可达的对象保存为堆快照，新的求值器载入后不必重新执行 let 定义
+    bool save_snapshot(const std::string& path) const;
+    // 用快照替换全局环境，失败时返回 false 且保持原来的环境
+    bool load_snapshot(const std::string& path);
+
+    // 调用函数对象（Function 或 Builtin），供内置函数回调脚本中的闭包
+    // 不会刷新输出，逐条调用时由调用方在合适的时候 flush
+    std::shared_ptr<object::Object> call(
+            const object::Object* fn,
+            object::Arguments args) const;
+    bool is_truthy(const object::Object* obj) const;
+
+    // 开启采样分析器，按 interval 间隔对脚本的调用栈采样
+    void start_profiler(std::chrono::microseconds interval = std::chrono::microseconds(1000));
+    // 停止采样并以折叠栈格式输出结果，可直接交给 flamegraph.pl
+    void stop_profiler(std::ostream& out);
+    bool profiling() const {
+        return _profiler != nullptr;
+    }
+
+    // 是否把热点整数函数编译为机器码，平台支持时默认开启，设置 AUTUMN_JIT_OFF 可关闭
+    void set_jit(bool enabled) {
+        _jit = enabled && jit::supported();
+    }
+    bool jit() const {
+        return _jit;
+    }
+
+    // 是否在语法树的标识符上缓存全局变量的位置，默认开启
+    // 缓存不是线程安全的，并行执行共享同一棵语法树的求值器需要关闭
+    void set_inline_caches(bool enabled) {
+        _inline_caches = enabled;
+    }
+    bool inline_caches() const {
+        return _inline_caches;
+    }
+
+    // 执行程序的方式：逐个节点遍历语法树，或先转换为闭包树再执行
+    enum class Backend {
+        TREE,
+        CLOSURE,
+    };
+
+    // 只影响之后 eval 和 eval_file 的程序，已经创建的函数对象保持原来的执行方式
+    void set_backend(Backend backend) {
+        _backend = backend;
+    }
+    Backend backend() const {
+        return _backend;
+    }
+
+    // eval 和 eval_file 结束时自动刷新，默认写到标准输出
+    Output& output() const {
+        return _output;
+    }
+
+    // 运行时计数器，累计所有 eval 调用，可以用 reset_stats 按次清零
+    const Stats& stats() const {
+        return _stats;
+    }
+    void reset_stats() {
+        _stats.reset();
+    }
+
+    // 脚本调用了 exit(n)：求值在 exit 处中断并返回，是否结束进程由宿主决定
+    bool exit_requested() const {
+        return _exit_requested;
+    }
+    int exit_status() const {
+        return _exit_status;
+    }
 private:
-    bool is_error(const object::Object* obj) const;
+    // 生成的代码通过 Runtime 调用求值器的各项操作
+    friend class aot::Runtime;
+    friend class closure::Compiler;
+
+    // 按当前后端执行整个程序
+    std::shared_ptr<object::Object> run(const ast::Program* program) const;
+    // 结果是 exit 产生的错误时记下退出请求
+    void record_exit(const object::Object* result) const;
+
+    // 当前是否处于 return 或出错状态，是的话应立即把结果原样向外传递
+    bool is_interrupted() const {
+        return _signal != Signal::NONE;
+    }
+    // 哈希字面量中的错误不向外传递（不可哈希的键会被忽略），只有 return 需要中断
+    bool resume_after_error() const {
+        if (_signal == Signal::ERROR) {
+            _signal = Signal::NONE;
+        }
+        return _signal == Signal::NONE;
+    }
     std::shared_ptr<object::Object> eval(const ast::Node* node, std::shared_ptr<object::Environment>& env) const;
     std::shared_ptr<object::Object> eval_program(const std::vector<std::unique_ptr<ast::Statment>>& statments, std::shared_ptr<object::Environment>& env) const;
     std::shared_ptr<object::Object> eval_statments(const std::vector<std::unique_ptr<ast::Statment>>& statments, std::shared_ptr<object::Environment>& env) const;
@@ -29,11 +152,25 @@ private:
             const object::Object* left,
             const object::Object* right,
             std::shared_ptr<object::Environment>& env) const;
+    // 按节点记录的操作数类型走特化的快速路径
+    // 节点没有特化、守卫失败或需要通用路径处理（溢出、除以 0）时返回 nullptr
+    std::shared_ptr<object::Object> eval_quickened_infix_expression(
+            const ast::InfixExpression* exp,
+            const object::Object* left,
+            const object::Object* right) const;
     std::shared_ptr<object::Object> eval_integer_infix_expression(
             const std::string& op,
             const object::Object* left,
             const object::Object* right,
             std::shared_ptr<object::Environment>& env) const;
+    std::shared_ptr<object::Object> eval_bigint_infix_expression(
+            const std::string& op,
+            const object::Object* left,
+            const object::Object* right) const;
+    std::shared_ptr<object::Object> eval_float_infix_expression(
+            const std::string& op,
+            const object::Object* left,
+            const object::Object* right) const;
     std::shared_ptr<object::Object> eval_string_infix_expression(
             const std::string& op,
             const object::Object* left,
@@ -44,6 +181,11 @@ private:
             const object::Object* left,
             const object::Object* right,
             std::shared_ptr<object::Environment>& env) const;
+    std::shared_ptr<object::Object> eval_int_array_infix_expression(
+            const std::string& op,
+            const object::Object* left,
+            const object::Object* right,
+            std::shared_ptr<object::Environment>& env) const;
     std::shared_ptr<object::Object> eval_bang_operator_expression(
             const object::Object* right) const;
     std::shared_ptr<object::Object> eval_minus_prefix_operator_expression(const object::Object* right) const;
@@ -51,19 +193,68 @@ private:
     std::shared_ptr<object::Object> eval_if_expression(
             const ast::IfExpression* exp,
             std::shared_ptr<object::Environment>& env) const;
+    std::shared_ptr<object::Object> eval_while_expression(
+            const ast::WhileExpression* exp,
+            std::shared_ptr<object::Environment>& env) const;
+    std::shared_ptr<object::Object> eval_for_expression(
+            const ast::ForExpression* exp,
+            std::shared_ptr<object::Environment>& env) const;
+    std::shared_ptr<object::Object> eval_assign_expression(
+            const ast::AssignExpression* exp,
+            std::shared_ptr<object::Environment>& env) const;
+    // 给已定义的变量 name 重新赋值，返回 val 或错误
+    std::shared_ptr<object::Object> assign(
+            const std::string& name,
+            const std::shared_ptr<object::Object>& val,
+            std::shared_ptr<object::Environment>& env) const;
+    // 并行分块中修改共享变量时的错误，没有定义过时报告找不到变量
+    std::shared_ptr<object::Object> assign_error(const std::string& name, bool shared) const;
+    // a[i][j] = v 中从变量 name 开始逐层修改，indexes 按从外到内的顺序排列
+    std::shared_ptr<object::Object> assign_index(
+            const std::string& name,
+            const std::vector<std::shared_ptr<object::Object>>& indexes,
+            const std::shared_ptr<object::Object>& val,
+            std::shared_ptr<object::Environment>& env) const;
+    // 保证 container 没有被共享，不是数组或哈希表时返回错误
+    std::shared_ptr<object::Object> unshare(
+            std::shared_ptr<object::Object>& container) const;
     std::shared_ptr<object::Object> eval_identifier(
             const ast::Identifier* identifier,
             std::shared_ptr<object::Environment>& env) const;
-    std::vector<std::shared_ptr<object::Object>> eval_expressions(
+    // 通过标识符上的内联缓存读取全局变量，全局环境中没有时返回 nullptr
+    std::shared_ptr<object::Object> lookup_global(
+            const ast::Identifier* identifier,
+            const std::shared_ptr<object::Environment>& env) const;
+    // 出错时 results 中只有一个 Error 对象
+    template <typename Container>
+    void eval_expressions(
             const std::vector<std::unique_ptr<ast::Expression>>& exps,
-            std::shared_ptr<object::Environment>& env) const;
+            std::shared_ptr<object::Environment>& env,
+            Container& results) const;
 
     std::shared_ptr<object::Object> apply_function(
             const object::Object* fn,
-            std::vector<std::shared_ptr<object::Object>>& args) const;
+            object::Arguments args) const;
     std::shared_ptr<object::Environment> extend_function_env(
             const object::Function* fn,
-            std::vector<std::shared_ptr<object::Object>>& args) const;
+            object::Arguments args) const;
+    // 在帧栈上执行不会逃逸的调用，省去每次调用分配环境
+    std::shared_ptr<object::Object> call_on_stack(
+            const object::Function* fn,
+            object::Arguments args) const;
+    // 按 AOT、闭包后端、树遍历的顺序执行函数体，参数已经绑定在 env 中
+    std::shared_ptr<object::Object> run_function(
+            const object::Function* fn,
+            std::shared_ptr<object::Environment>& env) const;
+    // 执行函数编译后的机器码，还没有编译、守卫失败或 deopt 时返回 nullptr，由解释器执行
+    std::shared_ptr<object::Object> run_compiled(
+            const object::Function* fn,
+            object::Arguments args) const;
+    // 记录一次解释执行的参数和返回值类型，决定函数是否值得编译
+    void observe(
+            const object::Function* fn,
+            object::Arguments args,
+            const object::Object* result) const;
     std::shared_ptr<object::Object> eval_index_expression(
             const object::Object* obj,
             const object::Object* index) const;
@@ -72,19 +263,41 @@ private:
             const ast::HashLiteral* exp,
             std::shared_ptr<object::Environment>& env) const;
 private:
-    bool is_truthy(const object::Object* obj) const;
-
     template <typename... Args>
     std::shared_ptr<object::Error> new_error(std::string_view fmt, Args&&... args) const {
+        _signal = Signal::ERROR;
         return std::make_shared<object::Error>(format(fmt, std::forward<Args>(args)...));
     }
 
     std::shared_ptr<object::Error> new_error(std::string_view message) const {
+        _signal = Signal::ERROR;
         return std::make_shared<object::Error>(std::string(message));
     }
 private:
+    // 非局部控制流信号，与求值结果一起向外传递
+    // return 和错误都不再需要额外的包装对象
+    enum class Signal {
+        NONE,
+        RETURN,
+        ERROR,
+    };
+
     Parser _parser;
     mutable std::shared_ptr<object::Environment> _env;
+    // 帧栈：不会逃逸的调用帧按调用深度复用这里的环境对象
+    mutable std::vector<std::unique_ptr<object::Environment>> _frames;
+    mutable size_t _frame_depth = 0;
+    // 未开启分析时为空，调用路径上只多一次判空
+    std::unique_ptr<Profiler> _profiler;
+    bool _jit = false;
+    bool _inline_caches = true;
+    Backend _backend = Backend::TREE;
+    Stats _stats;
+    // 脚本的输出，call 也会写入这里
+    mutable Output _output;
+    mutable Signal _signal = Signal::NONE;
+    mutable bool _exit_requested = false;
+    mutable int _exit_status = 0;
 };
 
 } // namespace autumn
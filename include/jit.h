@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "environment.h"
+#include "object.h"
+
+namespace autumn {
+namespace jit {
+
+// x86-64 模板 JIT
+// 只编译纯整数函数：形参、let 定义的局部变量、整数字面量、+ - * / 和比较运算、
+// if/else、return，以及对同样满足条件的函数（包括自身）的调用。
+// 每种语法节点对应一段固定的机器码模板，表达式的值放在 rax 中，中间结果压栈。
+// 溢出、除以 0 等解释器会产生 BigInt 或错误的情况直接放弃本次执行（deopt），
+// 函数没有副作用，由解释器从头重新执行即可。
+
+// 函数被解释执行多少次、且参数和返回值一直是整数之后才编译
+constexpr uint32_t THRESHOLD = 1000;
+// 超过这个次数的 deopt 后放弃编译，一直由解释器执行
+constexpr uint32_t MAX_DEOPTS = 100;
+
+// 机器码的返回值，按 System V ABI 放在 rax:rdx 中
+struct Result {
+    int64_t value;
+    // 非 0 时 value 无效，需要回到解释器
+    int64_t deopt;
+};
+
+using Entry = Result (*)(const int64_t* args);
+
+// 一个函数编译后的机器码，位于单独映射的可执行内存中
+class Code {
+public:
+    ~Code();
+
+    Code(const Code&) = delete;
+    Code& operator=(const Code&) = delete;
+
+    Result run(const int64_t* args) const {
+        return _entry(args);
+    }
+
+    size_t arity() const {
+        return _arity;
+    }
+
+    // 入口守卫：编译时解析到的被调函数的绑定都没有变化
+    // 机器码内部不会重新绑定变量，所以只需要在从解释器进入时检查
+    bool valid() const;
+
+    size_t size() const {
+        return _size;
+    }
+private:
+    friend class Compiler;
+
+    Code() = default;
+
+    // 调用处的函数名在 env 中应当仍然绑定到 target
+    struct Binding {
+        object::Environment* env;
+        std::string name;
+        const object::Object* target;
+    };
+
+    void* _memory = nullptr;
+    size_t _size = 0;
+    Entry _entry = nullptr;
+    size_t _arity = 0;
+    std::vector<Binding> _bindings;
+    // 被调函数及其机器码需要和调用方活得一样久（不包括自身）
+    std::vector<std::shared_ptr<object::Object>> _callees;
+};
+
+// 当前平台是否支持（x86-64 Linux）
+bool supported();
+
+// 编译函数，不满足条件或平台不支持时返回 nullptr
+// 被调函数会一并编译并记录在它们自己的 tier 中
+std::shared_ptr<Code> compile(const object::Function* fn);
+
+} // namespace jit
+} // namespace autumn
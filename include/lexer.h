@@ -1,12 +1,15 @@
 #pragma once
 
+#include <string_view>
+
 #include "token.h"
 
 namespace autumn {
 
 class Lexer {
 public:
-    Lexer(const std::string& input);
+    // 不拷贝输入，input 在词法分析期间必须保持有效
+    Lexer(std::string_view input);
     Token next_token();
 private:
     void read_char();
@@ -18,7 +21,7 @@ private:
     std::string read_string();
     void skip_whitespace();
 private:
-    std::string _input;
+    std::string_view _input;
 
     char _ch = 0; // 当前读取的字符
     int _pos = 0; // 当前读取的字符位置
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+namespace autumn {
+
+// 按行读取文件描述符
+// 每次 read 一大块数据，行直接指向内部缓冲区，不做拷贝。
+// 返回的行不包含换行符，在下一次调用 next 之前有效。
+class LineReader {
+public:
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+
+    explicit LineReader(int fd, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    // 读到文件末尾或出错时返回 false；最后一行没有换行符时也会返回
+    bool next(std::string_view& line);
+private:
+    // 把未处理的数据移到缓冲区开头，再读入一块
+    bool fill();
+private:
+    int _fd;
+    size_t _chunk_size;
+    std::vector<char> _buffer;
+    // 未处理的数据为 [_begin, _end)
+    size_t _begin = 0;
+    size_t _end = 0;
+    bool _eof = false;
+};
+
+} // namespace autumn
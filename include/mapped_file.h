@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace autumn {
+
+// 只读映射整个文件，析构时解除映射
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 文件不存在或无法映射时为 false
+    bool ok() const {
+        return _ok;
+    }
+
+    std::string_view data() const {
+        return std::string_view(static_cast<const char*>(_addr), _size);
+    }
+private:
+    void* _addr = nullptr;
+    size_t _size = 0;
+    bool _ok = false;
+};
+
+} // namespace autumn
@@ -1,15 +1,31 @@
 #pragma once
 
+#include <charconv>
 #include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
+#include "bignum.h"
 #include "color.h"
 #include "program.h"
 #include "format.h"
+#include "span.h"
+#include "writer.h"
+#include "stats.h"
 
 namespace autumn {
+class Evaluator;
+
+namespace jit {
+class Code;
+}
+
+namespace closure {
+class Code;
+}
+
 namespace object {
 class Type {
 public:
@@ -19,11 +35,15 @@ public:
         STRING_OBJECT,
         ERROR_OBJECT,
         NULL_OBJECT,
-        RETURN_OBJECT,
         FUNCTION_OBJECT,
         BUILTIN_OBJECT,
         ARRAY_OBJECT,
         HASH_OBJECT,
+        INT_ARRAY_OBJECT,
+        BIGINT_OBJECT,
+        FLOAT_OBJECT,
+        // 类型个数，必须放在最后
+        TYPE_COUNT,
     };
 
     Type(TypeValue type) : _type(type) {
@@ -56,14 +76,28 @@ public:
 class Object {
 public:
 
-    Object(Type type) : _type(type) {}
+    Object(Type type) : _type(type) {
+        if (Stats::current != nullptr) {
+            ++Stats::current->objects[type.value()];
+        }
+    }
     virtual ~Object() {}
 
     const Type& type() const {
         return _type;
     }
 
-    virtual std::string inspect() const = 0;
+    std::string inspect() const {
+        std::string ret;
+        StringWriter out(ret);
+        do_inspect(out);
+        return ret;
+    }
+
+    // 直接写入 out，受 out 的颜色和截断设置影响，不产生中间字符串
+    void inspect(Writer& out) const {
+        do_inspect(out);
+    }
 
     template <typename T>
     const T* cast() const {
@@ -76,6 +110,8 @@ public:
     }
 
 protected:
+    virtual void do_inspect(Writer& out) const = 0;
+
     Type _type;
 };
 
@@ -89,25 +125,86 @@ extern std::shared_ptr<object::Object> False;
 
 class Integer : public Object, public Hasher {
 public:
-    Integer(int value) :
+    Integer(int64_t value) :
             Object(Type::INTEGER_OBJECT),
             _value(value) {
     }
 
-    std::string inspect() const override {
-        std::string ret = std::to_string(_value);
-        return color::light::yellow + ret + color::off;
+    int64_t value() const {
+        return _value;
+    }
+
+    size_t hash() const override {
+        return std::hash<int64_t>{}(_value);
     }
+protected:
+    void do_inspect(Writer& out) const override {
+        char buf[24];
+        auto result = std::to_chars(buf, buf + sizeof(buf), _value);
+        out.paint(color::light::yellow);
+        out.write(std::string_view(buf, result.ptr - buf));
+        out.paint(color::off);
+    }
+private:
+    int64_t _value = 0;
+};
 
-    int value() const {
+// 超出 int64_t 范围的整数
+// 运算结果能放进 int64_t 时总是使用 Integer，所以 BigInt 与 Integer 的值不会重叠
+class BigInt : public Object, public Hasher {
+public:
+    BigInt(Bignum&& value) :
+            Object(Type::BIGINT_OBJECT),
+            _value(std::move(value)) {
+    }
+
+    const Bignum& value() const {
         return _value;
     }
 
     size_t hash() const override {
-        return std::hash<int>{}(_value);
+        return _value.hash();
+    }
+protected:
+    void do_inspect(Writer& out) const override {
+        out.paint(color::light::yellow);
+        out.write(_value.to_string());
+        out.paint(color::off);
+    }
+private:
+    Bignum _value;
+};
+
+// 双精度浮点数，运算遵循 IEEE 754
+class Float : public Object, public Hasher {
+public:
+    Float(double value) :
+            Object(Type::FLOAT_OBJECT),
+            _value(value) {
+    }
+
+    double value() const {
+        return _value;
+    }
+
+    size_t hash() const override {
+        return std::hash<double>{}(_value);
+    }
+protected:
+    void do_inspect(Writer& out) const override {
+        // 最短的能还原出原值的表示，整数值补上 .0 以便和 Integer 区分
+        char buf[32];
+        auto result = std::to_chars(buf, buf + sizeof(buf), _value);
+        std::string_view text(buf, result.ptr - buf);
+        out.paint(color::light::yellow);
+        out.write(text);
+        if (text.find_first_of(".ein") == std::string_view::npos) {
+            out.write(".0");
+        }
+        out.paint(color::off);
     }
 private:
-    int _value = 0;
+    double _value = 0;
 };
 
 class Boolean : public Object, public Hasher {
@@ -117,11 +214,6 @@ public:
             _value(value) {
     }
 
-    std::string inspect() const override {
-        std::string ret = _value ? "true" : "false";
-        return color::light::yellow + ret + color::off;
-    }
-
     bool value() const {
         return _value;
     }
@@ -129,6 +221,12 @@ public:
     size_t hash() const override {
         return std::hash<bool>{}(_value);
     }
+protected:
+    void do_inspect(Writer& out) const override {
+        out.paint(color::light::yellow);
+        out.write(_value ? "true" : "false");
+        out.paint(color::off);
+    }
 private:
     bool _value = 0;
 };
@@ -140,20 +238,26 @@ public:
             _value(value) {
     }
 
-    std::string inspect() const override {
-        return format(R"("{}{}{}")",
-                color::green,
-                _value,
-                color::off) ;
-    }
-
     const std::string& value() const {
         return _value;
     }
 
+    // 原地替换内容，复用已有的内存，调用者需保证该字符串没有被共享
+    void assign(std::string_view value) {
+        _value.assign(value.data(), value.size());
+    }
+
     size_t hash() const override {
         return std::hash<std::string>{}(_value);
     }
+protected:
+    void do_inspect(Writer& out) const override {
+        out.put('"');
+        out.paint(color::green);
+        out.write(_value);
+        out.paint(color::off);
+        out.put('"');
+    }
 private:
     std::string _value;
 };
@@ -162,28 +266,12 @@ class Null : public Object {
 public:
     Null() : Object(Type::NULL_OBJECT) {
     }
-
-    std::string inspect() const override {
-        return color::light::light + "null" + color::off;
-    }
-};
-
-class ReturnValue: public Object {
-public:
-    ReturnValue(std::shared_ptr<Object>& value) :
-        Object(Type::RETURN_OBJECT),
-        _value(value) {
-    }
-
-    std::string inspect() const override {
-        return _value->inspect();
-    }
-
-    std::shared_ptr<Object>& value() {
-        return _value;
+protected:
+    void do_inspect(Writer& out) const override {
+        out.paint(color::light::light);
+        out.write("null");
+        out.paint(color::off);
     }
-private:
-    std::shared_ptr<Object> _value;
 };
 
 class Error : public Object {
@@ -192,19 +280,35 @@ public:
         Object(Type::ERROR_OBJECT),
         _message(message) {
     }
-
-    std::string inspect() const override {
-        return format("{}error:{} {}",
-                color::light::red,
-                color::off,
-                _message);
+    // 脚本调用 exit(status) 时返回的错误：像普通错误一样中断求值，由求值器记下退出码
+    Error(const std::string& message, int exit_status) :
+        Object(Type::ERROR_OBJECT),
+        _message(message),
+        _exit(true),
+        _exit_status(exit_status) {
     }
 
     const std::string& message() const {
         return _message;
     }
+    bool exit() const {
+        return _exit;
+    }
+    int exit_status() const {
+        return _exit_status;
+    }
+protected:
+    void do_inspect(Writer& out) const override {
+        out.paint(color::light::red);
+        out.write("error:");
+        out.paint(color::off);
+        out.put(' ');
+        out.write(_message);
+    }
 private:
     std::string _message;
+    bool _exit = false;
+    int _exit_status = 0;
 };
 
 class Environment;
@@ -213,7 +317,7 @@ public:
     Function(
             std::vector<std::shared_ptr<ast::Identifier>>& parameters,
             std::shared_ptr<ast::BlockStatment> body,
-            std::shared_ptr<Environment>& env) :
+            const std::shared_ptr<Environment>& env) :
                 Object(Type::FUNCTION_OBJECT),
                 _parameters(parameters),
                 _body(body),
@@ -228,53 +332,112 @@ public:
         return _body.get();
     }
 
-    std::string inspect() const override {
+    std::shared_ptr<Environment>& env() const {
+        return _env;
+    }
+
+    // 分层编译的状态，由求值器维护
+    struct Tier {
+        // 参数和返回值都是整数的解释执行次数
+        uint32_t calls = 0;
+        uint32_t deopts = 0;
+        // 出现过非整数的参数或返回值，或者不满足编译条件
+        bool rejected = false;
+        std::shared_ptr<jit::Code> code;
+    };
+
+    Tier& tier() const {
+        return _tier;
+    }
+
+    // AOT 编译生成的函数体，参数已经绑定在 env 中，设置后代替解释执行 body
+    using Native = std::shared_ptr<Object> (*)(
+            const Evaluator& evaluator,
+            const Function* self,
+            std::shared_ptr<Environment>& env);
+
+    Native native() const {
+        return _native;
+    }
+
+    void set_native(Native native) {
+        _native = native;
+    }
+
+    // 闭包后端转换好的函数体，同一个函数字面量创建的函数对象共享同一份
+    const std::shared_ptr<const closure::Code>& compiled() const {
+        return _compiled;
+    }
+
+    void set_compiled(const std::shared_ptr<const closure::Code>& compiled) {
+        _compiled = compiled;
+    }
+
+    // 调用帧不会被闭包引用，由求值器在帧栈上分配，函数返回后立即复用
+    bool stack_frame() const {
+        return _stack_frame;
+    }
+
+    void set_stack_frame(bool stack_frame) {
+        _stack_frame = stack_frame;
+    }
+protected:
+    void do_inspect(Writer& out) const override {
         if (_body == nullptr) {
-            return std::string();
+            return;
         }
 
-        std::string ret = "fn";
-
-        ret.append(1, '(');
+        out.paint(color::cyan);
+        out.write("fn(");
         for (size_t i = 0; i < _parameters.size(); ++i) {
             if (i != 0) {
-                ret.append(", ");
+                out.write(", ");
             }
-            ret.append(_parameters[i]->to_string());
+            out.write(_parameters[i]->to_string());
         }
-        ret.append(") { ");
-        ret.append(_body->to_string());
-        ret.append(" }");
-
-        return color::cyan + ret + color::off;
-    }
-
-    std::shared_ptr<Environment>& env() const {
-        return _env;
+        out.write(") { ");
+        out.write(_body->to_string());
+        out.write(" }");
+        out.paint(color::off);
     }
 private:
     std::vector<std::shared_ptr<ast::Identifier>> _parameters;
     std::shared_ptr<ast::BlockStatment> _body;
     mutable std::shared_ptr<Environment> _env;
+    mutable Tier _tier;
+    Native _native = nullptr;
+    std::shared_ptr<const closure::Code> _compiled;
+    bool _stack_frame = false;
 };
 
-using BuiltinFunction = std::function<std::shared_ptr<object::Object>(const std::vector<std::shared_ptr<object::Object>>&)>;
+// 函数调用的实参，指向调用方栈上的存储，不拥有其中的对象
+using Arguments = Span<const std::shared_ptr<Object>>;
+using BuiltinFunction = std::shared_ptr<object::Object> (*)(Arguments);
 
+// 内置函数对象在进程启动时创建好，之后只共享不再分配
 class Builtin : public Object {
 public:
-    Builtin(const BuiltinFunction& fn) :
+    Builtin(const std::string& name, BuiltinFunction fn) :
         Object(Type::BUILTIN_OBJECT),
+        _name(name),
         _fn(fn) {
     }
 
-    std::string inspect() const override {
-        return color::cyan + "builtin function" + color::off;
+    const std::string& name() const {
+        return _name;
     }
 
-    std::shared_ptr<Object> run(const std::vector<std::shared_ptr<Object>>& args) const {
+    std::shared_ptr<Object> run(Arguments args) const {
         return _fn(args);
     }
+protected:
+    void do_inspect(Writer& out) const override {
+        out.paint(color::cyan);
+        out.write("builtin function");
+        out.paint(color::off);
+    }
 private:
+    std::string _name;
     BuiltinFunction _fn;
 };
 
@@ -285,21 +448,13 @@ public:
         _elements(elements) {
     }
 
-    Array() :
-        Object(Type::ARRAY_OBJECT) {
+    Array(std::vector<std::shared_ptr<Object>>&& elements) :
+        Object(Type::ARRAY_OBJECT),
+        _elements(std::move(elements)) {
     }
 
-    std::string inspect() const override {
-        std::string ret;
-        ret.append(1, '[');
-        for (size_t i = 0; i < _elements.size(); ++i) {
-            if (i != 0) {
-                ret.append(", ");
-            }
-            ret.append(_elements[i]->inspect());
-        }
-        ret.append(1, ']');
-        return ret;
+    Array() :
+        Object(Type::ARRAY_OBJECT) {
     }
 
     const std::vector<std::shared_ptr<Object>>& elements() const {
@@ -309,10 +464,58 @@ public:
     void append(const std::shared_ptr<object::Object>& obj) {
         _elements.push_back(obj);
     }
+
+    // 原地修改元素，调用方负责保证数组没有被共享
+    std::shared_ptr<Object>& at(size_t index) {
+        return _elements[index];
+    }
+protected:
+    void do_inspect(Writer& out) const override {
+        out.sequence('[', ']', _elements.begin(), _elements.end(),
+                [](Writer& out, const std::shared_ptr<Object>& elem) {
+                    elem->inspect(out);
+                });
+    }
 private:
     std::vector<std::shared_ptr<Object>> _elements;
 };
 
+// 只包含整数的数组，元素不装箱，连续存放以便批量运算
+class IntArray : public Object {
+public:
+    explicit IntArray(std::vector<int64_t>&& values) :
+        Object(Type::INT_ARRAY_OBJECT),
+        _values(std::move(values)) {
+    }
+
+    IntArray(const std::vector<int64_t>& values) :
+        Object(Type::INT_ARRAY_OBJECT),
+        _values(values) {
+    }
+
+    const std::vector<int64_t>& values() const {
+        return _values;
+    }
+
+    // 原地修改元素，调用方负责保证数组没有被共享
+    std::vector<int64_t>& values() {
+        return _values;
+    }
+protected:
+    void do_inspect(Writer& out) const override {
+        out.sequence('[', ']', _values.begin(), _values.end(),
+                [](Writer& out, int64_t value) {
+                    char buf[24];
+                    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+                    out.paint(color::light::yellow);
+                    out.write(std::string_view(buf, result.ptr - buf));
+                    out.paint(color::off);
+                });
+    }
+private:
+    std::vector<int64_t> _values;
+};
+
 class Hash : public Object {
 public:
     using Pair = std::pair<std::shared_ptr<Object>, std::shared_ptr<Object>>;
@@ -326,23 +529,6 @@ public:
     Hash() : Object(Type::HASH_OBJECT) {
     }
 
-    std::string inspect() const override {
-        std::string ret;
-        ret.append(1, '{');
-        bool first = true;
-        for (auto& pair : _pairs) {
-            if (!first) {
-                ret.append(", ");
-            }
-            first = false;
-            ret.append(format("{}:{}",
-                    pair.second.first->inspect(),
-                    pair.second.second->inspect()));
-        }
-        ret.append(1, '}');
-        return ret;
-    }
-
     const Pairs& pairs() const {
         return _pairs;
     }
@@ -353,6 +539,10 @@ public:
             return constants::Null;
         }
 
+        if (Stats::current != nullptr) {
+            ++Stats::current->hash_probes;
+        }
+
         size_t hashcode = hasher->hash();
         auto it = _pairs.find(hashcode);
         if (it == _pairs.end()) {
@@ -368,9 +558,55 @@ public:
             return false;
         }
 
+        if (Stats::current != nullptr) {
+            ++Stats::current->hash_probes;
+        }
+
         _pairs.emplace(hasher->hash(), std::make_pair(key, value));
         return true;
     }
+
+    // 与 append 不同，已有的键会被覆盖
+    bool set(const std::shared_ptr<Object>& key, const std::shared_ptr<Object>& value) {
+        auto hasher = key->cast<Hasher>();
+        if (hasher == nullptr) {
+            return false;
+        }
+
+        if (Stats::current != nullptr) {
+            ++Stats::current->hash_probes;
+        }
+
+        _pairs[hasher->hash()] = std::make_pair(key, value);
+        return true;
+    }
+
+    // 原地修改键对应的值，键不存在时返回 nullptr
+    std::shared_ptr<Object>* find(const Object* key) {
+        auto hasher = key->cast<Hasher>();
+        if (hasher == nullptr) {
+            return nullptr;
+        }
+
+        if (Stats::current != nullptr) {
+            ++Stats::current->hash_probes;
+        }
+
+        auto it = _pairs.find(hasher->hash());
+        if (it == _pairs.end()) {
+            return nullptr;
+        }
+        return &it->second.second;
+    }
+protected:
+    void do_inspect(Writer& out) const override {
+        out.sequence('{', '}', _pairs.begin(), _pairs.end(),
+                [](Writer& out, const Pairs::value_type& pair) {
+                    pair.second.first->inspect(out);
+                    out.put(':');
+                    pair.second.second->inspect(out);
+                });
+    }
 private:
     Pairs _pairs;
 };
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "writer.h"
+
+namespace autumn {
+
+// 输出缓冲区
+// 求值器在求值期间把自己的 Output 挂到当前线程上（Output::current），puts 等内置函数
+// 把对象直接 inspect 到缓冲区中，缓冲区满、求值结束、调用 flush() 或 exit() 时才交给 sink 写出。
+class Output final : public Writer {
+public:
+    // 输出的去向，嵌入方可以换成自己的实现
+    using Sink = std::function<void(std::string_view)>;
+
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+    explicit Output(Sink sink = fd_sink(1), size_t capacity = DEFAULT_CAPACITY);
+    ~Output() override;
+
+    Output(const Output&) = delete;
+    Output& operator=(const Output&) = delete;
+
+    void write(std::string_view data) override {
+        if (_buffer.size() + data.size() > _capacity) {
+            flush();
+            // 比整个缓冲区还大的数据直接写出
+            if (data.size() >= _capacity) {
+                _sink(data);
+                return;
+            }
+        }
+        _buffer.append(data.data(), data.size());
+    }
+
+    void put(char ch) override {
+        if (_buffer.size() >= _capacity) {
+            flush();
+        }
+        _buffer.push_back(ch);
+    }
+
+    void flush();
+
+    // 更换 sink 之前先把已有的内容写到原来的去向
+    void set_sink(Sink sink);
+
+    // 写入文件描述符（处理 EINTR 和部分写入），不负责关闭
+    static Sink fd_sink(int fd);
+    // 追加到 target 末尾，target 的生命周期需长于 Output
+    static Sink string_sink(std::string& target);
+
+    // 当前线程上正在使用的 Output，为空时内置函数直接写 std::cout
+    static inline thread_local Output* current = nullptr;
+
+    // 在作用域内把 output 设为当前线程的输出
+    class Scope {
+    public:
+        explicit Scope(Output* output) : _prev(current) {
+            current = output;
+        }
+
+        ~Scope() {
+            current = _prev;
+        }
+    private:
+        Output* _prev;
+    };
+private:
+    Sink _sink;
+    size_t _capacity;
+    std::string _buffer;
+};
+
+} // namespace autumn
@@ -17,6 +17,7 @@ public:
     enum Precedence {
         UNKNOWN = 0,
         LOWEST,
+        ASSIGN, // =
         EQUALS, // ==
         LESSGREATER, // < or >
         SUM, // +
@@ -27,7 +28,7 @@ public:
     };
 public:
     Parser();
-    std::unique_ptr<ast::Program> parse(const std::string& input);
+    std::unique_ptr<ast::Program> parse(std::string_view input);
     const std::vector<std::string>& errors() const;
 private:
     void next_token();
@@ -52,6 +53,7 @@ private:
     // 注册函数
     std::unique_ptr<ast::Expression> parse_identifier();
     std::unique_ptr<ast::Expression> parse_integer_literal();
+    std::unique_ptr<ast::Expression> parse_float_literal();
     std::unique_ptr<ast::Expression> parse_string_literal();
     std::unique_ptr<ast::Expression> parse_boolean_literal();
     std::unique_ptr<ast::Expression> parse_function_literal();
@@ -60,9 +62,12 @@ private:
     std::unique_ptr<ast::Expression> parse_group_expression();
     std::unique_ptr<ast::Expression> parse_prefix_expression();
     std::unique_ptr<ast::Expression> parse_if_expression();
+    std::unique_ptr<ast::Expression> parse_while_expression();
+    std::unique_ptr<ast::Expression> parse_for_expression();
     std::unique_ptr<ast::Expression> parse_infix_expression(ast::Expression* left);
     std::unique_ptr<ast::Expression> parse_call_expression(ast::Expression* left);
     std::unique_ptr<ast::Expression> parse_index_expression(ast::Expression* left);
+    std::unique_ptr<ast::Expression> parse_assign_expression(ast::Expression* left);
 private:
     using PrefixParseFunc = std::function<std::unique_ptr<ast::Expression>()>;
     using InfixParseFunc = std::function<std::unique_ptr<ast::Expression>(ast::Expression* expression)>;
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace autumn {
+
+// 定长对象的分配器，释放的内存挂到当前线程的空闲链表上，下次分配直接复用
+// 配合 std::allocate_shared 使用，对象和控制块一起从链表中取，稳定后不再调用 malloc
+// 只缓存单个对象的分配，每个线程每种类型最多缓存 MAX_FREE 块
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    static constexpr size_t MAX_FREE = 4096;
+
+    PoolAllocator() = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) {
+    }
+
+    T* allocate(size_t n) {
+        if (n != 1 || destroyed()) {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        auto& list = free_list();
+        if (list.head != nullptr) {
+            Node* node = list.head;
+            list.head = node->next;
+            --list.size;
+            return reinterpret_cast<T*>(node);
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        // 线程退出时链表可能已经析构（比如全局对象在 thread_local 之后析构），此时直接释放
+        if (n != 1 || destroyed()) {
+            ::operator delete(p);
+            return;
+        }
+        auto& list = free_list();
+        if (list.size >= MAX_FREE) {
+            ::operator delete(p);
+            return;
+        }
+        Node* node = reinterpret_cast<Node*>(p);
+        node->next = list.head;
+        list.head = node;
+        ++list.size;
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>&) const {
+        return false;
+    }
+private:
+    struct Node {
+        Node* next;
+    };
+
+    static_assert(sizeof(T) >= sizeof(Node), "object too small for PoolAllocator");
+
+    struct FreeList {
+        Node* head = nullptr;
+        size_t size = 0;
+
+        ~FreeList() {
+            destroyed() = true;
+            while (head != nullptr) {
+                Node* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    };
+
+    static FreeList& free_list() {
+        static thread_local FreeList list;
+        return list;
+    }
+
+    // 链表是否已经析构，不能记在链表自己身上：析构之后再读它的成员是未定义行为
+    // bool 可平凡析构，整个线程的生命周期内都可以读取
+    static bool& destroyed() {
+        static thread_local bool flag = false;
+        return flag;
+    }
+};
+
+} // namespace autumn
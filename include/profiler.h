@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace autumn {
+
+// 采样分析器
+// 求值器在进入/离开函数调用时维护一份逻辑调用栈，后台线程按固定间隔对它采样，
+// 最后以 flamegraph.pl 可读的折叠栈（collapsed stack）格式输出。
+class Profiler {
+public:
+    // 超过这个深度的栈帧不再记录，只记录深度
+    static constexpr size_t MAX_DEPTH = 256;
+
+    explicit Profiler(std::chrono::microseconds interval);
+    ~Profiler();
+
+    void start();
+    void stop();
+
+    void enter(const std::string& frame);
+    void leave();
+
+    // 每行一个调用栈：frame1;frame2;frame3 count
+    // 需要在求值线程中调用（栈帧名字表只在求值线程中维护）
+    void write_collapsed(std::ostream& out) const;
+
+    size_t samples() const;
+
+    // 在作用域内压入一个栈帧，profiler 为空时什么也不做
+    class Scope {
+    public:
+        Scope(Profiler* profiler, const std::string& frame) : _profiler(profiler) {
+            if (_profiler != nullptr) {
+                _profiler->enter(frame);
+            }
+        }
+
+        ~Scope() {
+            if (_profiler != nullptr) {
+                _profiler->leave();
+            }
+        }
+    private:
+        Profiler* _profiler;
+    };
+private:
+    uint32_t intern(const std::string& frame);
+    void sample();
+    void run();
+private:
+    std::chrono::microseconds _interval;
+
+    // 求值线程写，采样线程读
+    std::array<std::atomic<uint32_t>, MAX_DEPTH> _frames;
+    std::atomic<size_t> _depth{0};
+
+    // 只在求值线程中访问
+    std::unordered_map<std::string, uint32_t> _ids;
+    std::vector<std::string> _names;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _cv;
+    std::map<std::vector<uint32_t>, size_t> _stacks;
+    size_t _samples = 0;
+    bool _running = false;
+    std::thread _thread;
+};
+
+} // namespace autumn
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -11,6 +15,18 @@ namespace autumn {
 
 class Parser;
 
+namespace cache {
+class Decoder;
+}
+
+namespace scope {
+class Resolver;
+}
+
+namespace object {
+class Object;
+}
+
 namespace ast {
 
 
@@ -43,6 +59,10 @@ public:
         return _token.literal;
     }
 
+    const Token& token() const {
+        return _token;
+    }
+
 protected:
     Token _token;
 };
@@ -58,6 +78,10 @@ public:
         return _token.literal;
     }
 
+    const Token& token() const {
+        return _token;
+    }
+
 protected:
     Token _token;
 };
@@ -65,6 +89,9 @@ protected:
 // 标识符
 class Identifier : public Expression {
 public:
+    friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
+    friend class autumn::scope::Resolver;
     Identifier(const Token& token, const std::string& value) :
             Expression(token), _value(value) {
     }
@@ -77,27 +104,87 @@ public:
         return _value;
     }
 
+    // 同名内置函数的下标，解析时确定；没有同名内置函数时为 -1
+    int builtin() const {
+        return _builtin;
+    }
+
+    // 不在任何外层函数中绑定，只能是全局变量或内置函数，由 scope::Resolver 标记
+    bool global() const {
+        return _global;
+    }
+
+    // 全局变量的内联缓存：全局环境的版本号不变时，变量仍在上次找到的位置
+    // slot 为空表示全局环境中没有这个变量。缓存不是线程安全的，并行执行的求值器不使用
+    struct Cache {
+        uint64_t version = 0;
+        std::shared_ptr<object::Object>* slot = nullptr;
+    };
+
+    Cache& cache() const {
+        return _cache;
+    }
+
+private:
+    void set_builtin(int index) {
+        _builtin = index;
+    }
 private:
     std::string _value;
+    int _builtin = -1;
+    mutable bool _global = false;
+    mutable Cache _cache;
 };
 
 class IntegerLiteral : public Expression {
 public:
     IntegerLiteral (const Token& token) :
             Expression(token) {
-        _value = std::stoi(token.literal);
+        auto& literal = token.literal;
+        auto result = std::from_chars(literal.data(), literal.data() + literal.size(), _value);
+        _overflow = result.ec == std::errc::result_out_of_range;
+    }
+
+    std::string to_string() const override {
+        return token_literal();
+    }
+
+    int64_t value() const {
+        return _value;
+    }
+
+    // 字面量超出 int64_t 的范围，求值时按大整数处理
+    bool overflow() const {
+        return _overflow;
+    }
+
+private:
+    int64_t _value = 0;
+    bool _overflow = false;
+};
+
+class FloatLiteral : public Expression {
+public:
+    FloatLiteral (const Token& token) :
+            Expression(token) {
+        auto& literal = token.literal;
+        auto result = std::from_chars(literal.data(), literal.data() + literal.size(), _value);
+        // 字面量没有负号和指数，只可能向上溢出
+        if (result.ec == std::errc::result_out_of_range) {
+            _value = std::numeric_limits<double>::infinity();
+        }
     }
 
     std::string to_string() const override {
         return token_literal();
     }
 
-    int value() const {
+    double value() const {
         return _value;
     }
 
 private:
-    int _value;
+    double _value = 0;
 };
 
 class StringLiteral : public Expression {
@@ -141,6 +228,7 @@ private:
 class PrefixExpression : public Expression {
 public:
     friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
     PrefixExpression(const Token& token) :
             Expression(token), _operator(token.literal) {
     }
@@ -171,8 +259,34 @@ private:
 class InfixExpression : public Expression {
 public:
     friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
+    // 运算符预先解析为枚举，求值时不再比较字符串
+    enum class Opcode : uint8_t {
+        ADD,
+        SUB,
+        MUL,
+        DIV,
+        LT,
+        LE,
+        GT,
+        GE,
+        EQ,
+        NE,
+        OTHER,
+    };
+
+    // 按第一次求值时的操作数类型特化节点，之后只需检查类型是否仍然相同
+    // 类型变化（守卫失败）后退回 GENERIC，不再特化
+    enum class Quick : uint8_t {
+        UNINITIALIZED,
+        GENERIC,
+        INTEGER,
+        FLOAT,
+        STRING,
+    };
+
     InfixExpression(const Token& token) :
-            Expression(token), _operator(token.literal) {
+            Expression(token), _operator(token.literal), _opcode(to_opcode(_operator)) {
     }
 
     std::string to_string() const override {
@@ -199,6 +313,19 @@ public:
     const Expression* right() const {
         return _right.get();
     }
+
+    Opcode opcode() const {
+        return _opcode;
+    }
+
+    // 并行内置函数会在多个线程中求值同一棵语法树，任何状态都是安全的（守卫总会检查类型）
+    Quick quick() const {
+        return _quick.load(std::memory_order_relaxed);
+    }
+
+    void quicken(Quick quick) const {
+        _quick.store(quick, std::memory_order_relaxed);
+    }
 private:
     void set_left(Expression* expression) {
         _left.reset(expression);
@@ -207,8 +334,35 @@ private:
     void set_right(Expression* expression) {
         _right.reset(expression);
     }
+
+    static Opcode to_opcode(const std::string& op) {
+        if (op == "+") {
+            return Opcode::ADD;
+        } else if (op == "-") {
+            return Opcode::SUB;
+        } else if (op == "*") {
+            return Opcode::MUL;
+        } else if (op == "/") {
+            return Opcode::DIV;
+        } else if (op == "<") {
+            return Opcode::LT;
+        } else if (op == "<=") {
+            return Opcode::LE;
+        } else if (op == ">") {
+            return Opcode::GT;
+        } else if (op == ">=") {
+            return Opcode::GE;
+        } else if (op == "==") {
+            return Opcode::EQ;
+        } else if (op == "!=") {
+            return Opcode::NE;
+        }
+        return Opcode::OTHER;
+    }
 private:
     std::string _operator;
+    Opcode _opcode;
+    mutable std::atomic<Quick> _quick{Quick::UNINITIALIZED};
     std::unique_ptr<Expression> _left;
     std::unique_ptr<Expression> _right;
 };
@@ -216,6 +370,7 @@ private:
 class BlockStatment : public Statment {
 public:
     friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
     using Statment::Statment;
     const std::vector<std::unique_ptr<Statment>>& statments() const {
         return _statments;
@@ -240,6 +395,7 @@ private:
 class IfExpression : public Expression {
 public:
     friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
     using Expression::Expression;
 
     const Expression* condition() const {
@@ -289,11 +445,163 @@ private:
     std::unique_ptr<BlockStatment> _alternative;
 };
 
+// while (condition) { body }
+class WhileExpression : public Expression {
+public:
+    friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
+    using Expression::Expression;
+
+    const Expression* condition() const {
+        return _condition.get();
+    }
+
+    const BlockStatment* body() const {
+        return _body.get();
+    }
+
+    std::string to_string() const override {
+        if (_condition == nullptr || _body == nullptr) {
+            return std::string();
+        }
+
+        return "while ("
+                + _condition->to_string()
+                + ") {"
+                + _body->to_string()
+                + "}";
+    }
+private:
+    void set_condition(Expression* condition) {
+        _condition.reset(condition);
+    }
+
+    void set_body(BlockStatment* body) {
+        _body.reset(body);
+    }
+private:
+    std::unique_ptr<Expression> _condition;
+    std::unique_ptr<BlockStatment> _body;
+};
+
+// for (variable in iterable) { body }
+class ForExpression : public Expression {
+public:
+    friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
+    using Expression::Expression;
+
+    const Identifier* variable() const {
+        return _variable.get();
+    }
+
+    const Expression* iterable() const {
+        return _iterable.get();
+    }
+
+    const BlockStatment* body() const {
+        return _body.get();
+    }
+
+    std::string to_string() const override {
+        if (_variable == nullptr || _iterable == nullptr || _body == nullptr) {
+            return std::string();
+        }
+
+        return "for ("
+                + _variable->to_string()
+                + " in "
+                + _iterable->to_string()
+                + ") {"
+                + _body->to_string()
+                + "}";
+    }
+private:
+    void set_variable(Identifier* variable) {
+        _variable.reset(variable);
+    }
+
+    void set_iterable(Expression* iterable) {
+        _iterable.reset(iterable);
+    }
+
+    void set_body(BlockStatment* body) {
+        _body.reset(body);
+    }
+private:
+    std::unique_ptr<Identifier> _variable;
+    std::unique_ptr<Expression> _iterable;
+    std::unique_ptr<BlockStatment> _body;
+};
+
+// target = value，重新绑定已经定义过的变量，或修改数组/哈希表中的元素
+// target 只能是 Identifier 或 IndexExpression
+class AssignExpression : public Expression {
+public:
+    friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
+    using Expression::Expression;
+
+    const Expression* target() const {
+        return _target.get();
+    }
+
+    const Expression* value() const {
+        return _value.get();
+    }
+
+    std::string to_string() const override {
+        if (_target == nullptr || _value == nullptr) {
+            return "()";
+        }
+        return "(" + _target->to_string() + " = " + _value->to_string() + ")";
+    }
+private:
+    void set_target(Expression* target) {
+        _target.reset(target);
+    }
+
+    void set_value(Expression* value) {
+        _value.reset(value);
+    }
+private:
+    std::unique_ptr<Expression> _target;
+    std::unique_ptr<Expression> _value;
+};
+
 class FunctionLiteral : public Expression {
 public:
     friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
+    friend class autumn::scope::Resolver;
     using Expression::Expression;
 
+    // 函数体中引用、由外层函数绑定的变量，创建函数对象时只捕获这些变量
+    struct Capture {
+        std::string name;
+        // 在外层函数中只绑定一次、从不重新赋值，可以按值复制
+        bool immutable;
+    };
+
+    // 是否经过了自由变量分析，没有分析过的字面量捕获整个环境链
+    bool resolved() const {
+        return _resolved;
+    }
+
+    const std::vector<Capture>& captures() const {
+        return _captures;
+    }
+
+    // let name = fn(...) { ... name(...) ... } 中函数通过 name 引用自身，绑定不可变时为 name
+    const std::string& self() const {
+        return _self;
+    }
+
+    // 函数体中创建的闭包会引用调用帧，没有分析过时总是认为会
+    bool escapes() const {
+        return _escapes;
+    }
+
     std::vector<std::shared_ptr<Identifier>>& parameters() const {
         return _parameters;
     }
@@ -337,11 +645,18 @@ private:
     // shared_ptr 的原因在于，这两个字段未来会被 object::Function 共享
     mutable std::vector<std::shared_ptr<Identifier>> _parameters;
     mutable std::shared_ptr<BlockStatment> _body;
+
+    // 分析结果在求值之前由 scope::Resolver 写入
+    mutable bool _resolved = false;
+    mutable std::vector<Capture> _captures;
+    mutable std::string _self;
+    mutable bool _escapes = true;
 };
 
 class CallExpression : public Expression {
 public:
     friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
     using Expression::Expression;
     
     const Expression* function() const {
@@ -386,6 +701,7 @@ private:
 class LetStatment : public Statment {
 public:
     friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
     using Statment::Statment;
 
     std::string token_literal() const override {
@@ -428,6 +744,7 @@ private:
 class ReturnStatment : public Statment {
 public:
     friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
     using Statment::Statment;
 
     const Expression* expression() const {
@@ -454,6 +771,7 @@ private:
 class ExpressionStatment : public Statment {
 public:
     friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
     using Statment::Statment;
     const Expression* expression() const {
         return _expression.get();
@@ -477,6 +795,7 @@ private:
 class ArrayLiteral : public Expression {
 public:
     friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
     using Expression::Expression;
 
     const std::vector<std::unique_ptr<Expression>>& elements() const {
@@ -508,6 +827,7 @@ private:
 class HashLiteral : public Expression {
 public:
     friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
     using Expression::Expression;
     using Pair = std::pair<std::unique_ptr<Expression>, std::unique_ptr<Expression>>;
     using Pairs = std::vector<Pair>;
@@ -549,6 +869,7 @@ private:
 class IndexExpression : public Expression {
 public:
     friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
     using Expression::Expression;
 
     const Expression* left() const {
@@ -586,6 +907,7 @@ private:
 class Program : public Node {
 public:
     friend class autumn::Parser;
+    friend class autumn::cache::Decoder;
     const std::vector<std::unique_ptr<Statment>>& statments() const {
         return _statments;
     }
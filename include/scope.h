@@ -0,0 +1,33 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "environment.h"
+#include "object.h"
+#include "program.h"
+
+namespace autumn {
+namespace scope {
+
+// 自由变量分析与扁平闭包
+// 分析在求值之前进行，为每个函数字面量记录它引用的、由外层函数绑定的变量。
+// 函数对象不再持有整条环境链，而是持有一个只包含这些变量的小环境，外层直接是全局环境：
+// 不可变的绑定按值复制；可变的绑定（重新赋值、在循环中绑定、多次绑定）无法复制，
+// 这时小环境的外层改为绑定它的最内层调用帧，仍然与原来的语义相同。
+
+// 分析整个程序，语法分析和读取缓存之后调用
+void resolve(const ast::Program& program);
+// 分析函数体中的字面量，外层为这个函数，堆快照恢复函数对象时调用
+void resolve(
+        const std::vector<std::shared_ptr<ast::Identifier>>& parameters,
+        const ast::BlockStatment& body);
+
+// 在 env 中对函数字面量求值，所有后端都通过它创建函数对象
+std::shared_ptr<object::Function> function(
+        const ast::FunctionLiteral* literal,
+        std::shared_ptr<object::Environment>& env);
+
+} // namespace scope
+} // namespace autumn
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace autumn {
+namespace simd {
+
+// IntArray 使用的批量整数运算
+// 运行时检测 CPU 特性，支持 AVX2 时使用向量化实现，否则退回标量实现。
+// 求和与乘法运算的结果按 64 位补码回绕，和 __builtin_add_overflow 一样返回是否溢出：
+// 返回 false 时结果是精确的；返回 true 时结果可能已经回绕，调用方需要改用大整数重新计算。
+enum class Isa {
+    SCALAR,
+    AVX2,
+};
+
+// 当前使用的实现
+Isa isa();
+// 切换实现（主要用于测试），CPU 不支持时返回 false 且不做任何改变
+bool set_isa(Isa isa);
+
+bool sum(const int64_t* data, size_t n, int64_t* out);
+// n 必须大于 0
+int64_t min(const int64_t* data, size_t n);
+int64_t max(const int64_t* data, size_t n);
+bool dot(const int64_t* a, const int64_t* b, size_t n, int64_t* out);
+
+// out[i] = a[i] op b[i]，out 可以与 a 或 b 相同
+bool add(const int64_t* a, const int64_t* b, int64_t* out, size_t n);
+bool mul(const int64_t* a, const int64_t* b, int64_t* out, size_t n);
+// out[i] = a[i] op b
+bool add(const int64_t* a, int64_t b, int64_t* out, size_t n);
+bool mul(const int64_t* a, int64_t b, int64_t* out, size_t n);
+
+// 把大于 threshold 的元素按原顺序写入 out，返回写入的个数
+// out 至少要能容纳 n 个元素
+size_t filter_gt(const int64_t* data, size_t n, int64_t threshold, int64_t* out);
+
+} // namespace simd
+} // namespace autumn
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace autumn {
+
+// 前 N 个元素存放在对象内部的向量，元素不多时不需要堆分配
+// 只提供求值器用到的接口
+template <typename T, size_t N>
+class SmallVector {
+public:
+    SmallVector() = default;
+
+    SmallVector(SmallVector&& other) {
+        if (other.is_inline()) {
+            for (size_t i = 0; i < other._size; ++i) {
+                new (_data + i) T(std::move(other._data[i]));
+            }
+            _size = other._size;
+            other.clear();
+        } else {
+            _data = other._data;
+            _size = other._size;
+            _capacity = other._capacity;
+            other._data = other.inline_data();
+            other._size = 0;
+            other._capacity = N;
+        }
+    }
+
+    SmallVector(const SmallVector&) = delete;
+    SmallVector& operator=(const SmallVector&) = delete;
+    SmallVector& operator=(SmallVector&&) = delete;
+
+    ~SmallVector() {
+        clear();
+        if (!is_inline()) {
+            ::operator delete(_data);
+        }
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (_size == _capacity) {
+            grow(_capacity * 2);
+        }
+        new (_data + _size) T(std::forward<Args>(args)...);
+        return _data[_size++];
+    }
+
+    void push_back(const T& value) {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+
+    void clear() {
+        for (size_t i = 0; i < _size; ++i) {
+            _data[i].~T();
+        }
+        _size = 0;
+    }
+
+    T* data() {
+        return _data;
+    }
+
+    const T* data() const {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    T& operator[](size_t i) {
+        return _data[i];
+    }
+
+    const T& operator[](size_t i) const {
+        return _data[i];
+    }
+
+    T* begin() {
+        return _data;
+    }
+
+    T* end() {
+        return _data + _size;
+    }
+
+    const T* begin() const {
+        return _data;
+    }
+
+    const T* end() const {
+        return _data + _size;
+    }
+
+    // 是否仍在使用内部存储
+    bool is_inline() const {
+        return _data == inline_data();
+    }
+private:
+    T* inline_data() {
+        return reinterpret_cast<T*>(_inline);
+    }
+
+    const T* inline_data() const {
+        return reinterpret_cast<const T*>(_inline);
+    }
+
+    void grow(size_t capacity) {
+        T* data = static_cast<T*>(::operator new(capacity * sizeof(T)));
+        for (size_t i = 0; i < _size; ++i) {
+            new (data + i) T(std::move(_data[i]));
+            _data[i].~T();
+        }
+        if (!is_inline()) {
+            ::operator delete(_data);
+        }
+        _data = data;
+        _capacity = capacity;
+    }
+private:
+    alignas(T) unsigned char _inline[N * sizeof(T)];
+    T* _data = inline_data();
+    size_t _size = 0;
+    size_t _capacity = N;
+};
+
+} // namespace autumn
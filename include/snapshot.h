@@ -0,0 +1,25 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "environment.h"
+
+namespace autumn {
+namespace snapshot {
+
+// 堆快照
+// 把一个环境以及从它可达的所有对象（包括闭包捕获的环境）写成与地址无关的镜像，
+// 对象之间的引用记为下标。恢复时 mmap 整个文件，按顺序重建对象并把下标换回指针，
+// 共享关系保持不变，不需要重新求值 let 定义。
+
+// 镜像格式变化时需要加一
+constexpr uint32_t VERSION = 1;
+
+// 遇到无法保存的对象时返回 false
+bool save(const std::string& path, const object::Environment& env);
+// 文件不存在、已损坏或版本不符时返回 nullptr
+std::shared_ptr<object::Environment> load(const std::string& path);
+
+} // namespace snapshot
+} // namespace autumn
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace autumn {
+
+// 连续内存的只读视图，类似 C++20 的 std::span
+template <typename T>
+class Span {
+public:
+    Span() = default;
+
+    Span(T* data, size_t size) :
+            _data(data), _size(size) {
+    }
+
+    // 任何提供 data()/size() 的连续容器，如 std::vector、SmallVector
+    template <typename Container,
+            typename = decltype(std::declval<Container&>().data()),
+            typename = decltype(std::declval<Container&>().size())>
+    Span(Container& container) :
+            _data(container.data()), _size(container.size()) {
+    }
+
+    T* data() const {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    T& operator[](size_t i) const {
+        return _data[i];
+    }
+
+    T& front() const {
+        return _data[0];
+    }
+
+    T& back() const {
+        return _data[_size - 1];
+    }
+
+    T* begin() const {
+        return _data;
+    }
+
+    T* end() const {
+        return _data + _size;
+    }
+private:
+    T* _data = nullptr;
+    size_t _size = 0;
+};
+
+} // namespace autumn
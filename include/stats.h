@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace autumn {
+
+// 运行时计数器
+// 求值器在求值期间把自己的 Stats 挂到当前线程上（Stats::current），
+// 对象、环境的构造函数以及求值器的热点路径直接在上面累加。
+struct Stats {
+    // 按 object::Type 统计分配的对象个数
+    static constexpr size_t MAX_OBJECT_TYPES = 32;
+    std::array<uint64_t, MAX_OBJECT_TYPES> objects{};
+
+    uint64_t environments = 0;
+    // Environment::get 在整条环境链上都没找到的次数
+    uint64_t env_misses = 0;
+    uint64_t calls = 0;
+    uint64_t builtin_calls = 0;
+    uint64_t max_depth = 0;
+    uint64_t hash_probes = 0;
+
+    // 当前调用深度，不对外输出
+    uint64_t depth = 0;
+
+    void reset() {
+        *this = Stats();
+    }
+
+    void merge(const Stats& other) {
+        for (size_t i = 0; i < objects.size(); ++i) {
+            objects[i] += other.objects[i];
+        }
+        environments += other.environments;
+        env_misses += other.env_misses;
+        calls += other.calls;
+        builtin_calls += other.builtin_calls;
+        max_depth = std::max(max_depth, depth + other.max_depth);
+        hash_probes += other.hash_probes;
+    }
+
+    // 当前线程上正在计数的 Stats，为空表示不计数
+    static inline thread_local Stats* current = nullptr;
+
+    // 在作用域内把 stats 设为当前线程的计数器
+    class Scope {
+    public:
+        explicit Scope(Stats* stats) : _prev(current) {
+            current = stats;
+        }
+
+        ~Scope() {
+            current = _prev;
+        }
+    private:
+        Stats* _prev;
+    };
+};
+
+} // namespace autumn
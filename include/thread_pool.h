@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace autumn {
+
+// 工作窃取线程池
+// 每个工作线程拥有自己的任务队列，从队尾取任务执行；
+// 自己的队列空了以后，从其它线程的队头窃取任务。
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    // 全局共享的线程池，线程数等于 CPU 核数
+    static ThreadPool& instance();
+
+    size_t size() const {
+        return _threads.size();
+    }
+
+    // 并行执行 fn(0), fn(1), ..., fn(n - 1)，阻塞直到全部完成
+    // 调用线程在等待期间也会参与执行任务，所以可以在任务内部嵌套调用
+    void parallel_for(size_t n, const std::function<void(size_t)>& fn);
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void push(size_t index, Task&& task);
+    bool pop(size_t index, Task& task);
+    bool steal(size_t index, Task& task);
+    bool try_run_one(size_t index);
+    void run(size_t index);
+private:
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _threads;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::atomic<size_t> _pending{0};
+    bool _stop = false;
+};
+
+} // namespace autumn
@@ -34,11 +34,15 @@ struct Token {
         IDENT,
         FUNCTION,
         INT,
+        FLOAT,
         TRUE,
         FALSE,
         IF,
         ELSE,
         RETURN,
+        WHILE,
+        FOR,
+        IN,
         STRING,
         END,
     };
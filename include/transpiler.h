@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+#include "program.h"
+
+namespace autumn {
+namespace aot {
+
+// 把程序翻译为 C++ 源码，链接 libautumn 后即可编译为独立的可执行文件
+// 语句和表达式展开为直线代码，省去解释器逐个节点的类型分派；
+// 只由整数参数、局部变量、整数运算、比较和对自身的调用组成的函数，
+// 额外生成一份直接使用 int64_t 的版本，参数都是整数时优先执行。
+// 所有定义放在命名空间 name 中，入口为 name::run，with_main 为 true 时同时生成 main 函数。
+std::string transpile(
+        const ast::Program& program,
+        const std::string& name = "script",
+        bool with_main = true);
+
+} // namespace aot
+} // namespace autumn
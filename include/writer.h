@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include "color.h"
+
+namespace autumn {
+
+// inspect 的输出目标
+// 对象直接把内容写进来，不再逐层拼接临时字符串。
+// 可以关闭颜色，也可以限制容器嵌套的深度和每个容器输出的元素个数，超出的部分以 ... 代替。
+class Writer {
+public:
+    static constexpr size_t UNLIMITED = std::numeric_limits<size_t>::max();
+
+    virtual ~Writer() {}
+
+    virtual void write(std::string_view data) = 0;
+
+    virtual void put(char ch) {
+        write(std::string_view(&ch, 1));
+    }
+
+    // 关闭颜色时什么都不写
+    void paint(const color::Color& c) {
+        if (_color) {
+            write(c.code());
+        }
+    }
+
+    bool color() const {
+        return _color;
+    }
+
+    void set_color(bool color) {
+        _color = color;
+    }
+
+    void set_max_depth(size_t max_depth) {
+        _max_depth = max_depth;
+    }
+
+    void set_max_length(size_t max_length) {
+        _max_length = max_length;
+    }
+
+    // 按 open a, b, ... close 的格式输出容器，fn(out, elem) 输出单个元素
+    template <typename Iterator, typename Fn>
+    void sequence(char open, char close, Iterator begin, Iterator end, Fn&& fn) {
+        put(open);
+        if (begin != end && _depth >= _max_depth) {
+            write("...");
+        } else if (begin != end) {
+            ++_depth;
+            size_t count = 0;
+            for (auto it = begin; it != end; ++it, ++count) {
+                if (count != 0) {
+                    write(", ");
+                }
+                if (count == _max_length) {
+                    write("...");
+                    break;
+                }
+                fn(*this, *it);
+            }
+            --_depth;
+        }
+        put(close);
+    }
+private:
+    bool _color = true;
+    size_t _max_depth = UNLIMITED;
+    size_t _max_length = UNLIMITED;
+    // 当前所在的容器层数
+    size_t _depth = 0;
+};
+
+// 追加到字符串末尾
+class StringWriter : public Writer {
+public:
+    explicit StringWriter(std::string& target) : _target(target) {
+    }
+
+    void write(std::string_view data) override {
+        _target.append(data.data(), data.size());
+    }
+
+    void put(char ch) override {
+        _target.push_back(ch);
+    }
+private:
+    std::string& _target;
+};
+
+} // namespace autumn
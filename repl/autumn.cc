@@ -1,12 +1,19 @@
+#include <cstdlib>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <map>
+#include <sstream>
 #include <stdio.h>
+#include <vector>
 
 #include "color.h"
 #include "lexer.h"
 #include "parser.h"
 #include "evaluator.h"
+#include "line_reader.h"
+#include "mapped_file.h"
+#include "transpiler.h"
 
 #include <readline/readline.h>
 #include <readline/history.h>
@@ -17,6 +24,12 @@ void lexer_repl(const std::string& line);
 void parser_repl(const std::string& line);
 void eval_repl(const std::string& line);
 void do_nothing(const std::string& line);
+bool profile_command(const std::string& line);
+void write_profile(const std::string& path);
+int quit();
+int run(int argc, char* argv[]);
+int stream(int argc, char* argv[]);
+int compile(int argc, char* argv[]);
 
 autumn::Evaluator evaluator;
 
@@ -34,24 +47,223 @@ int main(int argc, char* argv[]) {
             repl = it->second;
         }
     }
+
+    // AUTUMN_PROFILE=out.folded ./autumn eval，退出时把采样结果写入文件
+    if (getenv("AUTUMN_PROFILE") != nullptr) {
+        evaluator.start_profiler();
+    }
+
+    // ./autumn run file.atm [args...]，执行完脚本直接退出，不进入交互模式
+    if (argc > 1 && std::string(argv[1]) == "run") {
+        int status = run(argc - 2, argv + 2);
+        quit();
+        return status;
+    }
+
+    // ./autumn stream file.atm [function] < input，对每一行输入调用脚本中的函数
+    if (argc > 1 && std::string(argv[1]) == "stream") {
+        int status = stream(argc - 2, argv + 2);
+        quit();
+        return status;
+    }
+
+    // ./autumn compile file.atm -o file.cc，把脚本翻译为 C++，链接 libautumn 后得到独立的程序
+    if (argc > 1 && std::string(argv[1]) == "compile") {
+        return compile(argc - 2, argv + 2);
+    }
+
     std::string line;
     while (true) {
         char* ln = readline(PROMPT.c_str());
-        if (ln == nullptr) return 0;
+        if (ln == nullptr) return quit();
 
         line = ln;
         free(ln);
 
         if (!line.empty()) {
-            if (line == "q" || line == "quit") return 0;
-            repl(line);
+            if (line == "q" || line == "quit") return quit();
+            if (!profile_command(line)) {
+                repl(line);
+            }
             add_history(line.c_str());
+            // 交互模式下调用 exit(n) 也结束进程
+            if (evaluator.exit_requested()) {
+                quit();
+                return evaluator.exit_status();
+            }
+        }
+    }
+
+    return quit();
+}
+
+int quit() {
+    const char* path = getenv("AUTUMN_PROFILE");
+    if (path != nullptr && evaluator.profiling()) {
+        write_profile(path);
+    }
+    return 0;
+}
+
+// 整个文件作为一个程序求值，脚本中可以通过 args 读取命令行参数
+// 求值出错时退出码为 1，也可以在脚本中调用 exit(n) 指定退出码
+int run(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cerr << "usage: autumn run file.atm [args...]" << std::endl;
+        return 2;
+    }
+
+    std::vector<std::shared_ptr<autumn::object::Object>> args;
+    for (int i = 1; i < argc; ++i) {
+        args.push_back(std::make_shared<autumn::object::String>(argv[i]));
+    }
+    evaluator.define("args", std::make_shared<autumn::object::Array>(std::move(args)));
+
+    auto result = evaluator.eval_file(argv[0]);
+    if (evaluator.exit_requested()) {
+        return evaluator.exit_status();
+    }
+    if (result != nullptr && result->type() == autumn::object::Type::ERROR_OBJECT) {
+        std::cerr << result->inspect() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// 脚本只求值一次，之后对标准输入的每一行调用其中的函数（默认为 process），参数为该行内容
+// 函数返回字符串时原样输出，返回 null 时不输出，其它值输出 inspect 的结果
+// 输入按大块读取，行对象在没有被脚本保留时原地复用，输出同样写入大块缓冲区
+int stream(int argc, char* argv[]) {
+    if (argc < 1 || argc > 2) {
+        std::cerr << "usage: autumn stream file.atm [function] < input" << std::endl;
+        return 2;
+    }
+    std::string name = argc > 1 ? argv[1] : "process";
+
+    auto result = evaluator.eval_file(argv[0]);
+    if (evaluator.exit_requested()) {
+        return evaluator.exit_status();
+    }
+    if (result != nullptr && result->type() == autumn::object::Type::ERROR_OBJECT) {
+        std::cerr << result->inspect() << std::endl;
+        return 1;
+    }
+
+    auto fn = evaluator.lookup(name);
+    if (fn == nullptr || !(fn->type() == autumn::object::Type::FUNCTION_OBJECT
+            || fn->type() == autumn::object::Type::BUILTIN_OBJECT)) {
+        std::cerr << autumn::color::light::red
+            << "error: " << autumn::color::off
+            << "function " << name << " is not defined in " << argv[0] << std::endl;
+        return 1;
+    }
+
+    auto& output = evaluator.output();
+    autumn::LineReader reader(0);
+    std::string_view line;
+    std::shared_ptr<autumn::object::Object> record;
+    while (reader.next(line)) {
+        // 上一行的字符串被脚本保存起来时不能覆盖，重新分配一个
+        if (record != nullptr && record.use_count() == 1) {
+            static_cast<autumn::object::String*>(record.get())->assign(line);
+        } else {
+            record = std::make_shared<autumn::object::String>(std::string(line));
+        }
+
+        auto value = evaluator.call(fn.get(), autumn::object::Arguments(&record, 1));
+        if (evaluator.exit_requested()) {
+            output.flush();
+            return evaluator.exit_status();
+        }
+        switch (value->type().value()) {
+        case autumn::object::Type::STRING_OBJECT:
+            output.write(static_cast<const autumn::object::String*>(value.get())->value());
+            output.put('\n');
+            break;
+        case autumn::object::Type::NULL_OBJECT:
+            break;
+        case autumn::object::Type::ERROR_OBJECT:
+            output.flush();
+            std::cerr << value->inspect() << std::endl;
+            return 1;
+        default:
+            value->inspect(output);
+            output.put('\n');
+            break;
         }
     }
+    output.flush();
+    return 0;
+}
+
+// 生成的程序与 autumn run 执行同一个脚本的行为相同
+int compile(int argc, char* argv[]) {
+    if (argc != 3 || std::string(argv[1]) != "-o") {
+        std::cerr << "usage: autumn compile file.atm -o file.cc" << std::endl;
+        return 2;
+    }
+
+    autumn::MappedFile file(argv[0]);
+    if (!file.ok()) {
+        std::cerr << "cannot open file: " << argv[0] << std::endl;
+        return 1;
+    }
 
+    autumn::Parser parser;
+    auto program = parser.parse(file.data());
+    if (!parser.errors().empty()) {
+        for (auto& error : parser.errors()) {
+            std::cerr << error << std::endl;
+        }
+        return 1;
+    }
+
+    std::ofstream out(argv[2]);
+    out << autumn::aot::transpile(*program);
+    out.close();
+    if (!out) {
+        std::cerr << "cannot write file: " << argv[2] << std::endl;
+        return 1;
+    }
     return 0;
 }
 
+void write_profile(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << autumn::color::light::red
+            << "error: " << autumn::color::off
+            << "cannot open " << path << std::endl;
+        return;
+    }
+    evaluator.stop_profiler(out);
+}
+
+// :profile start          开始采样
+// :profile stop [file]    停止采样，把折叠栈输出到文件或标准输出
+bool profile_command(const std::string& line) {
+    std::istringstream in(line);
+    std::string command;
+    std::string action;
+    std::string path;
+    in >> command >> action >> path;
+
+    if (command != ":profile") {
+        return false;
+    }
+
+    if (action == "start") {
+        evaluator.start_profiler();
+    } else if (action == "stop" && path.empty()) {
+        evaluator.stop_profiler(std::cout);
+    } else if (action == "stop") {
+        write_profile(path);
+    } else {
+        std::cout << "usage: :profile start | :profile stop [file]" << std::endl;
+    }
+    return true;
+}
+
 void lexer_repl(const std::string& line) {
     autumn::Lexer lexer(line);
 
@@ -81,8 +293,15 @@ void eval_repl(const std::string& line) {
     if (obj == nullptr) {
         return;
     }
+    if (evaluator.exit_requested()) {
+        return;
+    }
 
-    std::cout << obj->inspect() << std::endl;
+    // 与 puts 的输出走同一个缓冲区，保证先后顺序
+    auto& output = evaluator.output();
+    obj->inspect(output);
+    output.put('\n');
+    output.flush();
 }
 
 void do_nothing(const std::string& line) {
@@ -0,0 +1,227 @@
+#include "aot.h"
+
+#include <iostream>
+
+#include "builtin.h"
+#include "cache.h"
+#include "pool.h"
+#include "scope.h"
+
+namespace autumn {
+namespace aot {
+
+namespace {
+
+void collect(const ast::Node* node, std::vector<const ast::FunctionLiteral*>& literals);
+
+void collect(const std::vector<std::unique_ptr<ast::Statment>>& statments,
+        std::vector<const ast::FunctionLiteral*>& literals) {
+    for (auto& stat : statments) {
+        collect(stat.get(), literals);
+    }
+}
+
+void collect(const std::vector<std::unique_ptr<ast::Expression>>& exps,
+        std::vector<const ast::FunctionLiteral*>& literals) {
+    for (auto& exp : exps) {
+        collect(exp.get(), literals);
+    }
+}
+
+void collect(const ast::Node* node, std::vector<const ast::FunctionLiteral*>& literals) {
+    if (node == nullptr) {
+        return;
+    }
+
+    if (auto n = node->cast<ast::Program>()) {
+        collect(n->statments(), literals);
+    } else if (auto n = node->cast<ast::BlockStatment>()) {
+        collect(n->statments(), literals);
+    } else if (auto n = node->cast<ast::ExpressionStatment>()) {
+        collect(n->expression(), literals);
+    } else if (auto n = node->cast<ast::LetStatment>()) {
+        collect(n->expression(), literals);
+    } else if (auto n = node->cast<ast::ReturnStatment>()) {
+        collect(n->expression(), literals);
+    } else if (auto n = node->cast<ast::PrefixExpression>()) {
+        collect(n->right(), literals);
+    } else if (auto n = node->cast<ast::InfixExpression>()) {
+        collect(n->left(), literals);
+        collect(n->right(), literals);
+    } else if (auto n = node->cast<ast::IfExpression>()) {
+        collect(n->condition(), literals);
+        collect(n->consequence(), literals);
+        collect(n->alternative(), literals);
+    } else if (auto n = node->cast<ast::WhileExpression>()) {
+        collect(n->condition(), literals);
+        collect(n->body(), literals);
+    } else if (auto n = node->cast<ast::ForExpression>()) {
+        collect(n->iterable(), literals);
+        collect(n->body(), literals);
+    } else if (auto n = node->cast<ast::AssignExpression>()) {
+        collect(n->target(), literals);
+        collect(n->value(), literals);
+    } else if (auto n = node->cast<ast::FunctionLiteral>()) {
+        literals.push_back(n);
+        collect(n->body().get(), literals);
+    } else if (auto n = node->cast<ast::CallExpression>()) {
+        collect(n->function(), literals);
+        collect(n->arguments(), literals);
+    } else if (auto n = node->cast<ast::ArrayLiteral>()) {
+        collect(n->elements(), literals);
+    } else if (auto n = node->cast<ast::HashLiteral>()) {
+        for (auto& pair : n->pairs()) {
+            collect(pair.first.get(), literals);
+            collect(pair.second.get(), literals);
+        }
+    } else if (auto n = node->cast<ast::IndexExpression>()) {
+        collect(n->left(), literals);
+        collect(n->index(), literals);
+    }
+}
+
+}
+
+Value Runtime::big_integer(std::string_view literal) {
+    Bignum value;
+    Bignum::parse(literal, value);
+    return std::make_shared<object::BigInt>(std::move(value));
+}
+
+Value Runtime::floating(double value) {
+    return std::allocate_shared<object::Float>(PoolAllocator<object::Float>(), value);
+}
+
+Value Runtime::identifier(Env& env, const std::string& name, int builtin) const {
+    auto val = env->get(name);
+    if (val != nullptr) {
+        return val;
+    }
+    if (builtin >= 0) {
+        return builtin::BUILTINS[builtin];
+    }
+    return done(_evaluator.new_error("identifier not found: {}`{}`{}",
+            color::light::light,
+            name,
+            color::off));
+}
+
+Value Runtime::prefix(const std::string& op, const Value& right, Env& env) const {
+    return done(_evaluator.eval_prefix_expression(op, right.get(), env));
+}
+
+Value Runtime::infix(const std::string& op, const Value& left, const Value& right, Env& env) const {
+    return done(_evaluator.eval_infix_expression(op, left.get(), right.get(), env));
+}
+
+Value Runtime::index(const Value& left, const Value& index) const {
+    return done(_evaluator.eval_index_expression(left.get(), index.get()));
+}
+
+Value Runtime::call(const std::string& frame, const Value& fn, object::Arguments args) const {
+    if (_evaluator._profiler != nullptr) {
+        Profiler::Scope scope(_evaluator._profiler.get(), frame);
+        return done(_evaluator.apply_function(fn.get(), args));
+    }
+    return done(_evaluator.apply_function(fn.get(), args));
+}
+
+Value Runtime::assign(Env& env, const std::string& name, const Value& val) const {
+    auto ret = _evaluator.assign(name, val, env);
+    if (ret != val) {
+        return done(std::move(ret));
+    }
+    return val;
+}
+
+Value Runtime::assign_index(
+        Env& env,
+        const std::string& name,
+        const std::vector<Value>& indexes,
+        const Value& val) const {
+    return done(_evaluator.assign_index(name, indexes, val, env));
+}
+
+Value Runtime::invalid_target(const std::string& target) const {
+    return done(_evaluator.new_error("invalid assignment target: {}`{}`{}",
+            color::light::light,
+            target,
+            color::off));
+}
+
+Value Runtime::not_iterable(const Value& iterable) const {
+    return done(_evaluator.new_error("for loop not supported: {}`{}`{}",
+            color::light::light,
+            iterable->type(),
+            color::off));
+}
+
+bool Runtime::integer_argument(const Env& env, const std::string& name, int64_t& out) {
+    auto& store = env->store();
+    auto it = store.find(name);
+    if (it == store.end() || it->second == nullptr
+            || typeid(*it->second) != typeid(object::Integer)) {
+        return false;
+    }
+    out = it->second->cast<object::Integer>()->value();
+    return true;
+}
+
+bool Runtime::bound_to(const Env& env, const std::string& name, const object::Object* target) {
+    auto slot = env->find(name);
+    return slot != nullptr && slot->get() == target;
+}
+
+Value Runtime::done(Value&& val) const {
+    _evaluator._signal = Evaluator::Signal::NONE;
+    return std::move(val);
+}
+
+std::vector<const ast::FunctionLiteral*> function_literals(const ast::Program& program) {
+    std::vector<const ast::FunctionLiteral*> literals;
+    collect(&program, literals);
+    return literals;
+}
+
+Module::Module(std::string_view encoded, std::vector<object::Function::Native> natives) :
+        _program(cache::decode(encoded)),
+        _natives(std::move(natives)) {
+    if (_program != nullptr) {
+        _literals = function_literals(*_program);
+    }
+    // 语法树与生成的代码一起编译进程序，对不上说明生成代码被改动过
+    if (_program == nullptr || _literals.size() != _natives.size()) {
+        std::cerr << "autumn: corrupted compiled module" << std::endl;
+        std::abort();
+    }
+}
+
+Value Module::function(size_t index, Env& env) const {
+    auto literal = _literals[index];
+    auto fn = scope::function(literal, env);
+    fn->set_native(_natives[index]);
+    return fn;
+}
+
+int main(int argc, char* argv[], Evaluator::Native program) {
+    Evaluator evaluator;
+
+    std::vector<Value> args;
+    for (int i = 1; i < argc; ++i) {
+        args.push_back(std::make_shared<object::String>(argv[i]));
+    }
+    evaluator.define("args", std::make_shared<object::Array>(std::move(args)));
+
+    auto result = evaluator.eval_native(program);
+    if (evaluator.exit_requested()) {
+        return evaluator.exit_status();
+    }
+    if (result != nullptr && result->type() == object::Type::ERROR_OBJECT) {
+        std::cerr << result->inspect() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace aot
+} // namespace autumn
@@ -0,0 +1,285 @@
+#include "bignum.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace autumn {
+
+namespace {
+
+constexpr uint64_t BASE = uint64_t(1) << 32;
+// to_string 每次取出 9 位十进制数
+constexpr uint32_t DECIMAL_CHUNK = 1000000000;
+
+void trim_digits(std::vector<uint32_t>& digits) {
+    while (!digits.empty() && digits.back() == 0) {
+        digits.pop_back();
+    }
+}
+
+}
+
+Bignum::Bignum(int64_t value) {
+    _negative = value < 0;
+    // 先转成无符号数再取反，INT64_MIN 也不会溢出
+    uint64_t magnitude = _negative ? ~uint64_t(value) + 1 : uint64_t(value);
+    while (magnitude != 0) {
+        _digits.push_back(uint32_t(magnitude));
+        magnitude >>= 32;
+    }
+}
+
+bool Bignum::parse(std::string_view text, Bignum& out) {
+    Bignum ret;
+    bool negative = false;
+    if (!text.empty() && text[0] == '-') {
+        negative = true;
+        text.remove_prefix(1);
+    }
+
+    if (text.empty()) {
+        return false;
+    }
+
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        mul_add_small(ret._digits, 10, c - '0');
+    }
+
+    ret._negative = negative;
+    ret.trim();
+    out = std::move(ret);
+    return true;
+}
+
+bool Bignum::fits_int64() const {
+    if (_digits.size() > 2) {
+        return false;
+    }
+
+    uint64_t magnitude = 0;
+    for (size_t i = _digits.size(); i > 0; --i) {
+        magnitude = (magnitude << 32) | _digits[i - 1];
+    }
+
+    uint64_t limit = uint64_t(std::numeric_limits<int64_t>::max());
+    return magnitude <= (_negative ? limit + 1 : limit);
+}
+
+int64_t Bignum::to_int64() const {
+    uint64_t magnitude = 0;
+    for (size_t i = std::min<size_t>(_digits.size(), 2); i > 0; --i) {
+        magnitude = (magnitude << 32) | _digits[i - 1];
+    }
+    return _negative ? int64_t(~magnitude + 1) : int64_t(magnitude);
+}
+
+double Bignum::to_double() const {
+    double ret = 0;
+    for (size_t i = _digits.size(); i > 0; --i) {
+        ret = ret * double(BASE) + _digits[i - 1];
+    }
+    return _negative ? -ret : ret;
+}
+
+std::string Bignum::to_string() const {
+    if (is_zero()) {
+        return "0";
+    }
+
+    Digits digits = _digits;
+    std::vector<uint32_t> chunks;
+    while (!digits.empty()) {
+        chunks.push_back(div_small(digits, DECIMAL_CHUNK));
+    }
+
+    std::string ret = _negative ? "-" : "";
+    ret.append(std::to_string(chunks.back()));
+    for (size_t i = chunks.size() - 1; i > 0; --i) {
+        std::string chunk = std::to_string(chunks[i - 1]);
+        ret.append(9 - chunk.size(), '0');
+        ret.append(chunk);
+    }
+    return ret;
+}
+
+size_t Bignum::hash() const {
+    size_t ret = _negative ? 1 : 0;
+    for (auto digit : _digits) {
+        ret = ret * 1099511628211ull ^ digit;
+    }
+    return ret;
+}
+
+Bignum Bignum::operator-() const {
+    Bignum ret = *this;
+    ret._negative = !_negative;
+    ret.trim();
+    return ret;
+}
+
+Bignum operator+(const Bignum& lhs, const Bignum& rhs) {
+    Bignum ret;
+    if (lhs._negative == rhs._negative) {
+        ret._digits = Bignum::add_magnitude(lhs._digits, rhs._digits);
+        ret._negative = lhs._negative;
+    } else if (Bignum::compare_magnitude(lhs._digits, rhs._digits) >= 0) {
+        ret._digits = Bignum::sub_magnitude(lhs._digits, rhs._digits);
+        ret._negative = lhs._negative;
+    } else {
+        ret._digits = Bignum::sub_magnitude(rhs._digits, lhs._digits);
+        ret._negative = rhs._negative;
+    }
+    ret.trim();
+    return ret;
+}
+
+Bignum operator-(const Bignum& lhs, const Bignum& rhs) {
+    return lhs + (-rhs);
+}
+
+Bignum operator*(const Bignum& lhs, const Bignum& rhs) {
+    Bignum ret;
+    ret._digits = Bignum::mul_magnitude(lhs._digits, rhs._digits);
+    ret._negative = lhs._negative != rhs._negative;
+    ret.trim();
+    return ret;
+}
+
+Bignum operator/(const Bignum& lhs, const Bignum& rhs) {
+    Bignum ret;
+    ret._digits = Bignum::div_magnitude(lhs._digits, rhs._digits);
+    ret._negative = lhs._negative != rhs._negative;
+    ret.trim();
+    return ret;
+}
+
+int compare(const Bignum& lhs, const Bignum& rhs) {
+    if (lhs._negative != rhs._negative) {
+        return lhs._negative ? -1 : 1;
+    }
+    int ret = Bignum::compare_magnitude(lhs._digits, rhs._digits);
+    return lhs._negative ? -ret : ret;
+}
+
+int Bignum::compare_magnitude(const Digits& lhs, const Digits& rhs) {
+    if (lhs.size() != rhs.size()) {
+        return lhs.size() < rhs.size() ? -1 : 1;
+    }
+    for (size_t i = lhs.size(); i > 0; --i) {
+        if (lhs[i - 1] != rhs[i - 1]) {
+            return lhs[i - 1] < rhs[i - 1] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+Bignum::Digits Bignum::add_magnitude(const Digits& lhs, const Digits& rhs) {
+    const Digits& longer = lhs.size() >= rhs.size() ? lhs : rhs;
+    const Digits& shorter = lhs.size() >= rhs.size() ? rhs : lhs;
+
+    Digits ret;
+    ret.reserve(longer.size() + 1);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < longer.size(); ++i) {
+        uint64_t sum = carry + longer[i] + (i < shorter.size() ? shorter[i] : 0);
+        ret.push_back(uint32_t(sum));
+        carry = sum >> 32;
+    }
+    if (carry != 0) {
+        ret.push_back(uint32_t(carry));
+    }
+    return ret;
+}
+
+Bignum::Digits Bignum::sub_magnitude(const Digits& lhs, const Digits& rhs) {
+    Digits ret;
+    ret.reserve(lhs.size());
+    int64_t borrow = 0;
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        int64_t diff = int64_t(lhs[i]) - borrow - (i < rhs.size() ? int64_t(rhs[i]) : 0);
+        borrow = diff < 0 ? 1 : 0;
+        ret.push_back(uint32_t(diff + (borrow ? BASE : 0)));
+    }
+    trim_digits(ret);
+    return ret;
+}
+
+Bignum::Digits Bignum::mul_magnitude(const Digits& lhs, const Digits& rhs) {
+    if (lhs.empty() || rhs.empty()) {
+        return {};
+    }
+
+    Digits ret(lhs.size() + rhs.size(), 0);
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < rhs.size(); ++j) {
+            uint64_t cur = uint64_t(lhs[i]) * rhs[j] + ret[i + j] + carry;
+            ret[i + j] = uint32_t(cur);
+            carry = cur >> 32;
+        }
+        ret[i + rhs.size()] = uint32_t(carry);
+    }
+    trim_digits(ret);
+    return ret;
+}
+
+Bignum::Digits Bignum::div_magnitude(const Digits& lhs, const Digits& rhs) {
+    if (compare_magnitude(lhs, rhs) < 0) {
+        return {};
+    }
+
+    if (rhs.size() == 1) {
+        Digits ret = lhs;
+        div_small(ret, rhs[0]);
+        return ret;
+    }
+
+    // 按位做长除法，余数始终小于除数
+    Digits quotient(lhs.size(), 0);
+    Digits remainder;
+    for (size_t bit = lhs.size() * 32; bit > 0; --bit) {
+        size_t i = bit - 1;
+        mul_add_small(remainder, 2, (lhs[i / 32] >> (i % 32)) & 1);
+        if (compare_magnitude(remainder, rhs) >= 0) {
+            remainder = sub_magnitude(remainder, rhs);
+            quotient[i / 32] |= uint32_t(1) << (i % 32);
+        }
+    }
+    trim_digits(quotient);
+    return quotient;
+}
+
+void Bignum::mul_add_small(Digits& digits, uint32_t mul, uint32_t add) {
+    uint64_t carry = add;
+    for (auto& digit : digits) {
+        uint64_t cur = uint64_t(digit) * mul + carry;
+        digit = uint32_t(cur);
+        carry = cur >> 32;
+    }
+    if (carry != 0) {
+        digits.push_back(uint32_t(carry));
+    }
+}
+
+uint32_t Bignum::div_small(Digits& digits, uint32_t div) {
+    uint64_t remainder = 0;
+    for (size_t i = digits.size(); i > 0; --i) {
+        uint64_t cur = (remainder << 32) | digits[i - 1];
+        digits[i - 1] = uint32_t(cur / div);
+        remainder = cur % div;
+    }
+    trim_digits(digits);
+    return uint32_t(remainder);
+}
+
+void Bignum::trim() {
+    trim_digits(_digits);
+    if (_digits.empty()) {
+        _negative = false;
+    }
+}
+
+} // namespace autumn
@@ -1,19 +1,224 @@
 #include "builtin.h"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "bignum.h"
+#include "evaluator.h"
 #include "format.h"
+#include "output.h"
+#include "simd.h"
+#include "thread_pool.h"
 
 namespace autumn {
 namespace builtin {
 
-std::map<std::string, object::BuiltinFunction> BUILTINS = {
-    {"len", len},
-    {"first", first},
-    {"last", last},
-    {"push", push},
-    {"rest", rest},
-    {"puts", puts},
+namespace {
+
+// 每个分块最少包含的元素个数，太小的数组直接在当前线程执行
+constexpr size_t MIN_CHUNK_SIZE = 1024;
+
+size_t chunk_count(size_t n) {
+    size_t chunks = std::min(n / MIN_CHUNK_SIZE, ThreadPool::instance().size() * 4);
+    return std::max<size_t>(chunks, 1);
+}
+
+// 把 [0, n) 均分为 chunks 块，fn(evaluator, chunk, begin, end) 在各块上并行执行
+template <typename Fn>
+void for_each_chunk(size_t n, size_t chunks, Fn&& fn) {
+    // 各分块的计数先记在自己的 Stats 上，结束后合并回调用方
+    auto parent = Stats::current;
+    std::vector<Stats> local(chunks);
+    // 各分块的输出先收集起来，结束后按分块顺序写到调用方的输出中；
+    // 调用方已经缓冲的内容先写出，保证出现在分块的输出之前
+    auto output = Output::current;
+    if (output != nullptr) {
+        output->flush();
+    }
+    std::vector<std::string> texts(chunks);
+
+    auto task = [&](size_t i) {
+        Stats::Scope scope(parent != nullptr ? &local[i] : nullptr);
+        // 分块之间共享闭包捕获的环境和全局环境，只允许修改分块自己创建的环境
+        object::Environment::OwnerScope owner(object::Environment::next_owner());
+        // 每个分块使用独立的求值上下文
+        // 分层编译的状态保存在函数对象上，内联缓存保存在语法树上，都不是线程安全的，
+        // 并行执行时只解释执行，也不使用内联缓存
+        Evaluator evaluator;
+        evaluator.set_jit(false);
+        evaluator.set_inline_caches(false);
+        evaluator.output().set_sink(Output::string_sink(texts[i]));
+        fn(evaluator, i, n * i / chunks, n * (i + 1) / chunks);
+    };
+
+    if (chunks == 1) {
+        task(0);
+    } else {
+        ThreadPool::instance().parallel_for(chunks, task);
+    }
+
+    if (parent != nullptr) {
+        for (auto& stats : local) {
+            parent->merge(stats);
+        }
+    }
+
+    for (auto& text : texts) {
+        if (output != nullptr) {
+            output->write(text);
+        } else {
+            std::cout << text;
+        }
+    }
+}
+
+bool is_callable(const object::Object* obj) {
+    return typeid(*obj) == typeid(object::Function)
+        || typeid(*obj) == typeid(object::Builtin);
+}
+
+bool is_error(const std::shared_ptr<object::Object>& obj) {
+    return obj->type() == object::Type::ERROR_OBJECT;
+}
+
+// 检查 pmap/pfilter/preduce 的参数：第一个是数组，第二个是函数
+std::shared_ptr<object::Object> check_parallel_args(
+        const char* name,
+        object::Arguments args,
+        size_t expect) {
+    if (args.size() != expect) {
+        return std::make_shared<object::Error>(format("wrong number of arguments. expected {}, got {}", expect, args.size()));
+    }
+
+    if (typeid(*args[0]) != typeid(object::Array) && typeid(*args[0]) != typeid(object::IntArray)) {
+        return std::make_shared<object::Error>(format("argument to `{}` not supported, got {}", name, args[0]->type()));
+    }
+
+    if (!is_callable(args[1].get())) {
+        return std::make_shared<object::Error>(format("argument to `{}` must be FUNCTION, got {}", name, args[1]->type()));
+    }
+    return nullptr;
+}
+
+// 并行内置函数的输入：Array 直接使用元素，IntArray 的元素在各分块中用到时才装箱
+class Elements {
+public:
+    explicit Elements(const object::Object* obj) {
+        if (typeid(*obj) == typeid(object::IntArray)) {
+            _ints = &obj->cast<object::IntArray>()->values();
+        } else {
+            _objects = &obj->cast<object::Array>()->elements();
+        }
+    }
+
+    size_t size() const {
+        return _ints != nullptr ? _ints->size() : _objects->size();
+    }
+
+    std::shared_ptr<object::Object> operator[](size_t i) const {
+        if (_ints != nullptr) {
+            return std::make_shared<object::Integer>((*_ints)[i]);
+        }
+        return (*_objects)[i];
+    }
+
+    // 输入不是 IntArray 时为空
+    const std::vector<int64_t>* ints() const {
+        return _ints;
+    }
+private:
+    const std::vector<std::shared_ptr<object::Object>>* _objects = nullptr;
+    const std::vector<int64_t>* _ints = nullptr;
+};
+
+// 返回下标最小的分块错误，保证和顺序执行时报告的错误一致
+std::shared_ptr<object::Object> first_error(const std::vector<std::shared_ptr<object::Object>>& errors) {
+    for (auto& error : errors) {
+        if (error != nullptr) {
+            return error;
+        }
+    }
+    return nullptr;
+}
+
+// 以整数序列的方式读取 IntArray 或只包含整数的 Array，Array 的内容会被拷贝到 storage 中
+// 其它情况返回 nullptr
+const std::vector<int64_t>* int_values(const object::Object* obj, std::vector<int64_t>& storage) {
+    if (typeid(*obj) == typeid(object::IntArray)) {
+        return &obj->cast<object::IntArray>()->values();
+    }
+
+    if (typeid(*obj) != typeid(object::Array)) {
+        return nullptr;
+    }
+
+    auto& elems = obj->cast<object::Array>()->elements();
+    storage.clear();
+    storage.reserve(elems.size());
+    for (auto& e : elems) {
+        if (typeid(*e) != typeid(object::Integer)) {
+            return nullptr;
+        }
+        storage.push_back(e->cast<object::Integer>()->value());
+    }
+    return &storage;
+}
+
+std::shared_ptr<object::Object> make_integer(Bignum&& value) {
+    if (value.fits_int64()) {
+        return std::make_shared<object::Integer>(value.to_int64());
+    }
+    return std::make_shared<object::BigInt>(std::move(value));
+}
+
+std::shared_ptr<object::Object> int_values_error(const char* name, const object::Object* obj) {
+    return std::make_shared<object::Error>(format("argument to `{}` must be INT_ARRAY or ARRAY of INTEGER, got {}", name, obj->type()));
+}
+
+}
+
+const std::vector<std::shared_ptr<object::Object>> BUILTINS = {
+    std::make_shared<object::Builtin>("len", len),
+    std::make_shared<object::Builtin>("first", first),
+    std::make_shared<object::Builtin>("last", last),
+    std::make_shared<object::Builtin>("push", push),
+    std::make_shared<object::Builtin>("rest", rest),
+    std::make_shared<object::Builtin>("puts", puts),
+    std::make_shared<object::Builtin>("pmap", pmap),
+    std::make_shared<object::Builtin>("pfilter", pfilter),
+    std::make_shared<object::Builtin>("preduce", preduce),
+    std::make_shared<object::Builtin>("stats", stats),
+    std::make_shared<object::Builtin>("int_array", int_array),
+    std::make_shared<object::Builtin>("sum", sum),
+    std::make_shared<object::Builtin>("min", min),
+    std::make_shared<object::Builtin>("max", max),
+    std::make_shared<object::Builtin>("dot", dot),
+    std::make_shared<object::Builtin>("filter_gt", filter_gt),
+    std::make_shared<object::Builtin>("exit", exit),
+    std::make_shared<object::Builtin>("flush", flush),
 };
 
-std::shared_ptr<object::Object> len(const std::vector<std::shared_ptr<object::Object>>& args) {
+int lookup(const std::string& name) {
+    static const std::unordered_map<std::string, int> indexes = [] {
+        std::unordered_map<std::string, int> indexes;
+        for (size_t i = 0; i < BUILTINS.size(); ++i) {
+            indexes.emplace(BUILTINS[i]->cast<object::Builtin>()->name(), i);
+        }
+        return indexes;
+    }();
+
+    auto it = indexes.find(name);
+    if (it == indexes.end()) {
+        return -1;
+    }
+    return it->second;
+}
+
+std::shared_ptr<object::Object> len(object::Arguments args) {
     if (args.size() != 1) {
         return std::make_shared<object::Error>(format("wrong number of arguments. expected 1, got {}", args.size()));
     }
@@ -26,11 +231,14 @@ std::shared_ptr<object::Object> len(const std::vector<std::shared_ptr<object::Ob
     } else if (typeid(*arg) == typeid(object::Array)) {
         auto obj = arg->cast<object::Array>();
         return std::make_shared<object::Integer>(obj->elements().size());
+    } else if (typeid(*arg) == typeid(object::IntArray)) {
+        auto obj = arg->cast<object::IntArray>();
+        return std::make_shared<object::Integer>(obj->values().size());
     }
     return std::make_shared<object::Error>(format("argument to `len` not supported, got {}", arg->type()));
 }
 
-std::shared_ptr<object::Object> first(const std::vector<std::shared_ptr<object::Object>>& args) {
+std::shared_ptr<object::Object> first(object::Arguments args) {
     if (args.size() != 1) {
         return std::make_shared<object::Error>(format("wrong number of arguments. expected 1, got {}", args.size()));
     }
@@ -43,11 +251,17 @@ std::shared_ptr<object::Object> first(const std::vector<std::shared_ptr<object::
             return object::constants::Null;
         }
         return obj->elements().front();
+    } else if (typeid(*arg) == typeid(object::IntArray)) {
+        auto obj = arg->cast<object::IntArray>();
+        if (obj->values().empty()) {
+            return object::constants::Null;
+        }
+        return std::make_shared<object::Integer>(obj->values().front());
     }
     return std::make_shared<object::Error>(format("argument to `front` not supported, got {}", arg->type()));
 }
 
-std::shared_ptr<object::Object> last(const std::vector<std::shared_ptr<object::Object>>& args) {
+std::shared_ptr<object::Object> last(object::Arguments args) {
     if (args.size() != 1) {
         return std::make_shared<object::Error>(format("wrong number of arguments. expected 1, got {}", args.size()));
     }
@@ -60,11 +274,17 @@ std::shared_ptr<object::Object> last(const std::vector<std::shared_ptr<object::O
             return object::constants::Null;
         }
         return obj->elements().back();
+    } else if (typeid(*arg) == typeid(object::IntArray)) {
+        auto obj = arg->cast<object::IntArray>();
+        if (obj->values().empty()) {
+            return object::constants::Null;
+        }
+        return std::make_shared<object::Integer>(obj->values().back());
     }
     return std::make_shared<object::Error>(format("argument to `last` not supported, got {}", arg->type()));
 }
 
-std::shared_ptr<object::Object> push(const std::vector<std::shared_ptr<object::Object>>& args) {
+std::shared_ptr<object::Object> push(object::Arguments args) {
     if (args.size() != 2) {
         return std::make_shared<object::Error>(format("wrong number of arguments. expected 2, got {}", args.size()));
     }
@@ -77,11 +297,27 @@ std::shared_ptr<object::Object> push(const std::vector<std::shared_ptr<object::O
         auto new_obj = std::make_shared<object::Array>(obj->elements());
         new_obj->append(arg1);
         return new_obj;
+    } else if (typeid(*arg0) == typeid(object::IntArray)) {
+        auto& values = arg0->cast<object::IntArray>()->values();
+        if (typeid(*arg1) == typeid(object::Integer)) {
+            auto new_obj = std::make_shared<object::IntArray>(values);
+            new_obj->values().push_back(arg1->cast<object::Integer>()->value());
+            return new_obj;
+        }
+
+        // 放入非整数元素时退化为普通数组
+        std::vector<std::shared_ptr<object::Object>> elems;
+        elems.reserve(values.size() + 1);
+        for (auto v : values) {
+            elems.push_back(std::make_shared<object::Integer>(v));
+        }
+        elems.push_back(arg1);
+        return std::make_shared<object::Array>(std::move(elems));
     }
     return std::make_shared<object::Error>(format("argument to `push` not supported, got {}", arg0->type()));
 }
 
-std::shared_ptr<object::Object> rest(const std::vector<std::shared_ptr<object::Object>>& args) {
+std::shared_ptr<object::Object> rest(object::Arguments args) {
     if (args.size() != 1) {
         return std::make_shared<object::Error>(format("wrong number of arguments. expected 1, got {}", args.size()));
     }
@@ -103,16 +339,387 @@ std::shared_ptr<object::Object> rest(const std::vector<std::shared_ptr<object::O
             first = false;
         }
         return new_obj;
+    } else if (typeid(*arg) == typeid(object::IntArray)) {
+        auto& values = arg->cast<object::IntArray>()->values();
+        if (values.empty()) {
+            return object::constants::Null;
+        }
+        return std::make_shared<object::IntArray>(
+                std::vector<int64_t>(values.begin() + 1, values.end()));
     }
     return std::make_shared<object::Error>(format("argument to `push` not supported, got {}", arg->type()));
 }
 
-std::shared_ptr<object::Object> puts(const std::vector<std::shared_ptr<object::Object>>& args) {
+std::shared_ptr<object::Object> puts(object::Arguments args) {
+    auto output = Output::current;
     for (auto& e : args) {
-        std::cout << e->inspect() << std::endl;
+        // 不在求值器中调用（比如嵌入方直接调用内置函数）时退回到 std::cout
+        if (output == nullptr) {
+            std::cout << e->inspect() << '\n';
+            continue;
+        }
+        e->inspect(*output);
+        output->put('\n');
+    }
+    return object::constants::Null;
+}
+
+std::shared_ptr<object::Object> flush(object::Arguments args) {
+    if (args.size() != 0) {
+        return std::make_shared<object::Error>(format("wrong number of arguments. expected 0, got {}", args.size()));
     }
+
+    if (Output::current != nullptr) {
+        Output::current->flush();
+    }
+    std::cout.flush();
     return object::constants::Null;
 }
 
+std::shared_ptr<object::Object> exit(object::Arguments args) {
+    if (args.size() > 1) {
+        return std::make_shared<object::Error>(format("wrong number of arguments. expected 0 or 1, got {}", args.size()));
+    }
+
+    int64_t status = 0;
+    if (args.size() == 1) {
+        if (typeid(*args[0]) != typeid(object::Integer)) {
+            return std::make_shared<object::Error>(format("argument to `exit` must be INTEGER, got {}", args[0]->type()));
+        }
+        status = args[0]->cast<object::Integer>()->value();
+    }
+
+    // 不在库里结束进程：返回的错误让求值一路中断到最外层（包括并行分块），
+    // 由求值器记下退出码，宿主程序决定如何退出
+    return std::make_shared<object::Error>(format("exit with status {}", status), int(status));
+}
+
+std::shared_ptr<object::Object> pmap(object::Arguments args) {
+    if (auto error = check_parallel_args("pmap", args, 2)) {
+        return error;
+    }
+
+    Elements elems(args[0].get());
+    auto fn = args[1].get();
+
+    size_t n = elems.size();
+    size_t chunks = chunk_count(n);
+    std::vector<std::shared_ptr<object::Object>> results(n);
+    std::vector<std::shared_ptr<object::Object>> errors(chunks);
+
+    for_each_chunk(n, chunks, [&](Evaluator& evaluator, size_t chunk, size_t begin, size_t end) {
+        std::array<std::shared_ptr<object::Object>, 1> call_args;
+        for (size_t i = begin; i < end; ++i) {
+            call_args[0] = elems[i];
+            auto val = evaluator.call(fn, call_args);
+            if (is_error(val)) {
+                errors[chunk] = val;
+                return;
+            }
+            results[i] = val;
+        }
+    });
+
+    if (auto error = first_error(errors)) {
+        return error;
+    }
+    return std::make_shared<object::Array>(std::move(results));
+}
+
+std::shared_ptr<object::Object> pfilter(object::Arguments args) {
+    if (auto error = check_parallel_args("pfilter", args, 2)) {
+        return error;
+    }
+
+    Elements elems(args[0].get());
+    auto fn = args[1].get();
+
+    size_t n = elems.size();
+    size_t chunks = chunk_count(n);
+    // 各分块保留下来的元素下标
+    std::vector<std::vector<size_t>> kept(chunks);
+    std::vector<std::shared_ptr<object::Object>> errors(chunks);
+
+    for_each_chunk(n, chunks, [&](Evaluator& evaluator, size_t chunk, size_t begin, size_t end) {
+        std::array<std::shared_ptr<object::Object>, 1> call_args;
+        for (size_t i = begin; i < end; ++i) {
+            call_args[0] = elems[i];
+            auto val = evaluator.call(fn, call_args);
+            if (is_error(val)) {
+                errors[chunk] = val;
+                return;
+            }
+            if (evaluator.is_truthy(val.get())) {
+                kept[chunk].push_back(i);
+            }
+        }
+    });
+
+    if (auto error = first_error(errors)) {
+        return error;
+    }
+
+    // IntArray 过滤后仍然是 IntArray
+    if (auto ints = elems.ints()) {
+        std::vector<int64_t> values;
+        for (auto& part : kept) {
+            for (auto i : part) {
+                values.push_back((*ints)[i]);
+            }
+        }
+        return std::make_shared<object::IntArray>(std::move(values));
+    }
+
+    auto& objects = args[0]->cast<object::Array>()->elements();
+    std::vector<std::shared_ptr<object::Object>> results;
+    for (auto& part : kept) {
+        for (auto i : part) {
+            results.push_back(objects[i]);
+        }
+    }
+    return std::make_shared<object::Array>(std::move(results));
+}
+
+std::shared_ptr<object::Object> preduce(object::Arguments args) {
+    if (args.size() != 3 && args.size() != 4) {
+        return std::make_shared<object::Error>(format("wrong number of arguments. expected 3 or 4, got {}", args.size()));
+    }
+    if (auto error = check_parallel_args("preduce", args, args.size())) {
+        return error;
+    }
+    // 第 4 个参数是合并函数，或者表示 fn 满足结合律、可以直接用来合并的 true
+    const object::Object* combine = nullptr;
+    if (args.size() == 4) {
+        if (is_callable(args[3].get())) {
+            combine = args[3].get();
+        } else if (typeid(*args[3]) == typeid(object::Boolean)) {
+            combine = args[3]->cast<object::Boolean>()->value() ? args[1].get() : nullptr;
+        } else {
+            return std::make_shared<object::Error>(format("argument to `preduce` must be FUNCTION or BOOLEAN, got {}", args[3]->type()));
+        }
+    }
+
+    Elements elems(args[0].get());
+    auto fn = args[1].get();
+
+    size_t n = elems.size();
+    // fn 的参数是 (acc, elem)，分块结果不能再交给它合并；没有 combine 时只能顺序归约
+    size_t chunks = combine != nullptr ? chunk_count(n) : 1;
+    std::vector<std::shared_ptr<object::Object>> partials(chunks);
+    std::vector<std::shared_ptr<object::Object>> errors(chunks);
+
+    // 每个分块都从 init 开始归约，最后用 combine 按顺序合并各块结果
+    for_each_chunk(n, chunks, [&](Evaluator& evaluator, size_t chunk, size_t begin, size_t end) {
+        std::array<std::shared_ptr<object::Object>, 2> call_args;
+        auto acc = args[2];
+        for (size_t i = begin; i < end; ++i) {
+            call_args[0] = acc;
+            call_args[1] = elems[i];
+            acc = evaluator.call(fn, call_args);
+            if (is_error(acc)) {
+                errors[chunk] = acc;
+                return;
+            }
+        }
+        partials[chunk] = acc;
+    });
+
+    if (auto error = first_error(errors)) {
+        return error;
+    }
+
+    auto acc = partials[0];
+    if (chunks > 1) {
+        // 合并也写到调用方的输出中，位于各分块的输出之后
+        Evaluator evaluator;
+        if (auto output = Output::current) {
+            evaluator.output().set_sink([output](std::string_view data) {
+                output->write(data);
+            });
+        }
+        std::array<std::shared_ptr<object::Object>, 2> call_args;
+        for (size_t i = 1; i < chunks; ++i) {
+            call_args[0] = acc;
+            call_args[1] = partials[i];
+            acc = evaluator.call(combine, call_args);
+            if (is_error(acc)) {
+                return acc;
+            }
+        }
+    }
+    return acc;
+}
+
+std::shared_ptr<object::Object> stats(object::Arguments args) {
+    if (args.size() != 0) {
+        return std::make_shared<object::Error>(format("wrong number of arguments. expected 0, got {}", args.size()));
+    }
+
+    // 先拷贝一份，避免构造结果时产生的对象计入本次输出
+    Stats snapshot = Stats::current != nullptr ? *Stats::current : Stats();
+
+    auto field = [](const char* name) {
+        return std::make_shared<object::String>(name);
+    };
+    auto value = [](uint64_t v) {
+        return std::make_shared<object::Integer>(v);
+    };
+
+    auto objects = std::make_shared<object::Hash>();
+    for (int i = 0; i < object::Type::TYPE_COUNT; ++i) {
+        object::Type type(static_cast<object::Type::TypeValue>(i));
+        objects->append(std::make_shared<object::String>(format("{}", type)), value(snapshot.objects[i]));
+    }
+
+    auto ret = std::make_shared<object::Hash>();
+    ret->append(field("objects"), objects);
+    ret->append(field("environments"), value(snapshot.environments));
+    ret->append(field("env_misses"), value(snapshot.env_misses));
+    ret->append(field("calls"), value(snapshot.calls));
+    ret->append(field("builtin_calls"), value(snapshot.builtin_calls));
+    ret->append(field("max_depth"), value(snapshot.max_depth));
+    ret->append(field("hash_probes"), value(snapshot.hash_probes));
+    return ret;
+}
+
+std::shared_ptr<object::Object> int_array(object::Arguments args) {
+    if (args.size() != 1) {
+        return std::make_shared<object::Error>(format("wrong number of arguments. expected 1, got {}", args.size()));
+    }
+
+    auto& arg = args[0];
+
+    if (typeid(*arg) == typeid(object::IntArray)) {
+        return arg;
+    } else if (typeid(*arg) == typeid(object::Integer)) {
+        auto n = arg->cast<object::Integer>()->value();
+        if (n < 0) {
+            return std::make_shared<object::Error>(format("argument to `int_array` must be non-negative, got {}", n));
+        }
+        // 分配失败时返回错误，不让异常结束整个解释器
+        std::vector<int64_t> values;
+        try {
+            values.resize(n);
+        } catch (const std::bad_alloc&) {
+            return std::make_shared<object::Error>(format("argument to `int_array` too large, got {}", n));
+        } catch (const std::length_error&) {
+            return std::make_shared<object::Error>(format("argument to `int_array` too large, got {}", n));
+        }
+        return std::make_shared<object::IntArray>(std::move(values));
+    } else if (typeid(*arg) == typeid(object::Array)) {
+        std::vector<int64_t> values;
+        if (int_values(arg.get(), values) == nullptr) {
+            return int_values_error("int_array", arg.get());
+        }
+        return std::make_shared<object::IntArray>(std::move(values));
+    }
+    return std::make_shared<object::Error>(format("argument to `int_array` not supported, got {}", arg->type()));
+}
+
+std::shared_ptr<object::Object> sum(object::Arguments args) {
+    if (args.size() != 1) {
+        return std::make_shared<object::Error>(format("wrong number of arguments. expected 1, got {}", args.size()));
+    }
+
+    std::vector<int64_t> storage;
+    auto values = int_values(args[0].get(), storage);
+    if (values == nullptr) {
+        return int_values_error("sum", args[0].get());
+    }
+    int64_t result;
+    if (!simd::sum(values->data(), values->size(), &result)) {
+        return std::make_shared<object::Integer>(result);
+    }
+    // 溢出时和整数运算一样改用大整数
+    Bignum total;
+    for (auto v : *values) {
+        total = total + Bignum(v);
+    }
+    return make_integer(std::move(total));
+}
+
+std::shared_ptr<object::Object> min(object::Arguments args) {
+    if (args.size() != 1) {
+        return std::make_shared<object::Error>(format("wrong number of arguments. expected 1, got {}", args.size()));
+    }
+
+    std::vector<int64_t> storage;
+    auto values = int_values(args[0].get(), storage);
+    if (values == nullptr) {
+        return int_values_error("min", args[0].get());
+    }
+    if (values->empty()) {
+        return object::constants::Null;
+    }
+    return std::make_shared<object::Integer>(simd::min(values->data(), values->size()));
+}
+
+std::shared_ptr<object::Object> max(object::Arguments args) {
+    if (args.size() != 1) {
+        return std::make_shared<object::Error>(format("wrong number of arguments. expected 1, got {}", args.size()));
+    }
+
+    std::vector<int64_t> storage;
+    auto values = int_values(args[0].get(), storage);
+    if (values == nullptr) {
+        return int_values_error("max", args[0].get());
+    }
+    if (values->empty()) {
+        return object::constants::Null;
+    }
+    return std::make_shared<object::Integer>(simd::max(values->data(), values->size()));
+}
+
+std::shared_ptr<object::Object> dot(object::Arguments args) {
+    if (args.size() != 2) {
+        return std::make_shared<object::Error>(format("wrong number of arguments. expected 2, got {}", args.size()));
+    }
+
+    std::vector<int64_t> storage0;
+    std::vector<int64_t> storage1;
+    auto a = int_values(args[0].get(), storage0);
+    if (a == nullptr) {
+        return int_values_error("dot", args[0].get());
+    }
+    auto b = int_values(args[1].get(), storage1);
+    if (b == nullptr) {
+        return int_values_error("dot", args[1].get());
+    }
+    if (a->size() != b->size()) {
+        return std::make_shared<object::Error>(format("arguments to `dot` must have the same length, got {} and {}", a->size(), b->size()));
+    }
+    int64_t result;
+    if (!simd::dot(a->data(), b->data(), a->size(), &result)) {
+        return std::make_shared<object::Integer>(result);
+    }
+    Bignum total;
+    for (size_t i = 0; i < a->size(); ++i) {
+        total = total + Bignum((*a)[i]) * Bignum((*b)[i]);
+    }
+    return make_integer(std::move(total));
+}
+
+std::shared_ptr<object::Object> filter_gt(object::Arguments args) {
+    if (args.size() != 2) {
+        return std::make_shared<object::Error>(format("wrong number of arguments. expected 2, got {}", args.size()));
+    }
+
+    std::vector<int64_t> storage;
+    auto values = int_values(args[0].get(), storage);
+    if (values == nullptr) {
+        return int_values_error("filter_gt", args[0].get());
+    }
+    if (typeid(*args[1]) != typeid(object::Integer)) {
+        return std::make_shared<object::Error>(format("argument to `filter_gt` must be INTEGER, got {}", args[1]->type()));
+    }
+
+    auto threshold = args[1]->cast<object::Integer>()->value();
+    std::vector<int64_t> result(values->size());
+    size_t n = simd::filter_gt(values->data(), values->size(), threshold, result.data());
+    result.resize(n);
+    return std::make_shared<object::IntArray>(std::move(result));
+}
+
+
 } // namespace builtin
 } // namespace autumn
@@ -0,0 +1,624 @@
+#include "cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <typeinfo>
+
+#include <unistd.h>
+
+#include "builtin.h"
+#include "mapped_file.h"
+#include "scope.h"
+
+namespace autumn {
+namespace cache {
+
+namespace {
+
+const char MAGIC[4] = {'A', 'T', 'M', 'C'};
+
+// 缓存只在本机使用，按本机字节序直接存放
+struct Header {
+    char magic[4];
+    uint32_t version;
+    // 源码指纹
+    uint64_t source;
+    uint64_t payload_size;
+    // 负载的指纹，用来发现被截断或损坏的文件
+    uint64_t payload;
+};
+
+// 节点类型标记，NIL 表示空指针
+enum Tag : uint8_t {
+    NIL = 0,
+    PROGRAM,
+    LET,
+    RETURN,
+    EXPRESSION_STATMENT,
+    BLOCK,
+    IDENTIFIER,
+    INTEGER,
+    FLOAT,
+    STRING,
+    BOOLEAN,
+    PREFIX,
+    INFIX,
+    IF,
+    WHILE,
+    FOR,
+    ASSIGN,
+    FUNCTION,
+    CALL,
+    ARRAY,
+    HASH,
+    INDEX,
+};
+
+// 按前序遍历写出节点：标记、记号、子节点
+class Encoder {
+public:
+    std::string release() {
+        return std::move(_out);
+    }
+
+    void program(const ast::Program& program) {
+        tag(PROGRAM);
+        statments(program.statments());
+    }
+
+    void function(
+            const std::vector<std::shared_ptr<ast::Identifier>>& parameters,
+            const ast::BlockStatment& body) {
+        tag(FUNCTION);
+        u32(parameters.size());
+        for (auto& parameter : parameters) {
+            name(parameter.get());
+        }
+        block(&body);
+    }
+private:
+    void tag(Tag t) {
+        _out.push_back(char(t));
+    }
+
+    void u32(uint32_t value) {
+        _out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void token(const Token& token) {
+        _out.push_back(char(token.type));
+        u32(token.literal.size());
+        _out.append(token.literal);
+    }
+
+    void statments(const std::vector<std::unique_ptr<ast::Statment>>& statments) {
+        u32(statments.size());
+        for (auto& stmt : statments) {
+            statment(stmt.get());
+        }
+    }
+
+    void expressions(const std::vector<std::unique_ptr<ast::Expression>>& exps) {
+        u32(exps.size());
+        for (auto& exp : exps) {
+            expression(exp.get());
+        }
+    }
+
+    void block(const ast::BlockStatment* block) {
+        if (block == nullptr) {
+            tag(NIL);
+            return;
+        }
+        tag(BLOCK);
+        token(block->token());
+        statments(block->statments());
+    }
+
+    // let、形参、for 的循环变量只是名字，不需要标记
+    void name(const ast::Identifier* identifier) {
+        token(identifier->token());
+    }
+
+    void statment(const ast::Statment* node) {
+        if (node == nullptr) {
+            tag(NIL);
+        } else if (typeid(*node) == typeid(ast::LetStatment)) {
+            auto n = node->cast<ast::LetStatment>();
+            tag(LET);
+            token(n->token());
+            name(n->identifier());
+            expression(n->expression());
+        } else if (typeid(*node) == typeid(ast::ReturnStatment)) {
+            auto n = node->cast<ast::ReturnStatment>();
+            tag(RETURN);
+            token(n->token());
+            expression(n->expression());
+        } else if (typeid(*node) == typeid(ast::ExpressionStatment)) {
+            auto n = node->cast<ast::ExpressionStatment>();
+            tag(EXPRESSION_STATMENT);
+            token(n->token());
+            expression(n->expression());
+        } else {
+            block(node->cast<ast::BlockStatment>());
+        }
+    }
+
+    void expression(const ast::Expression* node) {
+        if (node == nullptr) {
+            tag(NIL);
+        } else if (typeid(*node) == typeid(ast::Identifier)) {
+            tag(IDENTIFIER);
+            token(node->token());
+        } else if (typeid(*node) == typeid(ast::IntegerLiteral)) {
+            tag(INTEGER);
+            token(node->token());
+        } else if (typeid(*node) == typeid(ast::FloatLiteral)) {
+            tag(FLOAT);
+            token(node->token());
+        } else if (typeid(*node) == typeid(ast::StringLiteral)) {
+            tag(STRING);
+            token(node->token());
+        } else if (typeid(*node) == typeid(ast::BooleanLiteral)) {
+            tag(BOOLEAN);
+            token(node->token());
+        } else if (typeid(*node) == typeid(ast::PrefixExpression)) {
+            auto n = node->cast<ast::PrefixExpression>();
+            tag(PREFIX);
+            token(n->token());
+            expression(n->right());
+        } else if (typeid(*node) == typeid(ast::InfixExpression)) {
+            auto n = node->cast<ast::InfixExpression>();
+            tag(INFIX);
+            token(n->token());
+            expression(n->left());
+            expression(n->right());
+        } else if (typeid(*node) == typeid(ast::IfExpression)) {
+            auto n = node->cast<ast::IfExpression>();
+            tag(IF);
+            token(n->token());
+            expression(n->condition());
+            block(n->consequence());
+            block(n->alternative());
+        } else if (typeid(*node) == typeid(ast::WhileExpression)) {
+            auto n = node->cast<ast::WhileExpression>();
+            tag(WHILE);
+            token(n->token());
+            expression(n->condition());
+            block(n->body());
+        } else if (typeid(*node) == typeid(ast::ForExpression)) {
+            auto n = node->cast<ast::ForExpression>();
+            tag(FOR);
+            token(n->token());
+            name(n->variable());
+            expression(n->iterable());
+            block(n->body());
+        } else if (typeid(*node) == typeid(ast::AssignExpression)) {
+            auto n = node->cast<ast::AssignExpression>();
+            tag(ASSIGN);
+            token(n->token());
+            expression(n->target());
+            expression(n->value());
+        } else if (typeid(*node) == typeid(ast::FunctionLiteral)) {
+            auto n = node->cast<ast::FunctionLiteral>();
+            tag(FUNCTION);
+            token(n->token());
+            u32(n->parameters().size());
+            for (auto& parameter : n->parameters()) {
+                name(parameter.get());
+            }
+            block(n->body().get());
+        } else if (typeid(*node) == typeid(ast::CallExpression)) {
+            auto n = node->cast<ast::CallExpression>();
+            tag(CALL);
+            token(n->token());
+            expression(n->function());
+            expressions(n->arguments());
+        } else if (typeid(*node) == typeid(ast::ArrayLiteral)) {
+            auto n = node->cast<ast::ArrayLiteral>();
+            tag(ARRAY);
+            token(n->token());
+            expressions(n->elements());
+        } else if (typeid(*node) == typeid(ast::HashLiteral)) {
+            auto n = node->cast<ast::HashLiteral>();
+            tag(HASH);
+            token(n->token());
+            u32(n->pairs().size());
+            for (auto& pair : n->pairs()) {
+                expression(pair.first.get());
+                expression(pair.second.get());
+            }
+        } else if (typeid(*node) == typeid(ast::IndexExpression)) {
+            auto n = node->cast<ast::IndexExpression>();
+            tag(INDEX);
+            token(n->token());
+            expression(n->left());
+            expression(n->index());
+        } else {
+            tag(NIL);
+        }
+    }
+private:
+    std::string _out;
+};
+
+} // namespace
+
+// 与 Encoder 对应，读到非法数据时 _ok 置为 false，之后的读取都返回空值
+class Decoder {
+public:
+    explicit Decoder(std::string_view data) : _data(data) {
+    }
+
+    std::unique_ptr<ast::Program> program() {
+        if (tag() != PROGRAM) {
+            return nullptr;
+        }
+        std::unique_ptr<ast::Program> ret(new ast::Program);
+        uint32_t count = u32();
+        for (uint32_t i = 0; _ok && i < count; ++i) {
+            ret->append(statment().release());
+        }
+        // 解码完成后不应该有剩余数据
+        if (!_ok || _pos != _data.size()) {
+            return nullptr;
+        }
+        return ret;
+    }
+
+    bool function(
+            std::vector<std::shared_ptr<ast::Identifier>>& parameters,
+            std::shared_ptr<ast::BlockStatment>& body) {
+        if (tag() != FUNCTION) {
+            return false;
+        }
+        uint32_t count = u32();
+        for (uint32_t i = 0; _ok && i < count; ++i) {
+            parameters.emplace_back(name());
+        }
+        body.reset(required(block()));
+        return _ok && _pos == _data.size();
+    }
+private:
+    bool fail() {
+        _ok = false;
+        return false;
+    }
+
+    bool need(size_t n) {
+        if (!_ok || _data.size() - _pos < n) {
+            return fail();
+        }
+        return true;
+    }
+
+    Tag tag() {
+        if (!need(1)) {
+            return NIL;
+        }
+        uint8_t ret = _data[_pos++];
+        if (ret > INDEX) {
+            fail();
+            return NIL;
+        }
+        return Tag(ret);
+    }
+
+    uint32_t u32() {
+        uint32_t ret = 0;
+        if (!need(sizeof(ret))) {
+            return 0;
+        }
+        std::memcpy(&ret, _data.data() + _pos, sizeof(ret));
+        _pos += sizeof(ret);
+        return ret;
+    }
+
+    Token token() {
+        Token ret{Token::ILLEGAL, ""};
+        if (!need(1)) {
+            return ret;
+        }
+        uint8_t type = _data[_pos++];
+        if (type > Token::END) {
+            fail();
+            return ret;
+        }
+        ret.type = Token::Type(type);
+
+        uint32_t size = u32();
+        if (!need(size)) {
+            return ret;
+        }
+        ret.literal.assign(_data.data() + _pos, size);
+        _pos += size;
+        return ret;
+    }
+
+    // 子节点缺失时解码失败，编码时允许为空的位置直接调用 statment/expression
+    template <typename T>
+    T* required(std::unique_ptr<T> node) {
+        if (node == nullptr) {
+            fail();
+        }
+        return node.release();
+    }
+
+    ast::Identifier* name() {
+        auto t = token();
+        return new ast::Identifier(t, t.literal);
+    }
+
+    std::unique_ptr<ast::BlockStatment> block() {
+        Tag t = tag();
+        if (t == NIL) {
+            return nullptr;
+        }
+        if (t != BLOCK) {
+            fail();
+            return nullptr;
+        }
+        return block_body();
+    }
+
+    std::unique_ptr<ast::BlockStatment> block_body() {
+        std::unique_ptr<ast::BlockStatment> ret(new ast::BlockStatment(token()));
+        uint32_t count = u32();
+        for (uint32_t i = 0; _ok && i < count; ++i) {
+            ret->append(required(statment()));
+        }
+        return ret;
+    }
+
+    std::unique_ptr<ast::Statment> statment() {
+        Tag t = tag();
+        if (!_ok || t == NIL) {
+            return nullptr;
+        }
+
+        switch (t) {
+        case LET: {
+            std::unique_ptr<ast::LetStatment> ret(new ast::LetStatment(token()));
+            ret->set_identifier(name());
+            ret->set_expression(expression().release());
+            return ret;
+        }
+        case RETURN: {
+            std::unique_ptr<ast::ReturnStatment> ret(new ast::ReturnStatment(token()));
+            ret->set_expression(expression().release());
+            return ret;
+        }
+        case EXPRESSION_STATMENT: {
+            std::unique_ptr<ast::ExpressionStatment> ret(new ast::ExpressionStatment(token()));
+            ret->set_expression(expression().release());
+            return ret;
+        }
+        case BLOCK:
+            return block_body();
+        default:
+            fail();
+            return nullptr;
+        }
+    }
+
+    std::unique_ptr<ast::Expression> expression() {
+        Tag t = tag();
+        if (!_ok || t == NIL) {
+            return nullptr;
+        }
+
+        switch (t) {
+        case IDENTIFIER: {
+            auto ret = std::unique_ptr<ast::Identifier>(name());
+            // 内置函数的下标不写入缓存，按当前程序的内置函数表重新绑定
+            ret->set_builtin(builtin::lookup(ret->value()));
+            return ret;
+        }
+        case INTEGER:
+            return std::unique_ptr<ast::Expression>(new ast::IntegerLiteral(token()));
+        case FLOAT:
+            return std::unique_ptr<ast::Expression>(new ast::FloatLiteral(token()));
+        case STRING:
+            return std::unique_ptr<ast::Expression>(new ast::StringLiteral(token()));
+        case BOOLEAN:
+            return std::unique_ptr<ast::Expression>(new ast::BooleanLiteral(token()));
+        case PREFIX: {
+            std::unique_ptr<ast::PrefixExpression> ret(new ast::PrefixExpression(token()));
+            ret->set_right(required(expression()));
+            return ret;
+        }
+        case INFIX: {
+            std::unique_ptr<ast::InfixExpression> ret(new ast::InfixExpression(token()));
+            ret->set_left(required(expression()));
+            ret->set_right(required(expression()));
+            return ret;
+        }
+        case IF: {
+            std::unique_ptr<ast::IfExpression> ret(new ast::IfExpression(token()));
+            ret->set_condition(required(expression()));
+            ret->set_consequence(required(block()));
+            ret->set_alternative(block().release());
+            return ret;
+        }
+        case WHILE: {
+            std::unique_ptr<ast::WhileExpression> ret(new ast::WhileExpression(token()));
+            ret->set_condition(required(expression()));
+            ret->set_body(required(block()));
+            return ret;
+        }
+        case FOR: {
+            std::unique_ptr<ast::ForExpression> ret(new ast::ForExpression(token()));
+            ret->set_variable(name());
+            ret->set_iterable(required(expression()));
+            ret->set_body(required(block()));
+            return ret;
+        }
+        case ASSIGN: {
+            std::unique_ptr<ast::AssignExpression> ret(new ast::AssignExpression(token()));
+            ret->set_target(required(expression()));
+            ret->set_value(required(expression()));
+            return ret;
+        }
+        case FUNCTION: {
+            std::unique_ptr<ast::FunctionLiteral> ret(new ast::FunctionLiteral(token()));
+            uint32_t count = u32();
+            for (uint32_t i = 0; _ok && i < count; ++i) {
+                ret->append_parameter(name());
+            }
+            ret->set_body(required(block()));
+            return ret;
+        }
+        case CALL: {
+            std::unique_ptr<ast::CallExpression> ret(new ast::CallExpression(token()));
+            ret->set_function(required(expression()));
+            ret->set_arguments(expressions());
+            return ret;
+        }
+        case ARRAY: {
+            std::unique_ptr<ast::ArrayLiteral> ret(new ast::ArrayLiteral(token()));
+            ret->set_elements(expressions());
+            return ret;
+        }
+        case HASH: {
+            std::unique_ptr<ast::HashLiteral> ret(new ast::HashLiteral(token()));
+            uint32_t count = u32();
+            for (uint32_t i = 0; _ok && i < count; ++i) {
+                auto key = expression();
+                auto value = expression();
+                if (key == nullptr || value == nullptr) {
+                    fail();
+                    break;
+                }
+                ret->add_pair(std::make_pair(std::move(key), std::move(value)));
+            }
+            return ret;
+        }
+        case INDEX: {
+            std::unique_ptr<ast::IndexExpression> ret(new ast::IndexExpression(token()));
+            ret->set_left(required(expression()));
+            ret->set_index(required(expression()));
+            return ret;
+        }
+        default:
+            fail();
+            return nullptr;
+        }
+    }
+
+    std::vector<std::unique_ptr<ast::Expression>> expressions() {
+        std::vector<std::unique_ptr<ast::Expression>> ret;
+        uint32_t count = u32();
+        for (uint32_t i = 0; _ok && i < count; ++i) {
+            auto exp = expression();
+            if (exp == nullptr) {
+                fail();
+                break;
+            }
+            ret.push_back(std::move(exp));
+        }
+        return ret;
+    }
+private:
+    std::string_view _data;
+    size_t _pos = 0;
+    bool _ok = true;
+};
+
+uint64_t fingerprint(std::string_view source) {
+    uint64_t ret = 14695981039346656037ull;
+    for (unsigned char c : source) {
+        ret = (ret ^ c) * 1099511628211ull;
+    }
+    return ret;
+}
+
+std::string encode(const ast::Program& program) {
+    Encoder encoder;
+    encoder.program(program);
+    return encoder.release();
+}
+
+std::unique_ptr<ast::Program> decode(std::string_view data) {
+    Decoder decoder(data);
+    auto program = decoder.program();
+    if (program != nullptr) {
+        scope::resolve(*program);
+    }
+    return program;
+}
+
+std::string encode(
+        const std::vector<std::shared_ptr<ast::Identifier>>& parameters,
+        const ast::BlockStatment& body) {
+    Encoder encoder;
+    encoder.function(parameters, body);
+    return encoder.release();
+}
+
+bool decode(
+        std::string_view data,
+        std::vector<std::shared_ptr<ast::Identifier>>& parameters,
+        std::shared_ptr<ast::BlockStatment>& body) {
+    Decoder decoder(data);
+    if (!decoder.function(parameters, body)) {
+        return false;
+    }
+    scope::resolve(parameters, *body);
+    return true;
+}
+
+std::unique_ptr<ast::Program> load(const std::string& path, uint64_t source) {
+    MappedFile file(path);
+    if (!file.ok() || file.data().size() < sizeof(Header)) {
+        return nullptr;
+    }
+
+    Header header;
+    std::memcpy(&header, file.data().data(), sizeof(header));
+    auto payload = file.data().substr(sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+            || header.version != VERSION
+            || header.source != source
+            || header.payload_size != payload.size()
+            || header.payload != fingerprint(payload)) {
+        return nullptr;
+    }
+    return decode(payload);
+}
+
+bool store(const std::string& path, uint64_t source, const ast::Program& program) {
+    std::string payload = encode(program);
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.source = source;
+    header.payload_size = payload.size();
+    header.payload = fingerprint(payload);
+
+    std::string tmp = path + ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(payload.data(), payload.size());
+        if (!out) {
+            out.close();
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string path_for(const std::string& script) {
+    return script + "c";
+}
+
+} // namespace cache
+} // namespace autumn
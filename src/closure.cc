@@ -0,0 +1,593 @@
+#include "closure.h"
+
+#include <limits>
+
+#include "builtin.h"
+#include "evaluator.h"
+#include "pool.h"
+#include "scope.h"
+
+namespace autumn {
+namespace closure {
+
+using Opcode = ast::InfixExpression::Opcode;
+
+// 每种节点的转换，闭包中调用求值器的私有实现，与树遍历共用运算和错误信息
+class Compiler {
+public:
+    static Code compile(const ast::Node* node);
+private:
+    static Code statments(const std::vector<std::unique_ptr<ast::Statment>>& statments, bool program);
+    static std::vector<Code> expressions(const std::vector<std::unique_ptr<ast::Expression>>& exps);
+    static Code integer(const ast::IntegerLiteral* exp);
+    static Code prefix(const ast::PrefixExpression* exp);
+    static Code infix(const ast::InfixExpression* exp);
+    template <Opcode OP>
+    static Code infix(Code left, Code right, const std::string& op);
+    static Code if_expression(const ast::IfExpression* exp);
+    static Code while_expression(const ast::WhileExpression* exp);
+    static Code for_expression(const ast::ForExpression* exp);
+    static Code assign_expression(const ast::AssignExpression* exp);
+    static Code identifier(const ast::Identifier* exp);
+    static Code function(const ast::FunctionLiteral* exp);
+    static Code call(const ast::CallExpression* exp);
+    static Code hash_literal(const ast::HashLiteral* exp);
+
+    // 出错时 results 中只有一个 Error 对象，与 Evaluator::eval_expressions 相同
+    template <typename Container>
+    static void run(
+            const std::vector<Code>& codes,
+            const Evaluator& e,
+            Env& env,
+            Container& results) {
+        for (auto& code : codes) {
+            auto val = code(e, env);
+            if (e.is_interrupted()) {
+                results.clear();
+                results.emplace_back(std::move(val));
+                return;
+            }
+            results.emplace_back(std::move(val));
+        }
+    }
+};
+
+Code compile(const ast::Node* node) {
+    return Compiler::compile(node);
+}
+
+Code Compiler::compile(const ast::Node* node) {
+    if (node == nullptr) {
+        // 语法错误，交给树遍历生成同样的错误信息
+        return [](const Evaluator& e, Env& env) -> Value {
+            return e.eval(nullptr, env);
+        };
+    }
+
+    if (auto n = node->cast<ast::Program>()) {
+        return statments(n->statments(), true);
+
+    } else if (auto n = node->cast<ast::BlockStatment>()) {
+        return statments(n->statments(), false);
+
+    } else if (auto n = node->cast<ast::ExpressionStatment>()) {
+        return compile(n->expression());
+
+    } else if (auto n = node->cast<ast::ReturnStatment>()) {
+        auto exp = compile(n->expression());
+        return [exp](const Evaluator& e, Env& env) -> Value {
+            auto val = exp(e, env);
+            if (e.is_interrupted()) {
+                return val;
+            }
+            e._signal = Evaluator::Signal::RETURN;
+            return val;
+        };
+
+    } else if (auto n = node->cast<ast::LetStatment>()) {
+        auto exp = compile(n->expression());
+        auto& name = n->identifier()->value();
+        return [exp, name](const Evaluator& e, Env& env) -> Value {
+            auto val = exp(e, env);
+            if (e.is_interrupted()) {
+                return val;
+            }
+            env->set(name, val);
+            return nullptr;
+        };
+
+    } else if (auto n = node->cast<ast::IntegerLiteral>()) {
+        return integer(n);
+
+    } else if (auto n = node->cast<ast::FloatLiteral>()) {
+        // 数值对象不可变，转换时创建一次，之后每次求值直接返回
+        Value val = std::allocate_shared<object::Float>(PoolAllocator<object::Float>(), n->value());
+        return [val](const Evaluator&, Env&) -> Value {
+            return val;
+        };
+
+    } else if (auto n = node->cast<ast::BooleanLiteral>()) {
+        Value val = n->value() ? object::constants::True : object::constants::False;
+        return [val](const Evaluator&, Env&) -> Value {
+            return val;
+        };
+
+    } else if (auto n = node->cast<ast::StringLiteral>()) {
+        // 字符串可能被原地修改（stream 模式复用行对象），每次求值都新建
+        auto& value = n->value();
+        return [value](const Evaluator&, Env&) -> Value {
+            return std::make_shared<object::String>(value);
+        };
+
+    } else if (auto n = node->cast<ast::ArrayLiteral>()) {
+        auto elems = expressions(n->elements());
+        return [elems](const Evaluator& e, Env& env) -> Value {
+            std::vector<Value> values;
+            values.reserve(elems.size());
+            run(elems, e, env, values);
+            if (e.is_interrupted()) {
+                return values[0];
+            }
+            return std::make_shared<object::Array>(std::move(values));
+        };
+
+    } else if (auto n = node->cast<ast::HashLiteral>()) {
+        return hash_literal(n);
+
+    } else if (auto n = node->cast<ast::PrefixExpression>()) {
+        return prefix(n);
+
+    } else if (auto n = node->cast<ast::InfixExpression>()) {
+        return infix(n);
+
+    } else if (auto n = node->cast<ast::IfExpression>()) {
+        return if_expression(n);
+
+    } else if (auto n = node->cast<ast::WhileExpression>()) {
+        return while_expression(n);
+
+    } else if (auto n = node->cast<ast::ForExpression>()) {
+        return for_expression(n);
+
+    } else if (auto n = node->cast<ast::AssignExpression>()) {
+        return assign_expression(n);
+
+    } else if (auto n = node->cast<ast::Identifier>()) {
+        return identifier(n);
+
+    } else if (auto n = node->cast<ast::FunctionLiteral>()) {
+        return function(n);
+
+    } else if (auto n = node->cast<ast::CallExpression>()) {
+        return call(n);
+
+    } else if (auto n = node->cast<ast::IndexExpression>()) {
+        auto left = compile(n->left());
+        auto index = compile(n->index());
+        return [left, index](const Evaluator& e, Env& env) -> Value {
+            auto array = left(e, env);
+            if (e.is_interrupted()) {
+                return array;
+            }
+            auto idx = index(e, env);
+            if (e.is_interrupted()) {
+                return idx;
+            }
+            return e.eval_index_expression(array.get(), idx.get());
+        };
+    }
+
+    return [](const Evaluator&, Env&) -> Value {
+        return nullptr;
+    };
+}
+
+Code Compiler::statments(const std::vector<std::unique_ptr<ast::Statment>>& statments, bool program) {
+    std::vector<Code> codes;
+    codes.reserve(statments.size());
+    for (auto& stat : statments) {
+        codes.push_back(compile(stat.get()));
+    }
+
+    // 只有一条语句的代码块（最常见的函数体）省去循环
+    if (!program && codes.size() == 1) {
+        return codes[0];
+    }
+
+    return [codes, program](const Evaluator& e, Env& env) -> Value {
+        Value result;
+        for (auto& code : codes) {
+            result = code(e, env);
+            if (e.is_interrupted()) {
+                break;
+            }
+        }
+        // 顶层的 return 结束整个程序，错误则保留给调用方
+        if (program && e._signal == Evaluator::Signal::RETURN) {
+            e._signal = Evaluator::Signal::NONE;
+        }
+        return result;
+    };
+}
+
+std::vector<Code> Compiler::expressions(const std::vector<std::unique_ptr<ast::Expression>>& exps) {
+    std::vector<Code> codes;
+    codes.reserve(exps.size());
+    for (auto& exp : exps) {
+        codes.push_back(compile(exp.get()));
+    }
+    return codes;
+}
+
+Code Compiler::integer(const ast::IntegerLiteral* exp) {
+    if (exp->overflow()) {
+        Bignum value;
+        Bignum::parse(exp->token_literal(), value);
+        return [value](const Evaluator&, Env&) -> Value {
+            Bignum copy = value;
+            return std::make_shared<object::BigInt>(std::move(copy));
+        };
+    }
+    Value val = std::make_shared<object::Integer>(exp->value());
+    return [val](const Evaluator&, Env&) -> Value {
+        return val;
+    };
+}
+
+Code Compiler::prefix(const ast::PrefixExpression* exp) {
+    auto right = compile(exp->right());
+    auto& op = exp->op();
+    if (op == "!") {
+        return [right](const Evaluator& e, Env& env) -> Value {
+            auto val = right(e, env);
+            if (e.is_interrupted()) {
+                return val;
+            }
+            return e.eval_bang_operator_expression(val.get());
+        };
+    } else if (op == "-") {
+        return [right](const Evaluator& e, Env& env) -> Value {
+            auto val = right(e, env);
+            if (e.is_interrupted()) {
+                return val;
+            }
+            return e.eval_minus_prefix_operator_expression(val.get());
+        };
+    }
+    return [right, op](const Evaluator& e, Env& env) -> Value {
+        auto val = right(e, env);
+        if (e.is_interrupted()) {
+            return val;
+        }
+        return e.eval_prefix_expression(op, val.get(), env);
+    };
+}
+
+Code Compiler::infix(const ast::InfixExpression* exp) {
+    auto left = compile(exp->left());
+    auto right = compile(exp->right());
+    auto& op = exp->op();
+    switch (exp->opcode()) {
+    case Opcode::ADD:
+        return infix<Opcode::ADD>(left, right, op);
+    case Opcode::SUB:
+        return infix<Opcode::SUB>(left, right, op);
+    case Opcode::MUL:
+        return infix<Opcode::MUL>(left, right, op);
+    case Opcode::DIV:
+        return infix<Opcode::DIV>(left, right, op);
+    case Opcode::LT:
+        return infix<Opcode::LT>(left, right, op);
+    case Opcode::LE:
+        return infix<Opcode::LE>(left, right, op);
+    case Opcode::GT:
+        return infix<Opcode::GT>(left, right, op);
+    case Opcode::GE:
+        return infix<Opcode::GE>(left, right, op);
+    case Opcode::EQ:
+        return infix<Opcode::EQ>(left, right, op);
+    case Opcode::NE:
+        return infix<Opcode::NE>(left, right, op);
+    default:
+        return infix<Opcode::OTHER>(left, right, op);
+    }
+}
+
+// 两个操作数都是 Integer 时直接计算，溢出、除以 0 和其它类型交给通用实现
+template <Opcode OP>
+Code Compiler::infix(Code left, Code right, const std::string& op) {
+    return [left, right, op](const Evaluator& e, Env& env) -> Value {
+        auto l = left(e, env);
+        if (e.is_interrupted()) {
+            return l;
+        }
+        auto r = right(e, env);
+        if (e.is_interrupted()) {
+            return r;
+        }
+
+        if constexpr (OP != Opcode::OTHER) {
+            if (typeid(*l) == typeid(object::Integer) && typeid(*r) == typeid(object::Integer)) {
+                int64_t a = l->cast<object::Integer>()->value();
+                int64_t b = r->cast<object::Integer>()->value();
+                int64_t result;
+                if constexpr (OP == Opcode::ADD) {
+                    if (!__builtin_add_overflow(a, b, &result)) {
+                        return std::make_shared<object::Integer>(result);
+                    }
+                } else if constexpr (OP == Opcode::SUB) {
+                    if (!__builtin_sub_overflow(a, b, &result)) {
+                        return std::make_shared<object::Integer>(result);
+                    }
+                } else if constexpr (OP == Opcode::MUL) {
+                    if (!__builtin_mul_overflow(a, b, &result)) {
+                        return std::make_shared<object::Integer>(result);
+                    }
+                } else if constexpr (OP == Opcode::DIV) {
+                    if (b != 0 && !(b == -1 && a == std::numeric_limits<int64_t>::min())) {
+                        return std::make_shared<object::Integer>(a / b);
+                    }
+                } else if constexpr (OP == Opcode::LT) {
+                    return e.native_bool_to_boolean_object(a < b);
+                } else if constexpr (OP == Opcode::LE) {
+                    return e.native_bool_to_boolean_object(a <= b);
+                } else if constexpr (OP == Opcode::GT) {
+                    return e.native_bool_to_boolean_object(a > b);
+                } else if constexpr (OP == Opcode::GE) {
+                    return e.native_bool_to_boolean_object(a >= b);
+                } else if constexpr (OP == Opcode::EQ) {
+                    return e.native_bool_to_boolean_object(a == b);
+                } else if constexpr (OP == Opcode::NE) {
+                    return e.native_bool_to_boolean_object(a != b);
+                }
+            }
+        }
+        return e.eval_infix_expression(op, l.get(), r.get(), env);
+    };
+}
+
+Code Compiler::if_expression(const ast::IfExpression* exp) {
+    if (exp->condition() == nullptr) {
+        return [](const Evaluator&, Env&) -> Value {
+            return object::constants::Null;
+        };
+    }
+
+    auto condition = compile(exp->condition());
+    Code consequence = exp->consequence() != nullptr ? compile(exp->consequence()) : Code();
+    Code alternative = exp->alternative() != nullptr ? compile(exp->alternative()) : Code();
+    return [condition, consequence, alternative](const Evaluator& e, Env& env) -> Value {
+        auto cond = condition(e, env);
+        if (e.is_interrupted()) {
+            return cond;
+        }
+        if (e.is_truthy(cond.get()) && consequence) {
+            return consequence(e, env);
+        } else if (alternative) {
+            return alternative(e, env);
+        }
+        return object::constants::Null;
+    };
+}
+
+Code Compiler::while_expression(const ast::WhileExpression* exp) {
+    if (exp->condition() == nullptr || exp->body() == nullptr) {
+        return [](const Evaluator&, Env&) -> Value {
+            return object::constants::Null;
+        };
+    }
+
+    auto condition = compile(exp->condition());
+    auto body = compile(exp->body());
+    return [condition, body](const Evaluator& e, Env& env) -> Value {
+        while (true) {
+            auto cond = condition(e, env);
+            if (e.is_interrupted()) {
+                return cond;
+            }
+            if (!e.is_truthy(cond.get())) {
+                break;
+            }
+
+            auto result = body(e, env);
+            if (e.is_interrupted()) {
+                return result;
+            }
+        }
+        return object::constants::Null;
+    };
+}
+
+Code Compiler::for_expression(const ast::ForExpression* exp) {
+    if (exp->variable() == nullptr || exp->iterable() == nullptr || exp->body() == nullptr) {
+        return [](const Evaluator&, Env&) -> Value {
+            return object::constants::Null;
+        };
+    }
+
+    auto iterable = compile(exp->iterable());
+    auto body = compile(exp->body());
+    auto& name = exp->variable()->value();
+    return [iterable, body, name](const Evaluator& e, Env& env) -> Value {
+        auto it = iterable(e, env);
+        if (e.is_interrupted()) {
+            return it;
+        }
+
+        if (typeid(*it) == typeid(object::Array)) {
+            auto& elems = it->cast<object::Array>()->elements();
+            for (size_t i = 0; i < elems.size(); ++i) {
+                env->set(name, elems[i]);
+
+                auto result = body(e, env);
+                if (e.is_interrupted()) {
+                    return result;
+                }
+            }
+            return object::constants::Null;
+        } else if (typeid(*it) == typeid(object::IntArray)) {
+            auto& values = it->cast<object::IntArray>()->values();
+            for (size_t i = 0; i < values.size(); ++i) {
+                env->set(name, std::make_shared<object::Integer>(values[i]));
+
+                auto result = body(e, env);
+                if (e.is_interrupted()) {
+                    return result;
+                }
+            }
+            return object::constants::Null;
+        }
+
+        return e.new_error("for loop not supported: {}`{}`{}",
+                color::light::light,
+                it->type(),
+                color::off);
+    };
+}
+
+Code Compiler::assign_expression(const ast::AssignExpression* exp) {
+    auto value = compile(exp->value());
+
+    if (auto identifier = exp->target()->cast<ast::Identifier>()) {
+        auto& name = identifier->value();
+        return [value, name](const Evaluator& e, Env& env) -> Value {
+            auto val = value(e, env);
+            if (e.is_interrupted()) {
+                return val;
+            }
+            return e.assign(name, val, env);
+        };
+    }
+
+    // 下标按从外到内的顺序求值，与树遍历相同
+    std::vector<Code> indexes;
+    auto target = exp->target();
+    while (auto index_exp = target->cast<ast::IndexExpression>()) {
+        indexes.push_back(compile(index_exp->index()));
+        target = index_exp->left();
+    }
+
+    auto identifier = target->cast<ast::Identifier>();
+    // 目标不合法时仍然要先求值右边和下标
+    auto text = identifier == nullptr ? exp->target()->to_string() : std::string();
+    auto name = identifier == nullptr ? std::string() : identifier->value();
+    return [value, indexes, identifier, text, name](const Evaluator& e, Env& env) -> Value {
+        auto val = value(e, env);
+        if (e.is_interrupted()) {
+            return val;
+        }
+
+        std::vector<Value> idxs;
+        idxs.reserve(indexes.size());
+        for (auto& index : indexes) {
+            auto idx = index(e, env);
+            if (e.is_interrupted()) {
+                return idx;
+            }
+            idxs.push_back(std::move(idx));
+        }
+
+        if (identifier == nullptr) {
+            return e.new_error("invalid assignment target: {}`{}`{}",
+                    color::light::light,
+                    text,
+                    color::off);
+        }
+        return e.assign_index(name, idxs, val, env);
+    };
+}
+
+Code Compiler::identifier(const ast::Identifier* exp) {
+    // 全局变量和内置函数经过标识符上的内联缓存
+    if (exp->global()) {
+        return [exp](const Evaluator& e, Env& env) -> Value {
+            return e.eval_identifier(exp, env);
+        };
+    }
+
+    auto& name = exp->value();
+    // 内置函数在转换时取出，求值时环境中没有同名绑定才使用
+    auto builtin = exp->builtin() >= 0 ? builtin::BUILTINS[exp->builtin()] : nullptr;
+    return [name, builtin](const Evaluator& e, Env& env) -> Value {
+        auto val = env->get(name);
+        if (val != nullptr) {
+            return val;
+        }
+        if (builtin != nullptr) {
+            return builtin;
+        }
+        return e.new_error("identifier not found: {}`{}`{}",
+                color::light::light,
+                name,
+                color::off);
+    };
+}
+
+Code Compiler::function(const ast::FunctionLiteral* exp) {
+    // 函数体只转换一次，这个字面量每次求值得到的函数对象共享它
+    std::shared_ptr<const Code> body;
+    if (exp->body() != nullptr) {
+        body = std::make_shared<const Code>(compile(exp->body().get()));
+    }
+    return [exp, body](const Evaluator&, Env& env) -> Value {
+        auto fn = scope::function(exp, env);
+        fn->set_compiled(body);
+        return fn;
+    };
+}
+
+Code Compiler::call(const ast::CallExpression* exp) {
+    auto function = compile(exp->function());
+    auto args = expressions(exp->arguments());
+    auto identifier = exp->function()->cast<ast::Identifier>();
+    std::string frame = identifier != nullptr ? identifier->value() : "<anonymous>";
+    return [function, args, frame](const Evaluator& e, Env& env) -> Value {
+        auto fn = function(e, env);
+        if (e.is_interrupted()) {
+            return fn;
+        }
+
+        ArgumentList values;
+        run(args, e, env, values);
+        if (e.is_interrupted()) {
+            return values[0];
+        }
+
+        if (e._profiler != nullptr) {
+            Profiler::Scope scope(e._profiler.get(), frame);
+            return e.apply_function(fn.get(), values);
+        }
+        return e.apply_function(fn.get(), values);
+    };
+}
+
+Code Compiler::hash_literal(const ast::HashLiteral* exp) {
+    std::vector<std::pair<Code, Code>> pairs;
+    for (auto& pair : exp->pairs()) {
+        pairs.emplace_back(compile(pair.first.get()), compile(pair.second.get()));
+    }
+    return [pairs](const Evaluator& e, Env& env) -> Value {
+        auto ret = std::make_shared<object::Hash>();
+        for (auto& pair : pairs) {
+            auto key = pair.first(e, env);
+            if (!e.resume_after_error()) {
+                return key;
+            }
+
+            auto val = pair.second(e, env);
+            if (!e.resume_after_error()) {
+                return val;
+            }
+
+            if (key == nullptr || val == nullptr) {
+                return nullptr;
+            }
+
+            ret->append(key, val);
+        }
+        return ret;
+    };
+}
+
+} // namespace closure
+} // namespace autumn
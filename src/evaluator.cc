@@ -1,25 +1,219 @@
 #include "evaluator.h"
+
+#include <limits>
+
 #include "builtin.h"
+#include "cache.h"
+#include "closure.h"
+#include "mapped_file.h"
+#include "pool.h"
+#include "scope.h"
+#include "simd.h"
+#include "snapshot.h"
 
 namespace autumn {
 
+namespace {
+
+const std::string ANONYMOUS_FRAME = "<anonymous>";
+
+// 分析器中栈帧的名字：通过标识符调用时取函数名，否则记为匿名函数
+const std::string& frame_name(const ast::CallExpression* call) {
+    auto identifier = call->function()->cast<ast::Identifier>();
+    if (identifier != nullptr) {
+        return identifier->value();
+    }
+    return ANONYMOUS_FRAME;
+}
+
+bool is_integral(const object::Object* obj) {
+    return typeid(*obj) == typeid(object::Integer)
+        || typeid(*obj) == typeid(object::BigInt);
+}
+
+Bignum to_bignum(const object::Object* obj) {
+    if (typeid(*obj) == typeid(object::Integer)) {
+        return Bignum(obj->cast<object::Integer>()->value());
+    }
+    return obj->cast<object::BigInt>()->value();
+}
+
+bool is_numeric(const object::Object* obj) {
+    return is_integral(obj) || typeid(*obj) == typeid(object::Float);
+}
+
+double to_double(const object::Object* obj) {
+    if (typeid(*obj) == typeid(object::Float)) {
+        return obj->cast<object::Float>()->value();
+    } else if (typeid(*obj) == typeid(object::Integer)) {
+        return double(obj->cast<object::Integer>()->value());
+    }
+    return obj->cast<object::BigInt>()->value().to_double();
+}
+
+// 浮点运算的结果很快就会被丢弃，从线程内的空闲链表分配，避免每次运算都调用 malloc
+std::shared_ptr<object::Object> make_float(double value) {
+    return std::allocate_shared<object::Float>(PoolAllocator<object::Float>(), value);
+}
+
+// 能放进 int64_t 的值总是用 Integer 表示
+std::shared_ptr<object::Object> make_integer(Bignum&& value) {
+    if (value.fits_int64()) {
+        return std::make_shared<object::Integer>(value.to_int64());
+    }
+    return std::make_shared<object::BigInt>(std::move(value));
+}
+
+}
+
 Evaluator::Evaluator() :
     _env(new object::Environment()) {
+    set_jit(getenv("AUTUMN_JIT_OFF") == nullptr);
 }
  
 std::shared_ptr<const object::Object> Evaluator::eval(const std::string& input) {
+    Stats::Scope scope(&_stats);
+    Output::Scope output(&_output);
     auto program = _parser.parse(input);
-    return eval(program.get(), _env);
+    _signal = Signal::NONE;
+    auto result = run(program.get());
+    _signal = Signal::NONE;
+    record_exit(result.get());
+    _output.flush();
+    return result;
+}
+
+std::shared_ptr<const object::Object> Evaluator::eval_file(const std::string& path) {
+    Stats::Scope scope(&_stats);
+    Output::Scope output(&_output);
+    _signal = Signal::NONE;
+
+    // 直接在映射的内存上做词法分析，不拷贝整个源码
+    MappedFile file(path);
+    if (!file.ok()) {
+        auto error = new_error("cannot open file: {}`{}`{}",
+                color::light::light,
+                path,
+                color::off);
+        _signal = Signal::NONE;
+        return error;
+    }
+    auto source = file.data();
+
+    auto cache_path = cache::path_for(path);
+    uint64_t fingerprint = cache::fingerprint(source);
+    auto program = cache::load(cache_path, fingerprint);
+    if (program == nullptr) {
+        program = _parser.parse(source);
+        if (!_parser.errors().empty()) {
+            program.reset();
+        } else {
+            // 写缓存失败（比如目录不可写）不影响执行
+            cache::store(cache_path, fingerprint, *program);
+        }
+    }
+
+    auto result = run(program.get());
+    _signal = Signal::NONE;
+    record_exit(result.get());
+    _output.flush();
+    return result;
+}
+
+std::shared_ptr<object::Object> Evaluator::run(const ast::Program* program) const {
+    if (_backend == Backend::CLOSURE && program != nullptr) {
+        auto code = closure::compile(program);
+        return code(*this, _env);
+    }
+    return eval(program, _env);
+}
+
+void Evaluator::record_exit(const object::Object* result) const {
+    if (result == nullptr || typeid(*result) != typeid(object::Error)) {
+        return;
+    }
+    auto error = static_cast<const object::Error*>(result);
+    if (error->exit() && !_exit_requested) {
+        _exit_requested = true;
+        _exit_status = error->exit_status();
+    }
 }
 
-bool Evaluator::is_error(const object::Object* obj) const {
-    return typeid(*obj) == typeid(object::Error);
+std::shared_ptr<const object::Object> Evaluator::eval_native(Native program) {
+    Stats::Scope scope(&_stats);
+    Output::Scope output(&_output);
+    _signal = Signal::NONE;
+    auto result = program(*this, _env);
+    _signal = Signal::NONE;
+    record_exit(result.get());
+    _output.flush();
+    return result;
+}
+
+void Evaluator::define(const std::string& name, const std::shared_ptr<object::Object>& value) {
+    _env->set(name, value);
+}
+
+std::shared_ptr<object::Object> Evaluator::lookup(const std::string& name) const {
+    return _env->get(name);
 }
 
 void Evaluator::reset_env() {
     _env.reset(new object::Environment());
 }
 
+bool Evaluator::save_snapshot(const std::string& path) const {
+    return snapshot::save(path, *_env);
+}
+
+bool Evaluator::load_snapshot(const std::string& path) {
+    auto env = snapshot::load(path);
+    if (env == nullptr) {
+        return false;
+    }
+    _env = env;
+    return true;
+}
+
+void Evaluator::start_profiler(std::chrono::microseconds interval) {
+    if (_profiler != nullptr) {
+        return;
+    }
+    _profiler.reset(new Profiler(interval));
+    _profiler->start();
+}
+
+void Evaluator::stop_profiler(std::ostream& out) {
+    if (_profiler == nullptr) {
+        return;
+    }
+    _profiler->stop();
+    _profiler->write_collapsed(out);
+    _profiler.reset();
+}
+
+std::shared_ptr<object::Object> Evaluator::call(
+        const object::Object* fn,
+        object::Arguments args) const {
+    if (typeid(*fn) != typeid(object::Function)
+            && typeid(*fn) != typeid(object::Builtin)) {
+        return new_error("not a function: {}`{}`{}",
+                color::light::light,
+                fn->type(),
+                color::off);
+    }
+
+    Output::Scope output(&_output);
+    _signal = Signal::NONE;
+    auto val = apply_function(fn, args);
+    _signal = Signal::NONE;
+    record_exit(val.get());
+    if (val == nullptr) {
+        return object::constants::Null;
+    }
+    return val;
+}
+
 std::shared_ptr<object::Object> Evaluator::eval(
         const ast::Node* node,
         std::shared_ptr<object::Environment>& env) const {
@@ -50,15 +244,17 @@ std::shared_ptr<object::Object> Evaluator::eval(
     } else if (typeid(*node) == typeid(ast::ReturnStatment)) {
         auto n = node->cast<ast::ReturnStatment>();
         auto return_val = eval(n->expression(), env);
-        if (is_error(return_val.get())) {
+        if (is_interrupted()) {
             return return_val;
         }
-        return std::make_shared<object::ReturnValue>(return_val);
+        // 不再包装返回值，由 _signal 通知外层语句序列提前结束
+        _signal = Signal::RETURN;
+        return return_val;
 
     } else if (typeid(*node) == typeid(ast::LetStatment)) {
         auto n = node->cast<ast::LetStatment>();
         auto val = eval(n->expression(), env);
-        if (is_error(val.get())) {
+        if (is_interrupted()) {
             return val;
         }
 
@@ -66,9 +262,18 @@ std::shared_ptr<object::Object> Evaluator::eval(
 
     } else if (typeid(*node) == typeid(ast::IntegerLiteral)) {
         auto n = node->cast<ast::IntegerLiteral>();
+        if (n->overflow()) {
+            Bignum value;
+            Bignum::parse(n->token_literal(), value);
+            return std::make_shared<object::BigInt>(std::move(value));
+        }
         return std::shared_ptr<object::Integer>(
                 new object::Integer(n->value()));
 
+    } else if (typeid(*node) == typeid(ast::FloatLiteral)) {
+        auto n = node->cast<ast::FloatLiteral>();
+        return make_float(n->value());
+
     } else if (typeid(*node) == typeid(ast::BooleanLiteral)) {
         auto n = node->cast<ast::BooleanLiteral>();
         return n->value() ? object::constants::True : object::constants::False;
@@ -79,11 +284,13 @@ std::shared_ptr<object::Object> Evaluator::eval(
 
     } else if (typeid(*node) == typeid(ast::ArrayLiteral)) {
         auto n = node->cast<ast::ArrayLiteral>();
-        auto elems = eval_expressions(n->elements(), env);
-        if (!elems.empty() && is_error(elems[0].get())) {
+        std::vector<std::shared_ptr<object::Object>> elems;
+        elems.reserve(n->elements().size());
+        eval_expressions(n->elements(), env, elems);
+        if (is_interrupted()) {
             return elems[0];
         }
-        return std::make_shared<object::Array>(elems);
+        return std::make_shared<object::Array>(std::move(elems));
 
     } else if (typeid(*node) == typeid(ast::HashLiteral)) {
         auto n = node->cast<ast::HashLiteral>();
@@ -92,7 +299,7 @@ std::shared_ptr<object::Object> Evaluator::eval(
     } else if (typeid(*node) == typeid(ast::PrefixExpression)) {
         auto n = node->cast<ast::PrefixExpression>();
         auto right = eval(n->right(), env);
-        if (is_error(right.get())) {
+        if (is_interrupted()) {
             return right;
         }
         return eval_prefix_expression(n->op(), right.get(), env);
@@ -100,51 +307,67 @@ std::shared_ptr<object::Object> Evaluator::eval(
     } else if (typeid(*node) == typeid(ast::InfixExpression)) {
         auto n = node->cast<ast::InfixExpression>();
         auto left = eval(n->left(), env);
-        if (is_error(left.get())) {
+        if (is_interrupted()) {
             return left;
         }
 
         auto right = eval(n->right(), env);
-        if (is_error(right.get())) {
+        if (is_interrupted()) {
             return right;
         }
 
+        auto quickened = eval_quickened_infix_expression(n, left.get(), right.get());
+        if (quickened != nullptr) {
+            return quickened;
+        }
         return eval_infix_expression(n->op(), left.get(), right.get(), env);
 
     } else if (typeid(*node) == typeid(ast::IfExpression)) {
         return eval_if_expression(node->cast<ast::IfExpression>(), env);
 
+    } else if (typeid(*node) == typeid(ast::WhileExpression)) {
+        return eval_while_expression(node->cast<ast::WhileExpression>(), env);
+
+    } else if (typeid(*node) == typeid(ast::ForExpression)) {
+        return eval_for_expression(node->cast<ast::ForExpression>(), env);
+
+    } else if (typeid(*node) == typeid(ast::AssignExpression)) {
+        return eval_assign_expression(node->cast<ast::AssignExpression>(), env);
+
     } else if (typeid(*node) == typeid(ast::Identifier)) {
         return eval_identifier(node->cast<ast::Identifier>(), env);
 
     } else if (typeid(*node) == typeid(ast::FunctionLiteral)) {
-        auto n = node->cast<ast::FunctionLiteral>();
-        return std::make_shared<object::Function>(
-                n->parameters(), n->body(), env);
+        return scope::function(node->cast<ast::FunctionLiteral>(), env);
 
     } else if (typeid(*node) == typeid(ast::CallExpression)) {
         auto n = node->cast<ast::CallExpression>();
         auto function = eval(n->function(), env);
-        if (is_error(function.get())) {
+        if (is_interrupted()) {
             return function;
         }
 
-        auto args = eval_expressions(n->arguments(), env);
-        if (!args.empty() && is_error(args[0].get())) {
+        ArgumentList args;
+        eval_expressions(n->arguments(), env, args);
+        if (is_interrupted()) {
             return args[0];
         }
 
+        if (_profiler != nullptr) {
+            Profiler::Scope scope(_profiler.get(), frame_name(n));
+            return apply_function(function.get(), args);
+        }
         return apply_function(function.get(), args);
 
     } else if (typeid(*node) == typeid(ast::IndexExpression)) {
         auto n = node->cast<ast::IndexExpression>();
         auto array = eval(n->left(), env);
-        if (is_error(array.get())) {
+        if (is_interrupted()) {
             return array;
         }
 
         auto index = eval(n->index(), env);
-        if (is_error(index.get())) {
+        if (is_interrupted()) {
             return index;
         }
 
@@ -175,6 +398,21 @@ std::shared_ptr<object::Object> Evaluator::eval_index_expression(
         }
 
         return elems[idx];
+    } else if (typeid(*obj) == typeid(object::IntArray)
+            && typeid(*index) == typeid(object::Integer)) {
+        auto& values = obj->cast<object::IntArray>()->values();
+        int64_t size = values.size();
+        int64_t idx = index->cast<object::Integer>()->value();
+
+        if (idx < 0) {
+            idx += size;
+        }
+
+        if (idx < 0 || idx >= size) {
+            return object::constants::Null;
+        }
+
+        return std::make_shared<object::Integer>(values[idx]);
     } else if (typeid(*obj) == typeid(object::Hash)) {
         auto h = obj->cast<object::Hash>();
         return h->get(index);
@@ -188,33 +426,101 @@ std::shared_ptr<object::Object> Evaluator::eval_index_expression(
 
 std::shared_ptr<object::Object> Evaluator::apply_function(
         const object::Object* fn,
-        std::vector<std::shared_ptr<object::Object>>& args) const {
+        object::Arguments args) const {
+
+    std::shared_ptr<object::Object> val;
 
-    std::shared_ptr<object::Object> val = object::constants::Null;
+    auto stats = Stats::current;
 
     if (typeid(*fn) == typeid(object::Function)) {
         auto function = fn->cast<object::Function>();
-        auto extended_env = extend_function_env(function, args);
-        // 开始执行函数体内的语句
-        val = eval(function->body(), extended_env);
+        if (stats != nullptr) {
+            ++stats->calls;
+            stats->max_depth = std::max(stats->max_depth, ++stats->depth);
+        }
+        if (_jit) {
+            val = run_compiled(function, args);
+        }
+        if (val == nullptr) {
+            if (function->stack_frame()) {
+                val = call_on_stack(function, args);
+            } else {
+                auto extended_env = extend_function_env(function, args);
+                val = run_function(function, extended_env);
+            }
+            if (_jit) {
+                observe(function, args, val.get());
+            }
+        }
+        if (stats != nullptr) {
+            --stats->depth;
+        }
     } else if (typeid(*fn) == typeid(object::Builtin)) {
         auto builtin_fn = fn->cast<object::Builtin>();
+        if (stats != nullptr) {
+            ++stats->builtin_calls;
+        }
         val = builtin_fn->run(args);
+        if (val->type() == object::Type::ERROR_OBJECT) {
+            _signal = Signal::ERROR;
+        }
     }
 
+    // return 只作用到所在的函数
+    if (_signal == Signal::RETURN) {
+        _signal = Signal::NONE;
+    }
+
+    // 函数体为空或以 let 结尾时没有值
     if (val == nullptr) {
-        return nullptr;
+        return object::constants::Null;
+    }
+    return val;
+}
+
+std::shared_ptr<object::Object> Evaluator::run_function(
+        const object::Function* fn,
+        std::shared_ptr<object::Environment>& env) const {
+    if (fn->native() != nullptr) {
+        auto val = fn->native()(*this, fn, env);
+        if (val != nullptr && val->type() == object::Type::ERROR_OBJECT) {
+            _signal = Signal::ERROR;
+        }
+        return val;
     }
+    if (fn->compiled() != nullptr) {
+        return (*fn->compiled())(*this, env);
+    }
+    // 开始执行函数体内的语句
+    return eval(fn->body(), env);
+}
 
-    if (typeid(*val) == typeid(object::ReturnValue)) {
-        return val->cast<object::ReturnValue>()->value();
+std::shared_ptr<object::Object> Evaluator::call_on_stack(
+        const object::Function* fn,
+        object::Arguments args) const {
+    // 每一层调用深度对应一个环境对象，递归和嵌套调用各自使用更深的一层
+    if (_frame_depth == _frames.size()) {
+        _frames.push_back(std::make_unique<object::Environment>());
+    }
+    auto frame = _frames[_frame_depth++].get();
+    frame->enter(fn->env());
+    auto& params = fn->parameters();
+    for (size_t i = 0; i < params.size() && i < args.size(); ++i) {
+        frame->set(params[i]->value(), args[i]);
     }
+
+    // 不持有所有权：函数体中创建的闭包不会引用调用帧，返回后不再有人使用它
+    std::shared_ptr<object::Environment> env(std::shared_ptr<object::Environment>(), frame);
+    auto val = run_function(fn, env);
+
+    frame->leave();
+    --_frame_depth;
     return val;
 }
 
 std::shared_ptr<object::Environment> Evaluator::extend_function_env(
         const object::Function* fn,
-        std::vector<std::shared_ptr<object::Object>>& args) const {
+        object::Arguments args) const {
     auto new_env = std::make_shared<object::Environment>(fn->env());
     auto& params = fn->parameters();
 
@@ -224,18 +530,89 @@ std::shared_ptr<object::Environment> Evaluator::extend_function_env(
     return new_env;
 }
 
-std::vector<std::shared_ptr<object::Object>> Evaluator::eval_expressions(
+std::shared_ptr<object::Object> Evaluator::run_compiled(
+        const object::Function* fn,
+        object::Arguments args) const {
+    auto& tier = fn->tier();
+    if (tier.rejected) {
+        return nullptr;
+    }
+
+    if (tier.code == nullptr) {
+        if (tier.calls < jit::THRESHOLD) {
+            return nullptr;
+        }
+        tier.code = jit::compile(fn);
+        if (tier.code == nullptr) {
+            tier.rejected = true;
+            return nullptr;
+        }
+    }
+
+    // 被调函数被重新绑定后机器码失效，重新收集类型信息后再编译
+    if (!tier.code->valid()) {
+        tier.code.reset();
+        tier.calls = 0;
+        return nullptr;
+    }
+
+    if (args.size() != tier.code->arity()) {
+        return nullptr;
+    }
+    SmallVector<int64_t, 4> values;
+    for (auto& arg : args) {
+        if (typeid(*arg) != typeid(object::Integer)) {
+            return nullptr;
+        }
+        values.push_back(arg->cast<object::Integer>()->value());
+    }
+
+    auto result = tier.code->run(values.data());
+    if (result.deopt != 0) {
+        // 经常 deopt 的函数（比如总是溢出）不再尝试机器码
+        if (++tier.deopts > jit::MAX_DEOPTS) {
+            tier.code.reset();
+            tier.rejected = true;
+        }
+        return nullptr;
+    }
+    return std::make_shared<object::Integer>(result.value);
+}
+
+void Evaluator::observe(
+        const object::Function* fn,
+        object::Arguments args,
+        const object::Object* result) const {
+    auto& tier = fn->tier();
+    if (tier.rejected || tier.code != nullptr || _signal == Signal::ERROR) {
+        return;
+    }
+
+    bool integers = result != nullptr && typeid(*result) == typeid(object::Integer);
+    for (size_t i = 0; integers && i < args.size(); ++i) {
+        integers = typeid(*args[i]) == typeid(object::Integer);
+    }
+    if (!integers) {
+        tier.rejected = true;
+        return;
+    }
+    ++tier.calls;
+}
+
+template <typename Container>
+void Evaluator::eval_expressions(
         const std::vector<std::unique_ptr<ast::Expression>>& exps,
-        std::shared_ptr<object::Environment>& env) const {
-    std::vector<std::shared_ptr<object::Object>> results;
+        std::shared_ptr<object::Environment>& env,
+        Container& results) const {
     for (auto& exp : exps) {
         auto val = eval(exp.get(), env);
-        if (is_error(val.get())) {
-            return { val };
+        if (is_interrupted()) {
+            results.clear();
+            results.emplace_back(std::move(val));
+            return;
         }
-        results.emplace_back(val);
+        results.emplace_back(std::move(val));
     }
-    return results;
 }
 
 std::shared_ptr<object::Object> Evaluator::eval_program(
@@ -245,15 +622,14 @@ std::shared_ptr<object::Object> Evaluator::eval_program(
 
     for (auto& stat : statments) {
         result = eval(stat.get(), env);
-        if (result == nullptr) {
-            continue;
+        if (is_interrupted()) {
+            break;
         }
+    }
 
-        if (typeid(*result) == typeid(object::ReturnValue)) {
-            return result->cast<object::ReturnValue>()->value();
-        } else if (typeid(*result) == typeid(object::Error)) {
-            return result;
-        }
+    // 顶层的 return 结束整个程序，错误则保留给调用方
+    if (_signal == Signal::RETURN) {
+        _signal = Signal::NONE;
     }
     return result;
 }
@@ -261,14 +637,16 @@ std::shared_ptr<object::Object> Evaluator::eval_program(
 std::shared_ptr<object::Object> Evaluator::eval_identifier(
         const ast::Identifier* identifier,
         std::shared_ptr<object::Environment>& env) const {
-    auto val = env->get(identifier->value());
+    auto val = _inline_caches && identifier->global()
+        ? lookup_global(identifier, env)
+        : env->get(identifier->value());
     if (val != nullptr) {
         return val;
     }
 
-    auto builtin_fn = builtin::BUILTINS.find(identifier->value());
-    if (builtin_fn != builtin::BUILTINS.end()) {
-        return std::make_shared<object::Builtin>(builtin_fn->second);
+    // 环境中没有同名绑定时才使用内置函数，这样 let 可以覆盖内置函数
+    if (identifier->builtin() >= 0) {
+        return builtin::BUILTINS[identifier->builtin()];
     }
 
     return new_error("identifier not found: {}`{}`{}",
@@ -277,6 +655,30 @@ std::shared_ptr<object::Object> Evaluator::eval_identifier(
             color::off);
 }
 
+std::shared_ptr<object::Object> Evaluator::lookup_global(
+        const ast::Identifier* identifier,
+        const std::shared_ptr<object::Environment>& env) const {
+    // 调用帧和闭包的环境中不会有这个名字，直接到最外层
+    auto global = env.get();
+    while (global->outer() != nullptr) {
+        global = global->outer().get();
+    }
+
+    auto& cache = identifier->cache();
+    if (cache.version != global->version()) {
+        cache.version = global->version();
+        cache.slot = global->find(identifier->value());
+    }
+
+    if (cache.slot == nullptr) {
+        if (Stats::current != nullptr) {
+            ++Stats::current->env_misses;
+        }
+        return nullptr;
+    }
+    return *cache.slot;
+}
+
 std::shared_ptr<object::Object> Evaluator::eval_statments(
         const std::vector<std::unique_ptr<ast::Statment>>& statments,
         std::shared_ptr<object::Environment>& env) const {
@@ -284,12 +686,7 @@ std::shared_ptr<object::Object> Evaluator::eval_statments(
 
     for (auto& stat : statments) {
         result = eval(stat.get(), env);
-        if (result == nullptr) {
-            continue;
-        }
-
-        if (typeid(*result) == typeid(object::ReturnValue)
-                || typeid(*result) == typeid(object::Error)) {
+        if (is_interrupted()) {
             return result;
         }
     }
@@ -325,6 +722,14 @@ std::shared_ptr<object::Object> Evaluator::eval_bang_operator_expression(const o
 }
 
 std::shared_ptr<object::Object> Evaluator::eval_minus_prefix_operator_expression(const object::Object* right) const {
+    if (typeid(*right) == typeid(object::BigInt)) {
+        return make_integer(-right->cast<object::BigInt>()->value());
+    }
+
+    if (typeid(*right) == typeid(object::Float)) {
+        return make_float(-right->cast<object::Float>()->value());
+    }
+
     if (typeid(*right) != typeid(object::Integer)) {
         return new_error("unknown operator: {}`-{}`{}",
                 color::light::light,
@@ -332,8 +737,12 @@ std::shared_ptr<object::Object> Evaluator::eval_minus_prefix_operator_expression
                 color::off);
     }
 
-    auto result = right->cast<object::Integer>();
-    return std::make_shared<object::Integer>(-result->value());
+    auto value = right->cast<object::Integer>()->value();
+    int64_t result;
+    if (__builtin_sub_overflow(int64_t(0), value, &result)) {
+        return make_integer(-Bignum(value));
+    }
+    return std::make_shared<object::Integer>(result);
 }
 
 
@@ -349,13 +758,31 @@ std::shared_ptr<object::Object> Evaluator::eval_integer_infix_expression(
     auto left_val = left->cast<object::Integer>();
     auto right_val = right->cast<object::Integer>();
 
+    // 快速路径只多一次溢出标志位检查，溢出时改用大整数重新计算
+    int64_t result;
     if (op == "+") {
-        return std::make_shared<object::Integer>(left_val->value() + right_val->value());
+        if (__builtin_add_overflow(left_val->value(), right_val->value(), &result)) {
+            return eval_bigint_infix_expression(op, left, right);
+        }
+        return std::make_shared<object::Integer>(result);
     } else if (op == "-") {
-        return std::make_shared<object::Integer>(left_val->value() - right_val->value());
+        if (__builtin_sub_overflow(left_val->value(), right_val->value(), &result)) {
+            return eval_bigint_infix_expression(op, left, right);
+        }
+        return std::make_shared<object::Integer>(result);
     } else if (op == "*") {
-        return std::make_shared<object::Integer>(left_val->value() * right_val->value());
+        if (__builtin_mul_overflow(left_val->value(), right_val->value(), &result)) {
+            return eval_bigint_infix_expression(op, left, right);
+        }
+        return std::make_shared<object::Integer>(result);
     } else if (op == "/") {
+        if (right_val->value() == 0) {
+            return new_error("division by zero");
+        }
+        // INT64_MIN / -1 是唯一会溢出的情况
+        if (right_val->value() == -1 && left_val->value() == std::numeric_limits<int64_t>::min()) {
+            return eval_bigint_infix_expression(op, left, right);
+        }
         return std::make_shared<object::Integer>(left_val->value() / right_val->value());
     } else if (op == "<") {
         return native_bool_to_boolean_object(left_val->value() < right_val->value());
@@ -377,6 +804,84 @@ std::shared_ptr<object::Object> Evaluator::eval_integer_infix_expression(
             color::off);
 }
 
+// 至少一边是 BigInt，或者 Integer 运算溢出
+std::shared_ptr<object::Object> Evaluator::eval_bigint_infix_expression(
+        const std::string& op,
+        const object::Object* left,
+        const object::Object* right) const {
+    auto left_val = to_bignum(left);
+    auto right_val = to_bignum(right);
+
+    if (op == "+") {
+        return make_integer(left_val + right_val);
+    } else if (op == "-") {
+        return make_integer(left_val - right_val);
+    } else if (op == "*") {
+        return make_integer(left_val * right_val);
+    } else if (op == "/") {
+        if (right_val.is_zero()) {
+            return new_error("division by zero");
+        }
+        return make_integer(left_val / right_val);
+    }
+
+    int cmp = compare(left_val, right_val);
+    if (op == "<") {
+        return native_bool_to_boolean_object(cmp < 0);
+    } else if (op == "<=") {
+        return native_bool_to_boolean_object(cmp <= 0);
+    } else if (op == ">") {
+        return native_bool_to_boolean_object(cmp > 0);
+    } else if (op == ">=") {
+        return native_bool_to_boolean_object(cmp >= 0);
+    } else if (op == "==") {
+        return native_bool_to_boolean_object(cmp == 0);
+    } else if (op == "!=") {
+        return native_bool_to_boolean_object(cmp != 0);
+    }
+
+    return new_error("unknown operator: {}`{} {} {}`{}",
+            color::light::light,
+            left->type(), op, right->type(),
+            color::off);
+}
+
+// 至少一边是 Float，另一边按 double 参与运算；除以 0 得到 inf 或 nan
+std::shared_ptr<object::Object> Evaluator::eval_float_infix_expression(
+        const std::string& op,
+        const object::Object* left,
+        const object::Object* right) const {
+    double left_val = to_double(left);
+    double right_val = to_double(right);
+
+    if (op == "+") {
+        return make_float(left_val + right_val);
+    } else if (op == "-") {
+        return make_float(left_val - right_val);
+    } else if (op == "*") {
+        return make_float(left_val * right_val);
+    } else if (op == "/") {
+        return make_float(left_val / right_val);
+    } else if (op == "<") {
+        return native_bool_to_boolean_object(left_val < right_val);
+    } else if (op == "<=") {
+        return native_bool_to_boolean_object(left_val <= right_val);
+    } else if (op == ">") {
+        return native_bool_to_boolean_object(left_val > right_val);
+    } else if (op == ">=") {
+        return native_bool_to_boolean_object(left_val >= right_val);
+    } else if (op == "==") {
+        return native_bool_to_boolean_object(left_val == right_val);
+    } else if (op == "!=") {
+        return native_bool_to_boolean_object(left_val != right_val);
+    }
+
+    return new_error("unknown operator: {}`{} {} {}`{}",
+            color::light::light,
+            left->type(), op, right->type(),
+            color::off);
+}
+
 std::shared_ptr<object::Object> Evaluator::eval_string_infix_expression(
         const std::string& op,
         const object::Object* left,
@@ -417,6 +922,214 @@ std::shared_ptr<object::Object> Evaluator::eval_array_infix_expression(
             color::off);
 }
 
+// IntArray 之间按元素运算，IntArray 与整数运算时整数会被广播到每个元素
+std::shared_ptr<object::Object> Evaluator::eval_int_array_infix_expression(
+        const std::string& op,
+        const object::Object* left,
+        const object::Object* right,
+        std::shared_ptr<object::Environment>& env) const {
+    bool add = op == "+";
+    if (!add && op != "*") {
+        return new_error("unknown operator: {}`{} {} {}`{}",
+                color::light::light,
+                left->type(), op, right->type(),
+                color::off);
+    }
+
+    // 整数在左边时交换两边，+ 和 * 都满足交换律
+    if (typeid(*left) == typeid(object::Integer)) {
+        std::swap(left, right);
+    }
+
+    if (typeid(*left) != typeid(object::IntArray)) {
+        return new_error("type mismatch: {}`{} {} {}`{}",
+                color::light::light,
+                left->type(), op, right->type(),
+                color::off);
+    }
+
+    auto& a = left->cast<object::IntArray>()->values();
+    std::vector<int64_t> result(a.size());
+    bool overflow = false;
+
+    // 右边是整数时 b 为空，使用 scalar
+    const std::vector<int64_t>* b = nullptr;
+    int64_t scalar = 0;
+    if (typeid(*right) == typeid(object::Integer)) {
+        scalar = right->cast<object::Integer>()->value();
+        if (add) {
+            overflow = simd::add(a.data(), scalar, result.data(), a.size());
+        } else {
+            overflow = simd::mul(a.data(), scalar, result.data(), a.size());
+        }
+    } else if (typeid(*right) == typeid(object::IntArray)) {
+        b = &right->cast<object::IntArray>()->values();
+        if (a.size() != b->size()) {
+            return new_error("length mismatch: {}`{} {} {}`{}",
+                    color::light::light,
+                    a.size(), op, b->size(),
+                    color::off);
+        }
+        if (add) {
+            overflow = simd::add(a.data(), b->data(), result.data(), a.size());
+        } else {
+            overflow = simd::mul(a.data(), b->data(), result.data(), a.size());
+        }
+    } else {
+        return new_error("type mismatch: {}`{} {} {}`{}",
+                color::light::light,
+                left->type(), op, right->type(),
+                color::off);
+    }
+
+    if (!overflow) {
+        return std::make_shared<object::IntArray>(std::move(result));
+    }
+
+    // 向量化的乘法可能多报溢出，先逐个检查
+    std::vector<bool> wide(a.size());
+    overflow = false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        int64_t y = b != nullptr ? (*b)[i] : scalar;
+        wide[i] = add
+            ? __builtin_add_overflow(a[i], y, &result[i])
+            : __builtin_mul_overflow(a[i], y, &result[i]);
+        overflow |= wide[i];
+    }
+    if (!overflow) {
+        return std::make_shared<object::IntArray>(std::move(result));
+    }
+
+    // 确实有元素溢出时和整数运算一样改用大整数，结果变为普通数组
+    std::vector<std::shared_ptr<object::Object>> elems(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (!wide[i]) {
+            elems[i] = std::make_shared<object::Integer>(result[i]);
+            continue;
+        }
+        Bignum x(a[i]);
+        Bignum y(b != nullptr ? (*b)[i] : scalar);
+        elems[i] = make_integer(add ? x + y : x * y);
+    }
+    return std::make_shared<object::Array>(std::move(elems));
+}
+
+std::shared_ptr<object::Object> Evaluator::eval_quickened_infix_expression(
+        const ast::InfixExpression* exp,
+        const object::Object* left,
+        const object::Object* right) const {
+    using Quick = ast::InfixExpression::Quick;
+    using Opcode = ast::InfixExpression::Opcode;
+
+    auto quick = exp->quick();
+    if (quick == Quick::GENERIC) {
+        return nullptr;
+    }
+
+    auto& left_type = typeid(*left);
+    auto& right_type = typeid(*right);
+    auto opcode = exp->opcode();
+
+    // 第一次求值：只特化结果完全由运算符和类型决定的组合
+    if (quick == Quick::UNINITIALIZED) {
+        quick = Quick::GENERIC;
+        if (left_type == right_type && opcode != Opcode::OTHER) {
+            if (left_type == typeid(object::Integer)) {
+                quick = Quick::INTEGER;
+            } else if (left_type == typeid(object::Float)) {
+                quick = Quick::FLOAT;
+            } else if (left_type == typeid(object::String) && opcode == Opcode::ADD) {
+                quick = Quick::STRING;
+            }
+        }
+        exp->quicken(quick);
+    }
+
+    if (quick == Quick::INTEGER
+            && left_type == typeid(object::Integer)
+            && right_type == typeid(object::Integer)) {
+        int64_t a = left->cast<object::Integer>()->value();
+        int64_t b = right->cast<object::Integer>()->value();
+        int64_t result;
+        switch (opcode) {
+        case Opcode::ADD:
+            if (__builtin_add_overflow(a, b, &result)) {
+                return nullptr;
+            }
+            return std::make_shared<object::Integer>(result);
+        case Opcode::SUB:
+            if (__builtin_sub_overflow(a, b, &result)) {
+                return nullptr;
+            }
+            return std::make_shared<object::Integer>(result);
+        case Opcode::MUL:
+            if (__builtin_mul_overflow(a, b, &result)) {
+                return nullptr;
+            }
+            return std::make_shared<object::Integer>(result);
+        case Opcode::DIV:
+            if (b == 0 || (b == -1 && a == std::numeric_limits<int64_t>::min())) {
+                return nullptr;
+            }
+            return std::make_shared<object::Integer>(a / b);
+        case Opcode::LT:
+            return native_bool_to_boolean_object(a < b);
+        case Opcode::LE:
+            return native_bool_to_boolean_object(a <= b);
+        case Opcode::GT:
+            return native_bool_to_boolean_object(a > b);
+        case Opcode::GE:
+            return native_bool_to_boolean_object(a >= b);
+        case Opcode::EQ:
+            return native_bool_to_boolean_object(a == b);
+        case Opcode::NE:
+            return native_bool_to_boolean_object(a != b);
+        default:
+            return nullptr;
+        }
+    } else if (quick == Quick::FLOAT
+            && left_type == typeid(object::Float)
+            && right_type == typeid(object::Float)) {
+        double a = left->cast<object::Float>()->value();
+        double b = right->cast<object::Float>()->value();
+        switch (opcode) {
+        case Opcode::ADD:
+            return make_float(a + b);
+        case Opcode::SUB:
+            return make_float(a - b);
+        case Opcode::MUL:
+            return make_float(a * b);
+        case Opcode::DIV:
+            return make_float(a / b);
+        case Opcode::LT:
+            return native_bool_to_boolean_object(a < b);
+        case Opcode::LE:
+            return native_bool_to_boolean_object(a <= b);
+        case Opcode::GT:
+            return native_bool_to_boolean_object(a > b);
+        case Opcode::GE:
+            return native_bool_to_boolean_object(a >= b);
+        case Opcode::EQ:
+            return native_bool_to_boolean_object(a == b);
+        case Opcode::NE:
+            return native_bool_to_boolean_object(a != b);
+        default:
+            return nullptr;
+        }
+    } else if (quick == Quick::STRING
+            && left_type == typeid(object::String)
+            && right_type == typeid(object::String)) {
+        return std::make_shared<object::String>(
+                left->cast<object::String>()->value() + right->cast<object::String>()->value());
+    }
+
+    // 守卫失败：这个节点的操作数类型不固定，以后直接走通用路径
+    if (quick != Quick::GENERIC) {
+        exp->quicken(Quick::GENERIC);
+    }
+    return nullptr;
+}
+
 std::shared_ptr<object::Object> Evaluator::eval_infix_expression(
         const std::string& op,
         const object::Object* left,
@@ -429,12 +1142,19 @@ std::shared_ptr<object::Object> Evaluator::eval_infix_expression(
     if (typeid(*left) == typeid(object::Integer)
             && typeid(*right) == typeid(object::Integer)) {
         return eval_integer_infix_expression(op, left, right, env);
+    } else if (is_integral(left) && is_integral(right)) {
+        return eval_bigint_infix_expression(op, left, right);
+    } else if (is_numeric(left) && is_numeric(right)) {
+        return eval_float_infix_expression(op, left, right);
     } else if (typeid(*left) == typeid(object::String)
             && typeid(*right) == typeid(object::String)) {
         return eval_string_infix_expression(op, left, right, env);
     } else if (typeid(*left) == typeid(object::Array)
             && typeid(*right) == typeid(object::Array)) {
         return eval_array_infix_expression(op, left, right, env);
+    } else if (typeid(*left) == typeid(object::IntArray)
+            || typeid(*right) == typeid(object::IntArray)) {
+        return eval_int_array_infix_expression(op, left, right, env);
     } else if (typeid(*left) != typeid(*right)) {
         return new_error("type mismatch: {}`{} {} {}`{}",
                 color::light::light,
@@ -471,7 +1191,7 @@ std::shared_ptr<object::Object> Evaluator::eval_if_expression(
         return object::constants::Null;
     }
     auto condition = eval(exp->condition(), env);
-    if (is_error(condition.get())) {
+    if (is_interrupted()) {
         return condition;
     }
 
@@ -484,6 +1204,264 @@ std::shared_ptr<object::Object> Evaluator::eval_if_expression(
     return object::constants::Null;
 }
 
+// 循环体直接在当前环境中求值，每轮迭代既不新建环境也不加深调用栈
+std::shared_ptr<object::Object> Evaluator::eval_while_expression(
+            const ast::WhileExpression* exp,
+            std::shared_ptr<object::Environment>& env) const {
+    if (exp->condition() == nullptr || exp->body() == nullptr) {
+        return object::constants::Null;
+    }
+
+    while (true) {
+        auto condition = eval(exp->condition(), env);
+        if (is_interrupted()) {
+            return condition;
+        }
+        if (!is_truthy(condition.get())) {
+            break;
+        }
+
+        auto result = eval(exp->body(), env);
+        if (is_interrupted()) {
+            return result;
+        }
+    }
+
+    return object::constants::Null;
+}
+
+std::shared_ptr<object::Object> Evaluator::eval_for_expression(
+            const ast::ForExpression* exp,
+            std::shared_ptr<object::Environment>& env) const {
+    if (exp->variable() == nullptr || exp->iterable() == nullptr || exp->body() == nullptr) {
+        return object::constants::Null;
+    }
+
+    auto iterable = eval(exp->iterable(), env);
+    if (is_interrupted()) {
+        return iterable;
+    }
+
+    // iterable 持有数组的引用，循环体中对同名变量重新赋值不影响本次遍历
+    auto& name = exp->variable()->value();
+    if (typeid(*iterable) == typeid(object::Array)) {
+        auto& elems = iterable->cast<object::Array>()->elements();
+        for (size_t i = 0; i < elems.size(); ++i) {
+            env->set(name, elems[i]);
+
+            auto result = eval(exp->body(), env);
+            if (is_interrupted()) {
+                return result;
+            }
+        }
+        return object::constants::Null;
+    } else if (typeid(*iterable) == typeid(object::IntArray)) {
+        auto& values = iterable->cast<object::IntArray>()->values();
+        for (size_t i = 0; i < values.size(); ++i) {
+            env->set(name, std::make_shared<object::Integer>(values[i]));
+
+            auto result = eval(exp->body(), env);
+            if (is_interrupted()) {
+                return result;
+            }
+        }
+        return object::constants::Null;
+    }
+
+    return new_error("for loop not supported: {}`{}`{}",
+            color::light::light,
+            iterable->type(),
+            color::off);
+}
+
+std::shared_ptr<object::Object> Evaluator::eval_assign_expression(
+            const ast::AssignExpression* exp,
+            std::shared_ptr<object::Environment>& env) const {
+    auto val = eval(exp->value(), env);
+    if (is_interrupted()) {
+        return val;
+    }
+
+    if (auto identifier = exp->target()->cast<ast::Identifier>()) {
+        return assign(identifier->value(), val, env);
+    }
+
+    // a[i][j] = v：先从外到内求出所有下标，再从变量开始逐层找到要修改的位置，
+    // 查找过程中不再执行脚本，拿到的位置不会失效
+    std::vector<std::shared_ptr<object::Object>> indexes;
+    auto target = exp->target();
+    while (auto index_exp = target->cast<ast::IndexExpression>()) {
+        auto index = eval(index_exp->index(), env);
+        if (is_interrupted()) {
+            return index;
+        }
+        indexes.push_back(std::move(index));
+        target = index_exp->left();
+    }
+
+    auto identifier = target->cast<ast::Identifier>();
+    if (identifier == nullptr) {
+        return new_error("invalid assignment target: {}`{}`{}",
+                color::light::light,
+                exp->target()->to_string(),
+                color::off);
+    }
+
+    return assign_index(identifier->value(), indexes, val, env);
+}
+
+std::shared_ptr<object::Object> Evaluator::assign(
+            const std::string& name,
+            const std::shared_ptr<object::Object>& val,
+            std::shared_ptr<object::Environment>& env) const {
+    bool shared = false;
+    auto slot = env->find_writable(name, shared);
+    if (slot == nullptr) {
+        return assign_error(name, shared);
+    }
+    *slot = val;
+    return val;
+}
+
+std::shared_ptr<object::Object> Evaluator::assign_error(const std::string& name, bool shared) const {
+    if (shared) {
+        return new_error("cannot assign to shared variable in parallel task: {}`{}`{}",
+                color::light::light,
+                name,
+                color::off);
+    }
+    return new_error("identifier not found: {}`{}`{}",
+            color::light::light,
+            name,
+            color::off);
+}
+
+std::shared_ptr<object::Object> Evaluator::assign_index(
+            const std::string& name,
+            const std::vector<std::shared_ptr<object::Object>>& indexes,
+            const std::shared_ptr<object::Object>& val,
+            std::shared_ptr<object::Environment>& env) const {
+    bool shared = false;
+    auto slot = env->find_writable(name, shared);
+    if (slot == nullptr) {
+        return assign_error(name, shared);
+    }
+
+    for (auto it = indexes.rbegin(); it != indexes.rend(); ++it) {
+        auto error = unshare(*slot);
+        if (error != nullptr) {
+            return error;
+        }
+
+        auto& container = *slot;
+        auto index = it->get();
+        bool last = it + 1 == indexes.rend();
+
+        if (typeid(*container) == typeid(object::Array)) {
+            auto array = container->cast<object::Array>();
+            if (typeid(*index) != typeid(object::Integer)) {
+                return new_error("index operator not supported: {}`{}`{}",
+                        color::light::light,
+                        container->type(),
+                        color::off);
+            }
+
+            int64_t size = array->elements().size();
+            int64_t idx = index->cast<object::Integer>()->value();
+            if (idx < 0) {
+                idx += size;
+            }
+            if (idx < 0 || idx >= size) {
+                return new_error("index out of range: {}`{}`{}",
+                        color::light::light,
+                        index->inspect(),
+                        color::off);
+            }
+            slot = &array->at(idx);
+        } else if (typeid(*container) == typeid(object::IntArray)) {
+            auto& values = container->cast<object::IntArray>()->values();
+            if (typeid(*index) != typeid(object::Integer) || !last) {
+                return new_error("index operator not supported: {}`{}`{}",
+                        color::light::light,
+                        last ? container->type() : object::Type(object::Type::INTEGER_OBJECT),
+                        color::off);
+            }
+            if (typeid(*val) != typeid(object::Integer)) {
+                return new_error("type mismatch: {}`{}[] = {}`{}",
+                        color::light::light,
+                        container->type(),
+                        val->type(),
+                        color::off);
+            }
+
+            int64_t size = values.size();
+            int64_t idx = index->cast<object::Integer>()->value();
+            if (idx < 0) {
+                idx += size;
+            }
+            if (idx < 0 || idx >= size) {
+                return new_error("index out of range: {}`{}`{}",
+                        color::light::light,
+                        index->inspect(),
+                        color::off);
+            }
+            values[idx] = val->cast<object::Integer>()->value();
+            return val;
+        } else {
+            auto hash = container->cast<object::Hash>();
+            if (last) {
+                if (!hash->set(*it, val)) {
+                    return new_error("unusable as hash key: {}`{}`{}",
+                            color::light::light,
+                            index->type(),
+                            color::off);
+                }
+                return val;
+            }
+
+            slot = hash->find(index);
+            if (slot == nullptr) {
+                return new_error("index operator not supported: {}`{}`{}",
+                        color::light::light,
+                        object::constants::Null->type(),
+                        color::off);
+            }
+        }
+    }
+
+    *slot = val;
+    return val;
+}
+
+// 写时复制：数组和哈希表只有一个引用时原地修改，被共享时先复制一份
+std::shared_ptr<object::Object> Evaluator::unshare(
+            std::shared_ptr<object::Object>& container) const {
+    if (typeid(*container) == typeid(object::Array)) {
+        if (container.use_count() > 1) {
+            container = std::make_shared<object::Array>(
+                    container->cast<object::Array>()->elements());
+        }
+        return nullptr;
+    } else if (typeid(*container) == typeid(object::IntArray)) {
+        if (container.use_count() > 1) {
+            container = std::make_shared<object::IntArray>(
+                    container->cast<object::IntArray>()->values());
+        }
+        return nullptr;
+    } else if (typeid(*container) == typeid(object::Hash)) {
+        if (container.use_count() > 1) {
+            container = std::make_shared<object::Hash>(
+                    container->cast<object::Hash>()->pairs());
+        }
+        return nullptr;
+    }
+
+    return new_error("index operator not supported: {}`{}`{}",
+            color::light::light,
+            container->type(),
+            color::off);
+}
+
 std::shared_ptr<object::Object> Evaluator::eval_hash_literal(
             const ast::HashLiteral* exp,
             std::shared_ptr<object::Environment>& env) const {
@@ -493,14 +1471,16 @@ std::shared_ptr<object::Object> Evaluator::eval_hash_literal(
     // std::pair<std::unique_ptr<ast::Expression>, std::unique_ptr<ast::Expression>>
     for (auto& pair : pairs) {
         auto key = eval(pair.first.get(), env);
-
-        if (key == nullptr) {
-            return nullptr;
+        if (!resume_after_error()) {
+            return key;
         }
 
         auto val = eval(pair.second.get(), env);
+        if (!resume_after_error()) {
+            return val;
+        }
 
-        if (val == nullptr) {
+        if (key == nullptr || val == nullptr) {
             return nullptr;
         }
 
@@ -0,0 +1,575 @@
+#include "jit.h"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <map>
+#include <typeinfo>
+
+#include <sys/mman.h>
+
+namespace autumn {
+namespace jit {
+
+#if defined(__x86_64__) && defined(__linux__)
+
+namespace {
+
+// 条件码，即 Jcc 指令操作码的低 4 位
+enum Condition : uint8_t {
+    OVERFLOW = 0x0,
+    EQUAL = 0x4,
+    NOT_EQUAL = 0x5,
+    LESS = 0xc,
+    GREATER_EQUAL = 0xd,
+    LESS_EQUAL = 0xe,
+    GREATER = 0xf,
+};
+
+// 只实现模板中用到的指令，跳转一律使用 32 位相对偏移
+class Assembler {
+public:
+    using Label = size_t;
+
+    Label label() {
+        _labels.emplace_back();
+        return _labels.size() - 1;
+    }
+
+    void bind(Label label) {
+        _labels[label].pos = _code.size();
+    }
+
+    void emit(std::initializer_list<uint8_t> bytes) {
+        _code.insert(_code.end(), bytes);
+    }
+
+    void imm32(int32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            _code.push_back(uint8_t(uint32_t(value) >> (i * 8)));
+        }
+    }
+
+    void imm64(int64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            _code.push_back(uint8_t(uint64_t(value) >> (i * 8)));
+        }
+    }
+
+    void patch32(size_t pos, int32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            _code[pos + i] = uint8_t(uint32_t(value) >> (i * 8));
+        }
+    }
+
+    void jmp(Label label) {
+        emit({0xe9});
+        rel32(label);
+    }
+
+    void jcc(Condition cond, Label label) {
+        emit({0x0f, uint8_t(0x80 | cond)});
+        rel32(label);
+    }
+
+    void call(Label label) {
+        emit({0xe8});
+        rel32(label);
+    }
+
+    size_t size() const {
+        return _code.size();
+    }
+
+    // 回填所有跳转的偏移，有未绑定的标签时返回 false
+    bool finish() {
+        for (auto& label : _labels) {
+            for (auto pos : label.fixups) {
+                if (label.pos < 0) {
+                    return false;
+                }
+                patch32(pos, int32_t(label.pos - int64_t(pos + 4)));
+            }
+        }
+        return true;
+    }
+
+    const std::vector<uint8_t>& code() const {
+        return _code;
+    }
+private:
+    void rel32(Label label) {
+        _labels[label].fixups.push_back(_code.size());
+        imm32(0);
+    }
+private:
+    struct LabelInfo {
+        int64_t pos = -1;
+        std::vector<size_t> fixups;
+    };
+
+    std::vector<uint8_t> _code;
+    std::vector<LabelInfo> _labels;
+};
+
+// 比较运算不成立时跳转所用的条件
+bool negated_condition(const std::string& op, Condition& cond) {
+    static const std::map<std::string, Condition> conditions = {
+        {"<", GREATER_EQUAL},
+        {"<=", GREATER},
+        {">", LESS_EQUAL},
+        {">=", LESS},
+        {"==", NOT_EQUAL},
+        {"!=", EQUAL},
+    };
+    auto it = conditions.find(op);
+    if (it == conditions.end()) {
+        return false;
+    }
+    cond = it->second;
+    return true;
+}
+
+} // namespace
+
+// 把一个函数翻译为机器码
+// 栈帧：rbp 指向保存的 rbp，[rbp - 8] 保存 rbx，局部变量从 [rbp - 16] 开始向下排列；
+// rbx 指向实参数组，第 i 个形参位于 [rbx + 8 * i]
+class Compiler {
+public:
+    Compiler(const object::Function* fn, std::vector<const object::Function*>& active) :
+            _fn(fn),
+            _active(active),
+            _code(new Code()) {
+    }
+
+    std::shared_ptr<Code> compile() {
+        auto& params = _fn->parameters();
+        for (size_t i = 0; i < params.size(); ++i) {
+            _slots[params[i]->value()] = Slot{true, int32_t(i)};
+        }
+
+        _active.push_back(_fn);
+        bool ok = function();
+        _active.pop_back();
+        if (!ok || !_as.finish()) {
+            return nullptr;
+        }
+
+        auto& bytes = _as.code();
+        size_t page = 4096;
+        size_t size = (bytes.size() + page - 1) / page * page;
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return nullptr;
+        }
+        std::memcpy(memory, bytes.data(), bytes.size());
+        if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+            munmap(memory, size);
+            return nullptr;
+        }
+
+        _code->_memory = memory;
+        _code->_size = size;
+        _code->_entry = reinterpret_cast<Entry>(memory);
+        _code->_arity = params.size();
+        return _code;
+    }
+private:
+    using Label = Assembler::Label;
+
+    struct Slot {
+        bool param;
+        int32_t index;
+    };
+
+    bool function() {
+        if (_fn->body() == nullptr) {
+            return false;
+        }
+
+        _entry = _as.label();
+        _exit = _as.label();
+        _bail = _as.label();
+
+        _as.bind(_entry);
+        _as.emit({0x55});                   // push rbp
+        _as.emit({0x48, 0x89, 0xe5});       // mov rbp, rsp
+        _as.emit({0x53});                   // push rbx
+        _as.emit({0x48, 0x89, 0xfb});       // mov rbx, rdi
+        _as.emit({0x48, 0x81, 0xec});       // sub rsp, imm32
+        size_t frame = _as.size();
+        _as.imm32(0);
+
+        if (!block(_fn->body(), true, true)) {
+            return false;
+        }
+
+        // 局部变量的个数在编译完函数体后才知道，保持 rsp 16 字节对齐
+        int32_t size = _locals * 8;
+        if (size % 16 == 0) {
+            size += 8;
+        }
+        _as.patch32(frame, size);
+
+        _as.bind(_exit);
+        _as.emit({0x31, 0xd2});             // xor edx, edx
+        epilogue();
+
+        _as.bind(_bail);
+        _as.emit({0xba});                   // mov edx, 1
+        _as.imm32(1);
+        epilogue();
+        return true;
+    }
+
+    void epilogue() {
+        _as.emit({0x48, 0x8d, 0x65, 0xf8}); // lea rsp, [rbp - 8]
+        _as.emit({0x5b});                   // pop rbx
+        _as.emit({0x5d});                   // pop rbp
+        _as.emit({0xc3});                   // ret
+    }
+
+    // value 为 true 时语句块的值（最后一条语句的值）留在 rax 中，必须是整数
+    // let 只能出现在函数体的最外层，这样变量在哪里定义在编译时就能确定
+    bool block(const ast::BlockStatment* block, bool value, bool top) {
+        if (block == nullptr) {
+            return false;
+        }
+
+        auto& statments = block->statments();
+        if (value && statments.empty()) {
+            return false;
+        }
+
+        for (size_t i = 0; i < statments.size(); ++i) {
+            bool last = i + 1 == statments.size();
+            if (!statment(statments[i].get(), value && last, top)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool statment(const ast::Statment* stat, bool value, bool top) {
+        if (typeid(*stat) == typeid(ast::LetStatment)) {
+            auto n = stat->cast<ast::LetStatment>();
+            if (!top || value || !expression(n->expression())) {
+                return false;
+            }
+            int32_t index = _locals++;
+            store_local(index);
+            _slots[n->identifier()->value()] = Slot{false, index};
+            return true;
+
+        } else if (typeid(*stat) == typeid(ast::ReturnStatment)) {
+            auto n = stat->cast<ast::ReturnStatment>();
+            if (!expression(n->expression())) {
+                return false;
+            }
+            _as.jmp(_exit);
+            return true;
+
+        } else if (typeid(*stat) == typeid(ast::ExpressionStatment)) {
+            auto exp = stat->cast<ast::ExpressionStatment>()->expression();
+            if (exp != nullptr && typeid(*exp) == typeid(ast::IfExpression)) {
+                return if_expression(exp->cast<ast::IfExpression>(), value);
+            }
+            return expression(exp);
+        }
+
+        return false;
+    }
+
+    // 整数表达式，结果放在 rax 中
+    bool expression(const ast::Expression* exp) {
+        if (exp == nullptr) {
+            return false;
+        }
+
+        if (typeid(*exp) == typeid(ast::IntegerLiteral)) {
+            auto n = exp->cast<ast::IntegerLiteral>();
+            if (n->overflow()) {
+                return false;
+            }
+            _as.emit({0x48, 0xb8});         // mov rax, imm64
+            _as.imm64(n->value());
+            return true;
+
+        } else if (typeid(*exp) == typeid(ast::Identifier)) {
+            auto it = _slots.find(exp->cast<ast::Identifier>()->value());
+            if (it == _slots.end()) {
+                return false;
+            }
+            if (it->second.param) {
+                _as.emit({0x48, 0x8b, 0x83}); // mov rax, [rbx + disp32]
+                _as.imm32(it->second.index * 8);
+            } else {
+                _as.emit({0x48, 0x8b, 0x85}); // mov rax, [rbp + disp32]
+                _as.imm32(local_offset(it->second.index));
+            }
+            return true;
+
+        } else if (typeid(*exp) == typeid(ast::PrefixExpression)) {
+            auto n = exp->cast<ast::PrefixExpression>();
+            if (n->op() != "-" || !expression(n->right())) {
+                return false;
+            }
+            _as.emit({0x48, 0xf7, 0xd8});   // neg rax
+            _as.jcc(OVERFLOW, _bail);
+            return true;
+
+        } else if (typeid(*exp) == typeid(ast::InfixExpression)) {
+            auto n = exp->cast<ast::InfixExpression>();
+            auto& op = n->op();
+            if (op != "+" && op != "-" && op != "*" && op != "/") {
+                return false;
+            }
+            if (!operands(n)) {
+                return false;
+            }
+
+            if (op == "+") {
+                _as.emit({0x48, 0x01, 0xc8});       // add rax, rcx
+                _as.jcc(OVERFLOW, _bail);
+            } else if (op == "-") {
+                _as.emit({0x48, 0x29, 0xc8});       // sub rax, rcx
+                _as.jcc(OVERFLOW, _bail);
+            } else if (op == "*") {
+                _as.emit({0x48, 0x0f, 0xaf, 0xc1}); // imul rax, rcx
+                _as.jcc(OVERFLOW, _bail);
+            } else {
+                // 除以 0 和 INT64_MIN / -1 交给解释器报错或转为大整数
+                auto divide = _as.label();
+                auto done = _as.label();
+                _as.emit({0x48, 0x85, 0xc9});       // test rcx, rcx
+                _as.jcc(EQUAL, _bail);
+                _as.emit({0x48, 0x83, 0xf9, 0xff}); // cmp rcx, -1
+                _as.jcc(NOT_EQUAL, divide);
+                _as.emit({0x48, 0xf7, 0xd8});       // neg rax
+                _as.jcc(OVERFLOW, _bail);
+                _as.jmp(done);
+                _as.bind(divide);
+                _as.emit({0x48, 0x99});             // cqo
+                _as.emit({0x48, 0xf7, 0xf9});       // idiv rcx
+                _as.bind(done);
+            }
+            return true;
+
+        } else if (typeid(*exp) == typeid(ast::IfExpression)) {
+            return if_expression(exp->cast<ast::IfExpression>(), true);
+
+        } else if (typeid(*exp) == typeid(ast::CallExpression)) {
+            return call(exp->cast<ast::CallExpression>());
+        }
+
+        return false;
+    }
+
+    // 左操作数放在 rax 中，右操作数放在 rcx 中
+    bool operands(const ast::InfixExpression* exp) {
+        if (!expression(exp->left())) {
+            return false;
+        }
+        _as.emit({0x50});                   // push rax
+        if (!expression(exp->right())) {
+            return false;
+        }
+        _as.emit({0x48, 0x89, 0xc1});       // mov rcx, rax
+        _as.emit({0x58});                   // pop rax
+        return true;
+    }
+
+    // 作为值使用时两个分支都必须有值
+    bool if_expression(const ast::IfExpression* exp, bool value) {
+        if (value && exp->alternative() == nullptr) {
+            return false;
+        }
+
+        auto otherwise = _as.label();
+        auto end = _as.label();
+        if (!condition(exp->condition(), otherwise)) {
+            return false;
+        }
+        if (!block(exp->consequence(), value, false)) {
+            return false;
+        }
+        _as.jmp(end);
+        _as.bind(otherwise);
+        if (exp->alternative() != nullptr && !block(exp->alternative(), value, false)) {
+            return false;
+        }
+        _as.bind(end);
+        return true;
+    }
+
+    // 条件不成立时跳转到 otherwise
+    bool condition(const ast::Expression* exp, Label otherwise) {
+        if (exp == nullptr) {
+            return false;
+        }
+
+        if (typeid(*exp) == typeid(ast::BooleanLiteral)) {
+            if (!exp->cast<ast::BooleanLiteral>()->value()) {
+                _as.jmp(otherwise);
+            }
+            return true;
+        }
+
+        Condition cond;
+        auto n = exp->cast<ast::InfixExpression>();
+        if (n != nullptr && negated_condition(n->op(), cond)) {
+            if (!operands(n)) {
+                return false;
+            }
+            _as.emit({0x48, 0x39, 0xc8});   // cmp rax, rcx
+            _as.jcc(cond, otherwise);
+            return true;
+        }
+
+        // 整数总是为真，但仍然要求值（可能需要 deopt）
+        return expression(exp);
+    }
+
+    // 只能调用在闭包环境中绑定到函数的名字，绑定关系记录下来由入口守卫检查
+    bool call(const ast::CallExpression* exp) {
+        auto identifier = exp->function()->cast<ast::Identifier>();
+        if (identifier == nullptr || _slots.count(identifier->value()) != 0) {
+            return false;
+        }
+
+        auto& env = _fn->env();
+        auto slot = env->find(identifier->value());
+        if (slot == nullptr || typeid(**slot) != typeid(object::Function)) {
+            return false;
+        }
+        auto target = *slot;
+        auto callee = target->cast<object::Function>();
+
+        auto& args = exp->arguments();
+        if (callee->parameters().size() != args.size()) {
+            return false;
+        }
+
+        std::shared_ptr<Code> code;
+        if (callee != _fn) {
+            code = callee_code(callee);
+            if (code == nullptr) {
+                return false;
+            }
+        }
+
+        // 实参倒序压栈，第一个实参位于栈顶，rsp 即为被调函数的实参数组
+        for (size_t i = args.size(); i-- > 0;) {
+            if (!expression(args[i].get())) {
+                return false;
+            }
+            _as.emit({0x50});               // push rax
+        }
+        _as.emit({0x48, 0x89, 0xe7});       // mov rdi, rsp
+
+        if (callee == _fn) {
+            _as.call(_entry);
+        } else {
+            _as.emit({0x48, 0xb8});         // mov rax, imm64
+            _as.imm64(int64_t(code->_entry));
+            _as.emit({0xff, 0xd0});         // call rax
+        }
+
+        if (!args.empty()) {
+            _as.emit({0x48, 0x81, 0xc4});   // add rsp, imm32
+            _as.imm32(int32_t(args.size() * 8));
+        }
+        // 被调函数 deopt 时整个调用链都放弃
+        _as.emit({0x48, 0x85, 0xd2});       // test rdx, rdx
+        _as.jcc(NOT_EQUAL, _bail);
+
+        _code->_bindings.push_back(Code::Binding{env.get(), identifier->value(), target.get()});
+        if (callee != _fn) {
+            auto& bindings = code->_bindings;
+            _code->_bindings.insert(_code->_bindings.end(), bindings.begin(), bindings.end());
+            _code->_callees.push_back(target);
+        }
+        return true;
+    }
+
+    // 被调函数已经编译过时直接使用，否则现在编译；不支持相互递归
+    std::shared_ptr<Code> callee_code(const object::Function* callee) {
+        auto& tier = callee->tier();
+        if (tier.code != nullptr || tier.rejected) {
+            return tier.code;
+        }
+        if (std::find(_active.begin(), _active.end(), callee) != _active.end()) {
+            return nullptr;
+        }
+
+        tier.code = Compiler(callee, _active).compile();
+        if (tier.code == nullptr) {
+            tier.rejected = true;
+        }
+        return tier.code;
+    }
+
+    void store_local(int32_t index) {
+        _as.emit({0x48, 0x89, 0x85});       // mov [rbp + disp32], rax
+        _as.imm32(local_offset(index));
+    }
+
+    static int32_t local_offset(int32_t index) {
+        return -16 - index * 8;
+    }
+private:
+    const object::Function* _fn;
+    std::vector<const object::Function*>& _active;
+    std::shared_ptr<Code> _code;
+    Assembler _as;
+    Label _entry = 0;
+    Label _exit = 0;
+    Label _bail = 0;
+    std::map<std::string, Slot> _slots;
+    int32_t _locals = 0;
+};
+
+bool supported() {
+    return true;
+}
+
+std::shared_ptr<Code> compile(const object::Function* fn) {
+    std::vector<const object::Function*> active;
+    return Compiler(fn, active).compile();
+}
+
+#else
+
+class Compiler {
+};
+
+bool supported() {
+    return false;
+}
+
+std::shared_ptr<Code> compile(const object::Function* fn) {
+    return nullptr;
+}
+
+#endif
+
+Code::~Code() {
+    if (_memory != nullptr) {
+        munmap(_memory, _size);
+    }
+}
+
+bool Code::valid() const {
+    for (auto& binding : _bindings) {
+        auto slot = binding.env->find(binding.name);
+        if (slot == nullptr || slot->get() != binding.target) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace jit
+} // namespace autumn
@@ -2,7 +2,7 @@
 #include <algorithm>
 namespace autumn {
 
-Lexer::Lexer(const std::string& input) :
+Lexer::Lexer(std::string_view input) :
     _input(input) {
     read_char();
 }
@@ -98,6 +98,9 @@ Token Lexer::next_token() {
             return Token{Token::lookup(ident), ident};
         } else if (is_digital(_ch)) {
             auto num = read_number();
+            if (num.find('.') != std::string::npos) {
+                return Token{Token::FLOAT, num};
+            }
             return Token{Token::INT, num};
         } else {
             return Token{Token::ILLEGAL, ""};
@@ -148,23 +151,31 @@ std::string Lexer::read_identifier() {
     while (is_letter(_ch)) {
         read_char();
     }
-    return _input.substr(pos, _pos - pos);
+    return std::string(_input.substr(pos, _pos - pos));
 }
 
+// 整数或小数，小数点后至少要有一位数字
 std::string Lexer::read_number() {
     int pos = _pos;
     while (is_digital(_ch)) {
         read_char();
     }
-    return _input.substr(pos, _pos - pos);
+    if (_ch == '.' && is_digital(peek_char())) {
+        read_char();
+        while (is_digital(_ch)) {
+            read_char();
+        }
+    }
+    return std::string(_input.substr(pos, _pos - pos));
 }
 
 std::string Lexer::read_string() {
     int pos = _pos + 1;
+    // 没有结束的引号时读到输入末尾为止
     do {
         read_char();
-    } while (_ch != '"');
-    return _input.substr(pos, _pos - pos);
+    } while (_ch != '"' && _ch != 0);
+    return std::string(_input.substr(pos, _pos - pos));
 }
 
 } // namespace autumn
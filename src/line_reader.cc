@@ -0,0 +1,71 @@
+#include "line_reader.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+
+namespace autumn {
+
+LineReader::LineReader(int fd, size_t chunk_size) :
+        _fd(fd),
+        _chunk_size(chunk_size),
+        _buffer(chunk_size) {
+}
+
+bool LineReader::next(std::string_view& line) {
+    size_t scanned = _begin;
+    while (true) {
+        auto p = static_cast<const char*>(
+                std::memchr(_buffer.data() + scanned, '\n', _end - scanned));
+        if (p != nullptr) {
+            size_t pos = p - _buffer.data();
+            line = std::string_view(_buffer.data() + _begin, pos - _begin);
+            _begin = pos + 1;
+            return true;
+        }
+
+        if (_eof) {
+            if (_begin == _end) {
+                return false;
+            }
+            line = std::string_view(_buffer.data() + _begin, _end - _begin);
+            _begin = _end;
+            return true;
+        }
+
+        // fill 会把数据移到开头，已经扫描过的部分不必再找
+        size_t pending = _end - _begin;
+        if (!fill()) {
+            _eof = true;
+        }
+        scanned = _begin + pending;
+    }
+}
+
+bool LineReader::fill() {
+    if (_begin != 0) {
+        std::memmove(_buffer.data(), _buffer.data() + _begin, _end - _begin);
+        _end -= _begin;
+        _begin = 0;
+    }
+
+    // 一行比缓冲区还长时扩大缓冲区
+    if (_buffer.size() - _end < _chunk_size / 2) {
+        _buffer.resize(_buffer.size() * 2);
+    }
+
+    while (true) {
+        ssize_t n = ::read(_fd, _buffer.data() + _end, _buffer.size() - _end);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        _end += n;
+        return true;
+    }
+}
+
+} // namespace autumn
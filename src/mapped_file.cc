@@ -0,0 +1,43 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace autumn {
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return;
+    }
+
+    // 长度为 0 的文件不能映射，当作空内容处理
+    _size = st.st_size;
+    if (_size != 0) {
+        void* addr = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd);
+            _size = 0;
+            return;
+        }
+        _addr = addr;
+    }
+    ::close(fd);
+    _ok = true;
+}
+
+MappedFile::~MappedFile() {
+    if (_addr != nullptr) {
+        ::munmap(_addr, _size);
+    }
+}
+
+} // namespace autumn
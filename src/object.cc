@@ -4,6 +4,8 @@
 namespace autumn {
 namespace object {
 
+static_assert(Type::TYPE_COUNT <= Stats::MAX_OBJECT_TYPES, "too many object types for Stats");
+
 namespace constants {
 
 std::shared_ptr<object::Object> Null(new object::Null);
@@ -18,11 +20,13 @@ std::unordered_map<int, std::string> Type::_type_to_name = {
     {STRING_OBJECT, "STRING"},
     {ERROR_OBJECT, "ERROR"},
     {NULL_OBJECT, "NULL"},
-    {RETURN_OBJECT, "RETURN"},
     {FUNCTION_OBJECT, "FUNCTION"},
     {BUILTIN_OBJECT, "BUILTIN"},
     {ARRAY_OBJECT, "ARRAY"},
     {HASH_OBJECT, "HASH"},
+    {INT_ARRAY_OBJECT, "INT_ARRAY"},
+    {BIGINT_OBJECT, "BIGINT"},
+    {FLOAT_OBJECT, "FLOAT"},
 };
 
 std::ostream& operator<<(std::ostream& out, const Type& type) {
@@ -0,0 +1,53 @@
+#include "output.h"
+
+#include <cerrno>
+
+#include <unistd.h>
+
+namespace autumn {
+
+Output::Output(Sink sink, size_t capacity) :
+        _sink(std::move(sink)),
+        _capacity(capacity) {
+    // 缓冲区按需增长，并行分块等短命的求值器不需要预先分配整块内存
+}
+
+Output::~Output() {
+    flush();
+}
+
+void Output::flush() {
+    if (_buffer.empty()) {
+        return;
+    }
+    _sink(_buffer);
+    _buffer.clear();
+}
+
+void Output::set_sink(Sink sink) {
+    flush();
+    _sink = std::move(sink);
+}
+
+Output::Sink Output::fd_sink(int fd) {
+    return [fd](std::string_view data) {
+        while (!data.empty()) {
+            ssize_t n = ::write(fd, data.data(), data.size());
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return;
+            }
+            data.remove_prefix(n);
+        }
+    };
+}
+
+Output::Sink Output::string_sink(std::string& target) {
+    return [&target](std::string_view data) {
+        target.append(data.data(), data.size());
+    };
+}
+
+} // namespace autumn
@@ -1,7 +1,9 @@
 #include "parser.h"
 
 #include <unordered_map>
+#include "builtin.h"
 #include "defer.h"
+#include "scope.h"
 
 namespace autumn {
 
@@ -9,6 +11,7 @@ namespace {
 
 // 操作符优先级表
 const std::unordered_map<Token::Type, Parser::Precedence> PRECEDENCES = {
+    {Token::ASSIGN, Parser::Precedence::ASSIGN},
     {Token::EQ, Parser::Precedence::EQUALS},
     {Token::NEQ, Parser::Precedence::EQUALS},
     {Token::LT, Parser::Precedence::LESSGREATER},
@@ -30,6 +33,7 @@ Parser::Parser() {
     // 注册前缀解析函数
     _prefix_parse_funcs[Token::IDENT] = std::bind(&Parser::parse_identifier, this);
     _prefix_parse_funcs[Token::INT] = std::bind(&Parser::parse_integer_literal, this);
+    _prefix_parse_funcs[Token::FLOAT] = std::bind(&Parser::parse_float_literal, this);
     _prefix_parse_funcs[Token::STRING] = std::bind(&Parser::parse_string_literal, this);
     _prefix_parse_funcs[Token::TRUE] = std::bind(&Parser::parse_boolean_literal, this);
     _prefix_parse_funcs[Token::FALSE] = std::bind(&Parser::parse_boolean_literal, this);
@@ -38,6 +42,8 @@ Parser::Parser() {
     _prefix_parse_funcs[Token::BANG] = std::bind(&Parser::parse_prefix_expression, this);
     _prefix_parse_funcs[Token::MINUS] = std::bind(&Parser::parse_prefix_expression, this);
     _prefix_parse_funcs[Token::IF] = std::bind(&Parser::parse_if_expression, this);
+    _prefix_parse_funcs[Token::WHILE] = std::bind(&Parser::parse_while_expression, this);
+    _prefix_parse_funcs[Token::FOR] = std::bind(&Parser::parse_for_expression, this);
     _prefix_parse_funcs[Token::LBRACKET] = std::bind(&Parser::parse_array_literal, this);
     _prefix_parse_funcs[Token::LBRACE] = std::bind(&Parser::parse_hash_literal, this);
 
@@ -55,13 +61,14 @@ Parser::Parser() {
     // 在 call 表达式中，形如 add(1, 2 * 3)，我们把 ( 看作是中缀操作符，且它有最高的优先级
     _infix_parse_funcs[Token::LPAREN] = std::bind(&Parser::parse_call_expression, this, _1);
     _infix_parse_funcs[Token::LBRACKET] = std::bind(&Parser::parse_index_expression, this, _1);
+    _infix_parse_funcs[Token::ASSIGN] = std::bind(&Parser::parse_assign_expression, this, _1);
 }
 
 const std::vector<std::string>& Parser::errors() const {
     return _errors;
 }
 
-std::unique_ptr<ast::Program> Parser::parse(const std::string& input) {
+std::unique_ptr<ast::Program> Parser::parse(std::string_view input) {
     Lexer lexer(input);
     _lexer = &lexer;
     _errors.clear();
@@ -84,6 +91,7 @@ std::unique_ptr<ast::Program> Parser::parse() {
         next_token();
     }
 
+    scope::resolve(*program);
     return program;
 }
 
@@ -241,10 +249,13 @@ std::unique_ptr<ast::Expression> Parser::parse_expression(Precedence precedence)
 
 std::unique_ptr<ast::Expression> Parser::parse_identifier() {
     Defer defer(_tracer.trace(__FUNCTION__, _current_token.literal));
-    return std::unique_ptr<ast::Expression>(new ast::Identifier(
+    std::unique_ptr<ast::Identifier> identifier(new ast::Identifier(
         _current_token,
         _current_token.literal
     ));
+    // 提前绑定同名内置函数，求值时不必再按名字查表
+    identifier->set_builtin(builtin::lookup(_current_token.literal));
+    return identifier;
 }
 
 std::unique_ptr<ast::Expression> Parser::parse_integer_literal() {
@@ -252,6 +263,11 @@ std::unique_ptr<ast::Expression> Parser::parse_integer_literal() {
     return std::unique_ptr<ast::Expression>(new ast::IntegerLiteral(_current_token));
 }
 
+std::unique_ptr<ast::Expression> Parser::parse_float_literal() {
+    Defer defer(_tracer.trace(__FUNCTION__, _current_token.literal));
+    return std::unique_ptr<ast::Expression>(new ast::FloatLiteral(_current_token));
+}
+
 std::unique_ptr<ast::Expression> Parser::parse_array_literal() {
     Defer defer(_tracer.trace(__FUNCTION__, _current_token.literal));
     std::unique_ptr<ast::ArrayLiteral> array_literal(new ast::ArrayLiteral(_current_token));
@@ -417,6 +433,77 @@ std::unique_ptr<ast::Expression> Parser::parse_if_expression() {
     return if_expression;
 }
 
+std::unique_ptr<ast::Expression> Parser::parse_while_expression() {
+    Defer defer(_tracer.trace(__FUNCTION__, _current_token.literal));
+    std::unique_ptr<ast::WhileExpression> while_expression(
+            new ast::WhileExpression(_current_token));
+
+    if (!expect_peek(Token::LPAREN)) {
+        return nullptr;
+    }
+
+    next_token();
+
+    auto exp = parse_expression(Precedence::LOWEST);
+    while_expression->set_condition(exp.release());
+
+    if (!expect_peek(Token::RPAREN)) {
+        return nullptr;
+    }
+
+    if (!expect_peek(Token::LBRACE)) {
+        return nullptr;
+    }
+
+    auto body = parse_block_statment();
+    if (body == nullptr) {
+        return nullptr;
+    }
+    while_expression->set_body(body.release());
+
+    return while_expression;
+}
+
+std::unique_ptr<ast::Expression> Parser::parse_for_expression() {
+    Defer defer(_tracer.trace(__FUNCTION__, _current_token.literal));
+    std::unique_ptr<ast::ForExpression> for_expression(
+            new ast::ForExpression(_current_token));
+
+    if (!expect_peek(Token::LPAREN)) {
+        return nullptr;
+    }
+
+    if (!expect_peek(Token::IDENT)) {
+        return nullptr;
+    }
+    for_expression->set_variable(new ast::Identifier(_current_token, _current_token.literal));
+
+    if (!expect_peek(Token::IN)) {
+        return nullptr;
+    }
+
+    next_token();
+
+    auto exp = parse_expression(Precedence::LOWEST);
+    for_expression->set_iterable(exp.release());
+
+    if (!expect_peek(Token::RPAREN)) {
+        return nullptr;
+    }
+
+    if (!expect_peek(Token::LBRACE)) {
+        return nullptr;
+    }
+
+    auto body = parse_block_statment();
+    if (body == nullptr) {
+        return nullptr;
+    }
+    for_expression->set_body(body.release());
+
+    return for_expression;
+}
+
 std::unique_ptr<ast::BlockStatment> Parser::parse_block_statment() {
     Defer defer(_tracer.trace(__FUNCTION__, _current_token.literal));
     std::unique_ptr<ast::BlockStatment> block_statment(
@@ -484,6 +571,28 @@ std::unique_ptr<ast::Expression> Parser::parse_index_expression(ast::Expression*
     return index_expression;
 }
 
+std::unique_ptr<ast::Expression> Parser::parse_assign_expression(ast::Expression* left) {
+    Defer defer(_tracer.trace(__FUNCTION__, _current_token.literal));
+    std::unique_ptr<ast::AssignExpression> assign_expression(
+            new ast::AssignExpression(_current_token));
+    assign_expression->set_target(left);
+
+    if (left == nullptr
+            || (left->cast<ast::Identifier>() == nullptr
+                && left->cast<ast::IndexExpression>() == nullptr)) {
+        _errors.push_back("invalid assignment target `"
+                + (left == nullptr ? std::string() : left->to_string()) + "`");
+        return nullptr;
+    }
+
+    // 赋值是右结合的：a = b = 1 解析为 (a = (b = 1))
+    next_token();
+    auto value = parse_expression(Precedence::LOWEST);
+    assign_expression->set_value(value.release());
+
+    return assign_expression;
+}
+
 std::vector<std::unique_ptr<ast::Expression>> Parser::parse_expression_list(Token::Type end) {
     Defer defer(_tracer.trace(__FUNCTION__, _current_token.literal));
     std::vector<std::unique_ptr<ast::Expression>> args;
@@ -0,0 +1,107 @@
+#include "profiler.h"
+
+#include <algorithm>
+
+namespace autumn {
+
+namespace {
+
+// 所有调用栈的根节点
+const char* ROOT_FRAME = "<program>";
+
+}
+
+Profiler::Profiler(std::chrono::microseconds interval) :
+        _interval(interval) {
+    for (auto& frame : _frames) {
+        frame.store(0, std::memory_order_relaxed);
+    }
+}
+
+Profiler::~Profiler() {
+    stop();
+}
+
+void Profiler::start() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running) {
+        return;
+    }
+    _running = true;
+    _thread = std::thread(&Profiler::run, this);
+}
+
+void Profiler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_running) {
+            return;
+        }
+        _running = false;
+    }
+    _cv.notify_all();
+    _thread.join();
+}
+
+uint32_t Profiler::intern(const std::string& frame) {
+    auto it = _ids.find(frame);
+    if (it != _ids.end()) {
+        return it->second;
+    }
+
+    uint32_t id = _names.size();
+    _names.push_back(frame);
+    _ids.emplace(frame, id);
+    return id;
+}
+
+void Profiler::enter(const std::string& frame) {
+    size_t depth = _depth.load(std::memory_order_relaxed);
+    if (depth < MAX_DEPTH) {
+        _frames[depth].store(intern(frame), std::memory_order_relaxed);
+    }
+    _depth.store(depth + 1, std::memory_order_release);
+}
+
+void Profiler::leave() {
+    _depth.store(_depth.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+}
+
+void Profiler::sample() {
+    size_t depth = std::min(_depth.load(std::memory_order_acquire), MAX_DEPTH);
+    std::vector<uint32_t> stack(depth);
+    for (size_t i = 0; i < depth; ++i) {
+        stack[i] = _frames[i].load(std::memory_order_relaxed);
+    }
+
+    ++_stacks[stack];
+    ++_samples;
+}
+
+void Profiler::run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_running) {
+        _cv.wait_for(lock, _interval);
+        if (_running) {
+            sample();
+        }
+    }
+}
+
+size_t Profiler::samples() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _samples;
+}
+
+void Profiler::write_collapsed(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& [stack, count] : _stacks) {
+        out << ROOT_FRAME;
+        for (auto id : stack) {
+            out << ';' << (id < _names.size() ? _names[id] : "?");
+        }
+        out << ' ' << count << '\n';
+    }
+}
+
+} // namespace autumn
@@ -0,0 +1,335 @@
+#include "scope.h"
+
+#include <cstdint>
+#include <map>
+#include <set>
+
+namespace autumn {
+namespace scope {
+
+namespace {
+
+struct Binding {
+    int count = 0;
+    // 被重新赋值，或者在循环中绑定
+    bool mutated = false;
+};
+
+// 一个函数（或整个程序）自身的作用域，不包括内层函数
+struct Scope {
+    std::map<std::string, Binding> bindings;
+    std::set<std::string> references;
+    std::vector<const ast::Identifier*> identifiers;
+    std::set<std::string> assigned;
+    std::vector<const ast::FunctionLiteral*> children;
+    // let name = fn ... 直接绑定的字面量
+    std::map<const ast::FunctionLiteral*, std::string> lets;
+};
+
+} // namespace
+
+class Resolver {
+public:
+    void program(const ast::Program& program) {
+        _complete = true;
+        Scope scope;
+        scan(program.statments(), scope, false, false);
+        mark(scope);
+        // 全局变量总是通过环境链访问，不需要捕获
+        for (auto child : scope.children) {
+            literal(child);
+        }
+    }
+
+    void function(
+            const std::vector<std::shared_ptr<ast::Identifier>>& parameters,
+            const ast::BlockStatment& body) {
+        Scope scope;
+        bind(parameters, scope);
+        scan(&body, scope, false, false);
+        finish(scope);
+
+        _scopes.push_back(&scope);
+        for (auto child : scope.children) {
+            literal(child);
+        }
+        _scopes.pop_back();
+    }
+private:
+    // 返回字面量的自由变量，包括内层函数引用而本层没有作为参数绑定的变量
+    std::set<std::string> literal(const ast::FunctionLiteral* literal) {
+        Scope scope;
+        bind(literal->parameters(), scope);
+        scan(literal->body().get(), scope, false, false);
+        finish(scope);
+
+        auto names = scope.references;
+        bool escapes = false;
+        _scopes.push_back(&scope);
+        mark(scope);
+        for (auto child : scope.children) {
+            auto free = this->literal(child);
+            names.insert(free.begin(), free.end());
+            // 没有捕获的闭包只持有全局环境（或自身），不会引用这一层的调用帧
+            escapes |= !child->_captures.empty();
+        }
+        _scopes.pop_back();
+
+        for (auto& param : literal->parameters()) {
+            names.erase(param->value());
+        }
+
+        literal->_captures.clear();
+        literal->_self.clear();
+        for (auto& name : names) {
+            auto binding = lookup(name);
+            if (binding == nullptr) {
+                // 堆快照中的函数体看不到原来的外层函数，找不到绑定的变量可能属于它们，
+                // 按可变变量处理：创建时沿环境链查找，找不到就保留整条环境链
+                if (!_complete) {
+                    literal->_captures.push_back({name, false});
+                }
+                continue;
+            }
+
+            bool immutable = binding->count == 1 && !binding->mutated;
+            if (immutable && !_scopes.empty()) {
+                auto let = _scopes.back()->lets.find(literal);
+                if (let != _scopes.back()->lets.end() && let->second == name
+                        && _scopes.back()->bindings.count(name) != 0) {
+                    literal->_self = name;
+                    continue;
+                }
+            }
+            literal->_captures.push_back({name, immutable});
+        }
+        literal->_escapes = escapes;
+        literal->_resolved = true;
+        return names;
+    }
+
+    // 标记只能解析到全局环境或内置函数的标识符
+    // 堆快照中的函数体看不到原来的外层函数，不做标记
+    void mark(const Scope& scope) const {
+        if (!_complete) {
+            return;
+        }
+        for (auto identifier : scope.identifiers) {
+            identifier->_global = lookup(identifier->value()) == nullptr;
+        }
+    }
+
+    // 最内层绑定该变量的外层函数
+    const Binding* lookup(const std::string& name) const {
+        for (auto it = _scopes.rbegin(); it != _scopes.rend(); ++it) {
+            auto found = (*it)->bindings.find(name);
+            if (found != (*it)->bindings.end()) {
+                return &found->second;
+            }
+        }
+        return nullptr;
+    }
+
+    static void bind(
+            const std::vector<std::shared_ptr<ast::Identifier>>& parameters,
+            Scope& scope) {
+        for (auto& param : parameters) {
+            ++scope.bindings[param->value()].count;
+        }
+    }
+
+    static void finish(Scope& scope) {
+        for (auto& name : scope.assigned) {
+            auto it = scope.bindings.find(name);
+            if (it != scope.bindings.end()) {
+                it->second.mutated = true;
+            }
+        }
+    }
+
+    static void scan(
+            const std::vector<std::unique_ptr<ast::Statment>>& statments,
+            Scope& scope, bool loop, bool nested) {
+        for (auto& stat : statments) {
+            scan(stat.get(), scope, loop, nested);
+        }
+    }
+
+    static void scan(
+            const std::vector<std::unique_ptr<ast::Expression>>& exps,
+            Scope& scope, bool loop, bool nested) {
+        for (auto& exp : exps) {
+            scan(exp.get(), scope, loop, nested);
+        }
+    }
+
+    // nested 为 true 时位于内层函数中，只记录赋值：内层函数对外层变量赋值同样使绑定可变
+    static void scan(const ast::Node* node, Scope& scope, bool loop, bool nested) {
+        if (node == nullptr) {
+            return;
+        }
+
+        if (auto n = node->cast<ast::BlockStatment>()) {
+            scan(n->statments(), scope, loop, nested);
+        } else if (auto n = node->cast<ast::ExpressionStatment>()) {
+            scan(n->expression(), scope, loop, nested);
+        } else if (auto n = node->cast<ast::LetStatment>()) {
+            if (!nested && n->identifier() != nullptr) {
+                auto& binding = scope.bindings[n->identifier()->value()];
+                ++binding.count;
+                binding.mutated |= loop;
+                if (auto literal = n->expression() == nullptr
+                        ? nullptr : n->expression()->cast<ast::FunctionLiteral>()) {
+                    scope.lets[literal] = n->identifier()->value();
+                }
+            }
+            scan(n->expression(), scope, loop, nested);
+        } else if (auto n = node->cast<ast::ReturnStatment>()) {
+            scan(n->expression(), scope, loop, nested);
+        } else if (auto n = node->cast<ast::Identifier>()) {
+            if (!nested) {
+                scope.references.insert(n->value());
+                scope.identifiers.push_back(n);
+            }
+        } else if (auto n = node->cast<ast::PrefixExpression>()) {
+            scan(n->right(), scope, loop, nested);
+        } else if (auto n = node->cast<ast::InfixExpression>()) {
+            scan(n->left(), scope, loop, nested);
+            scan(n->right(), scope, loop, nested);
+        } else if (auto n = node->cast<ast::IfExpression>()) {
+            scan(n->condition(), scope, loop, nested);
+            scan(n->consequence(), scope, loop, nested);
+            scan(n->alternative(), scope, loop, nested);
+        } else if (auto n = node->cast<ast::WhileExpression>()) {
+            scan(n->condition(), scope, loop, nested);
+            scan(n->body(), scope, true, nested);
+        } else if (auto n = node->cast<ast::ForExpression>()) {
+            if (!nested && n->variable() != nullptr) {
+                auto& binding = scope.bindings[n->variable()->value()];
+                ++binding.count;
+                binding.mutated = true;
+            }
+            scan(n->iterable(), scope, loop, nested);
+            scan(n->body(), scope, true, nested);
+        } else if (auto n = node->cast<ast::AssignExpression>()) {
+            // a[i][j] = v 修改的是 a 指向的容器，写时复制会让按值复制的 a 与原来的分开，同样算作可变
+            auto target = n->target();
+            while (auto index = target == nullptr ? nullptr : target->cast<ast::IndexExpression>()) {
+                target = index->left();
+            }
+            if (auto identifier = target == nullptr ? nullptr : target->cast<ast::Identifier>()) {
+                scope.assigned.insert(identifier->value());
+            }
+            scan(n->target(), scope, loop, nested);
+            scan(n->value(), scope, loop, nested);
+        } else if (auto n = node->cast<ast::FunctionLiteral>()) {
+            if (!nested) {
+                scope.children.push_back(n);
+            }
+            scan(n->body().get(), scope, false, true);
+        } else if (auto n = node->cast<ast::CallExpression>()) {
+            scan(n->function(), scope, loop, nested);
+            scan(n->arguments(), scope, loop, nested);
+        } else if (auto n = node->cast<ast::ArrayLiteral>()) {
+            scan(n->elements(), scope, loop, nested);
+        } else if (auto n = node->cast<ast::HashLiteral>()) {
+            for (auto& pair : n->pairs()) {
+                scan(pair.first.get(), scope, loop, nested);
+                scan(pair.second.get(), scope, loop, nested);
+            }
+        } else if (auto n = node->cast<ast::IndexExpression>()) {
+            scan(n->left(), scope, loop, nested);
+            scan(n->index(), scope, loop, nested);
+        }
+    }
+private:
+    // 外层函数的作用域，最内层在最后
+    std::vector<const Scope*> _scopes;
+    // 从整个程序开始分析，能看到所有外层函数
+    bool _complete = false;
+};
+
+void resolve(const ast::Program& program) {
+    Resolver().program(program);
+}
+
+void resolve(
+        const std::vector<std::shared_ptr<ast::Identifier>>& parameters,
+        const ast::BlockStatment& body) {
+    Resolver().function(parameters, body);
+}
+
+namespace {
+
+std::shared_ptr<object::Function> make_function(
+        const ast::FunctionLiteral* literal,
+        const std::shared_ptr<object::Environment>& env) {
+    auto fn = std::make_shared<object::Function>(literal->parameters(), literal->body(), env);
+    fn->set_stack_frame(!literal->escapes());
+    return fn;
+}
+
+} // namespace
+
+std::shared_ptr<object::Function> function(
+        const ast::FunctionLiteral* literal,
+        std::shared_ptr<object::Environment>& env) {
+    // 在全局作用域中创建的函数本来就只持有全局环境
+    if (!literal->resolved() || env->outer() == nullptr) {
+        return make_function(literal, env);
+    }
+
+    const std::shared_ptr<object::Environment>* global = &env;
+    while ((*global)->outer() != nullptr) {
+        global = &(*global)->outer();
+    }
+
+    // 新环境的外层：全局环境，或者绑定了可变变量的最内层环境
+    auto link = global;
+    size_t link_depth = SIZE_MAX;
+    std::vector<std::pair<const std::string*, const std::shared_ptr<object::Object>*>> copies;
+
+    for (auto& capture : literal->captures()) {
+        const std::shared_ptr<object::Object>* slot = nullptr;
+        size_t depth = 0;
+        const std::shared_ptr<object::Environment>* e = &env;
+        for (; *e != *global; e = &(*e)->outer(), ++depth) {
+            auto& store = (*e)->store();
+            auto it = store.find(capture.name);
+            if (it != store.end()) {
+                slot = &it->second;
+                break;
+            }
+        }
+
+        if (slot == nullptr) {
+            // 外层函数中的 let 还没有执行到，之后才会绑定，只能保留整条环境链
+            link = &env;
+            link_depth = 0;
+        } else if (!capture.immutable) {
+            if (depth < link_depth) {
+                link = e;
+                link_depth = depth;
+            }
+        } else {
+            copies.emplace_back(&capture.name, slot);
+        }
+    }
+
+    if (link == &env || (copies.empty() && literal->self().empty())) {
+        return make_function(literal, *link);
+    }
+
+    auto captured = std::make_shared<object::Environment>(*link);
+    for (auto& copy : copies) {
+        captured->set(*copy.first, *copy.second);
+    }
+    auto fn = make_function(literal, captured);
+    if (!literal->self().empty()) {
+        captured->set(literal->self(), fn);
+    }
+    return fn;
+}
+
+} // namespace scope
+} // namespace autumn
@@ -0,0 +1,447 @@
+#include "simd.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define AUTUMN_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace autumn {
+namespace simd {
+
+namespace {
+
+// 标量实现，溢出时 __builtin_*_overflow 同样写入补码回绕的结果
+namespace scalar {
+
+bool sum(const int64_t* data, size_t n, int64_t* out) {
+    // 用 128 位累加，只有最终结果超出范围才算溢出
+    __int128 ret = 0;
+    for (size_t i = 0; i < n; ++i) {
+        ret += data[i];
+    }
+    *out = int64_t(uint64_t(ret));
+    return ret != *out;
+}
+
+int64_t min(const int64_t* data, size_t n) {
+    int64_t ret = data[0];
+    for (size_t i = 1; i < n; ++i) {
+        ret = data[i] < ret ? data[i] : ret;
+    }
+    return ret;
+}
+
+int64_t max(const int64_t* data, size_t n) {
+    int64_t ret = data[0];
+    for (size_t i = 1; i < n; ++i) {
+        ret = data[i] > ret ? data[i] : ret;
+    }
+    return ret;
+}
+
+bool dot(const int64_t* a, const int64_t* b, size_t n, int64_t* out) {
+    int64_t ret = 0;
+    bool overflow = false;
+    for (size_t i = 0; i < n; ++i) {
+        int64_t product;
+        overflow |= __builtin_mul_overflow(a[i], b[i], &product);
+        overflow |= __builtin_add_overflow(ret, product, &ret);
+    }
+    *out = ret;
+    return overflow;
+}
+
+bool add(const int64_t* a, const int64_t* b, int64_t* out, size_t n) {
+    bool overflow = false;
+    for (size_t i = 0; i < n; ++i) {
+        overflow |= __builtin_add_overflow(a[i], b[i], &out[i]);
+    }
+    return overflow;
+}
+
+bool mul(const int64_t* a, const int64_t* b, int64_t* out, size_t n) {
+    bool overflow = false;
+    for (size_t i = 0; i < n; ++i) {
+        overflow |= __builtin_mul_overflow(a[i], b[i], &out[i]);
+    }
+    return overflow;
+}
+
+bool add_scalar(const int64_t* a, int64_t b, int64_t* out, size_t n) {
+    bool overflow = false;
+    for (size_t i = 0; i < n; ++i) {
+        overflow |= __builtin_add_overflow(a[i], b, &out[i]);
+    }
+    return overflow;
+}
+
+bool mul_scalar(const int64_t* a, int64_t b, int64_t* out, size_t n) {
+    bool overflow = false;
+    for (size_t i = 0; i < n; ++i) {
+        overflow |= __builtin_mul_overflow(a[i], b, &out[i]);
+    }
+    return overflow;
+}
+
+size_t filter_gt(const int64_t* data, size_t n, int64_t threshold, int64_t* out) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (data[i] > threshold) {
+            out[count++] = data[i];
+        }
+    }
+    return count;
+}
+
+} // namespace scalar
+
+#ifdef AUTUMN_HAVE_AVX2
+
+// AVX2 实现，每次处理 4 个 64 位整数，不足 4 个的尾部交给标量实现
+namespace avx2 {
+
+#define AUTUMN_AVX2 __attribute__((target("avx2")))
+
+AUTUMN_AVX2 inline __m256i load(const int64_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+AUTUMN_AVX2 inline void store(int64_t* p, __m256i v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+}
+
+// AVX2 没有 64 位乘法，用 32 位乘法拼出低 64 位：
+// a * b = alo * blo + ((ahi * blo + alo * bhi) << 32)
+AUTUMN_AVX2 inline __m256i mullo(__m256i a, __m256i b) {
+    __m256i lo = _mm256_mul_epu32(a, b);
+    __m256i cross = _mm256_add_epi64(
+            _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+            _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+// 有符号加法溢出当且仅当结果的符号与两个加数都不同，溢出的 lane 在 overflow 中符号位为 1
+AUTUMN_AVX2 inline __m256i checked_add(__m256i a, __m256i b, __m256i& overflow) {
+    __m256i r = _mm256_add_epi64(a, b);
+    overflow = _mm256_or_si256(overflow,
+            _mm256_and_si256(_mm256_xor_si256(r, a), _mm256_xor_si256(r, b)));
+    return r;
+}
+
+AUTUMN_AVX2 inline bool any_sign(__m256i v) {
+    return _mm256_movemask_pd(_mm256_castsi256_pd(v)) != 0;
+}
+
+// 记录不在 32 位有符号整数范围内的元素：x + 2^31 的高 32 位不为 0
+// 两个乘数都在这个范围内时乘积不会溢出
+AUTUMN_AVX2 inline void check_int32(__m256i v, __m256i& wide) {
+    __m256i bias = _mm256_set1_epi64x(int64_t(1) << 31);
+    wide = _mm256_or_si256(wide, _mm256_srli_epi64(_mm256_add_epi64(v, bias), 32));
+}
+
+AUTUMN_AVX2 inline bool any_bits(__m256i v) {
+    return !_mm256_testz_si256(v, v);
+}
+
+// 把 4 个 lane 依次加到 ret 上
+AUTUMN_AVX2 inline bool reduce_add(__m256i v, int64_t& ret) {
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+    bool overflow = false;
+    for (int j = 0; j < 4; ++j) {
+        overflow |= __builtin_add_overflow(ret, lanes[j], &ret);
+    }
+    return overflow;
+}
+
+AUTUMN_AVX2 bool sum(const int64_t* data, size_t n, int64_t* out) {
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    __m256i overflow = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = checked_add(acc0, load(data + i), overflow);
+        acc1 = checked_add(acc1, load(data + i + 4), overflow);
+    }
+    for (; i + 4 <= n; i += 4) {
+        acc0 = checked_add(acc0, load(data + i), overflow);
+    }
+
+    int64_t ret;
+    bool tail = scalar::sum(data + i, n - i, &ret);
+    tail |= reduce_add(checked_add(acc0, acc1, overflow), ret);
+    // 部分和溢出不代表总和溢出，交给标量实现精确判断
+    if (tail || any_sign(overflow)) {
+        return scalar::sum(data, n, out);
+    }
+    *out = ret;
+    return false;
+}
+
+AUTUMN_AVX2 int64_t min(const int64_t* data, size_t n) {
+    if (n < 4) {
+        return scalar::min(data, n);
+    }
+
+    __m256i cur = load(data);
+    size_t i = 4;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = load(data + i);
+        cur = _mm256_blendv_epi8(cur, v, _mm256_cmpgt_epi64(cur, v));
+    }
+
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), cur);
+    int64_t ret = scalar::min(lanes, 4);
+    if (i < n) {
+        int64_t tail = scalar::min(data + i, n - i);
+        ret = tail < ret ? tail : ret;
+    }
+    return ret;
+}
+
+AUTUMN_AVX2 int64_t max(const int64_t* data, size_t n) {
+    if (n < 4) {
+        return scalar::max(data, n);
+    }
+
+    __m256i cur = load(data);
+    size_t i = 4;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = load(data + i);
+        cur = _mm256_blendv_epi8(cur, v, _mm256_cmpgt_epi64(v, cur));
+    }
+
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), cur);
+    int64_t ret = scalar::max(lanes, 4);
+    if (i < n) {
+        int64_t tail = scalar::max(data + i, n - i);
+        ret = tail > ret ? tail : ret;
+    }
+    return ret;
+}
+
+AUTUMN_AVX2 bool dot(const int64_t* a, const int64_t* b, size_t n, int64_t* out) {
+    __m256i acc = _mm256_setzero_si256();
+    __m256i overflow = _mm256_setzero_si256();
+    __m256i wide = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i va = load(a + i);
+        __m256i vb = load(b + i);
+        check_int32(va, wide);
+        check_int32(vb, wide);
+        acc = checked_add(acc, mullo(va, vb), overflow);
+    }
+
+    int64_t ret;
+    bool tail = scalar::dot(a + i, b + i, n - i, &ret);
+    tail |= reduce_add(acc, ret);
+    // 乘数超出 32 位或累加溢出时不一定真的溢出，交给标量实现判断
+    if (tail || any_bits(wide) || any_sign(overflow)) {
+        return scalar::dot(a, b, n, out);
+    }
+    *out = ret;
+    return false;
+}
+
+AUTUMN_AVX2 bool add(const int64_t* a, const int64_t* b, int64_t* out, size_t n) {
+    __m256i overflow = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        store(out + i, checked_add(load(a + i), load(b + i), overflow));
+    }
+    return scalar::add(a + i, b + i, out + i, n - i) || any_sign(overflow);
+}
+
+AUTUMN_AVX2 bool mul(const int64_t* a, const int64_t* b, int64_t* out, size_t n) {
+    __m256i wide = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i va = load(a + i);
+        __m256i vb = load(b + i);
+        check_int32(va, wide);
+        check_int32(vb, wide);
+        store(out + i, mullo(va, vb));
+    }
+    bool tail = scalar::mul(a + i, b + i, out + i, n - i);
+    // out 可能与 a 或 b 相同，向量部分已经被覆盖，不能再交给标量实现重新计算
+    return tail || any_bits(wide);
+}
+
+AUTUMN_AVX2 bool add_scalar(const int64_t* a, int64_t b, int64_t* out, size_t n) {
+    __m256i v = _mm256_set1_epi64x(b);
+    __m256i overflow = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        store(out + i, checked_add(load(a + i), v, overflow));
+    }
+    return scalar::add_scalar(a + i, b, out + i, n - i) || any_sign(overflow);
+}
+
+AUTUMN_AVX2 bool mul_scalar(const int64_t* a, int64_t b, int64_t* out, size_t n) {
+    __m256i v = _mm256_set1_epi64x(b);
+    __m256i wide = _mm256_setzero_si256();
+    check_int32(v, wide);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i va = load(a + i);
+        check_int32(va, wide);
+        store(out + i, mullo(va, v));
+    }
+    return scalar::mul_scalar(a + i, b, out + i, n - i) || any_bits(wide);
+}
+
+AUTUMN_AVX2 size_t filter_gt(const int64_t* data, size_t n, int64_t threshold, int64_t* out) {
+    __m256i t = _mm256_set1_epi64x(threshold);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = load(data + i);
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(v, t)));
+        if (mask == 0) {
+            continue;
+        }
+        if (mask == 0xf) {
+            store(out + count, v);
+            count += 4;
+            continue;
+        }
+        for (int j = 0; j < 4; ++j) {
+            if (mask & (1 << j)) {
+                out[count++] = data[i + j];
+            }
+        }
+    }
+    return count + scalar::filter_gt(data + i, n - i, threshold, out + count);
+}
+
+#undef AUTUMN_AVX2
+
+} // namespace avx2
+
+#endif
+
+struct Kernels {
+    Isa isa;
+    bool (*sum)(const int64_t*, size_t, int64_t*);
+    int64_t (*min)(const int64_t*, size_t);
+    int64_t (*max)(const int64_t*, size_t);
+    bool (*dot)(const int64_t*, const int64_t*, size_t, int64_t*);
+    bool (*add)(const int64_t*, const int64_t*, int64_t*, size_t);
+    bool (*mul)(const int64_t*, const int64_t*, int64_t*, size_t);
+    bool (*add_scalar)(const int64_t*, int64_t, int64_t*, size_t);
+    bool (*mul_scalar)(const int64_t*, int64_t, int64_t*, size_t);
+    size_t (*filter_gt)(const int64_t*, size_t, int64_t, int64_t*);
+};
+
+const Kernels SCALAR_KERNELS = {
+    Isa::SCALAR,
+    scalar::sum,
+    scalar::min,
+    scalar::max,
+    scalar::dot,
+    scalar::add,
+    scalar::mul,
+    scalar::add_scalar,
+    scalar::mul_scalar,
+    scalar::filter_gt,
+};
+
+#ifdef AUTUMN_HAVE_AVX2
+const Kernels AVX2_KERNELS = {
+    Isa::AVX2,
+    avx2::sum,
+    avx2::min,
+    avx2::max,
+    avx2::dot,
+    avx2::add,
+    avx2::mul,
+    avx2::add_scalar,
+    avx2::mul_scalar,
+    avx2::filter_gt,
+};
+#endif
+
+bool supports(Isa isa) {
+    switch (isa) {
+    case Isa::SCALAR:
+        return true;
+    case Isa::AVX2:
+#ifdef AUTUMN_HAVE_AVX2
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+const Kernels* select(Isa isa) {
+#ifdef AUTUMN_HAVE_AVX2
+    if (isa == Isa::AVX2) {
+        return &AVX2_KERNELS;
+    }
+#endif
+    return &SCALAR_KERNELS;
+}
+
+// 首次使用时按 CPU 特性选择实现
+const Kernels*& kernels() {
+    static const Kernels* k = select(supports(Isa::AVX2) ? Isa::AVX2 : Isa::SCALAR);
+    return k;
+}
+
+} // namespace
+
+Isa isa() {
+    return kernels()->isa;
+}
+
+bool set_isa(Isa isa) {
+    if (!supports(isa)) {
+        return false;
+    }
+    kernels() = select(isa);
+    return true;
+}
+
+bool sum(const int64_t* data, size_t n, int64_t* out) {
+    return kernels()->sum(data, n, out);
+}
+
+int64_t min(const int64_t* data, size_t n) {
+    return kernels()->min(data, n);
+}
+
+int64_t max(const int64_t* data, size_t n) {
+    return kernels()->max(data, n);
+}
+
+bool dot(const int64_t* a, const int64_t* b, size_t n, int64_t* out) {
+    return kernels()->dot(a, b, n, out);
+}
+
+bool add(const int64_t* a, const int64_t* b, int64_t* out, size_t n) {
+    return kernels()->add(a, b, out, n);
+}
+
+bool mul(const int64_t* a, const int64_t* b, int64_t* out, size_t n) {
+    return kernels()->mul(a, b, out, n);
+}
+
+bool add(const int64_t* a, int64_t b, int64_t* out, size_t n) {
+    return kernels()->add_scalar(a, b, out, n);
+}
+
+bool mul(const int64_t* a, int64_t b, int64_t* out, size_t n) {
+    return kernels()->mul_scalar(a, b, out, n);
+}
+
+size_t filter_gt(const int64_t* data, size_t n, int64_t threshold, int64_t* out) {
+    return kernels()->filter_gt(data, n, threshold, out);
+}
+
+} // namespace simd
+} // namespace autumn
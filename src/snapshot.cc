@@ -0,0 +1,441 @@
+#include "snapshot.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+#include "builtin.h"
+#include "cache.h"
+#include "mapped_file.h"
+#include "object.h"
+
+namespace autumn {
+namespace snapshot {
+
+namespace {
+
+const char MAGIC[4] = {'A', 'T', 'M', 'S'};
+
+// 镜像只在本机使用，按本机字节序直接存放
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t payload_size;
+    // 负载的指纹，用来发现被截断或损坏的文件
+    uint64_t payload;
+};
+
+// 负载依次为：函数体、环境、对象、环境中的变量，每一段都只引用前面已经出现过的下标
+class Writer {
+public:
+    bool save(const object::Environment& root) {
+        uint32_t root_id = env(&root);
+        if (!_ok) {
+            return false;
+        }
+
+        u32(root_id);
+
+        u32(_codes.size());
+        for (auto& code : _codes) {
+            str(code);
+        }
+
+        u32(_envs.size());
+        for (auto e : _envs) {
+            auto outer = e->outer().get();
+            u32(outer == nullptr ? NONE : _env_ids[outer]);
+        }
+
+        u32(_object_count);
+        _out.append(_objects);
+
+        for (auto e : _envs) {
+            u32(e->store().size());
+            for (auto& binding : e->store()) {
+                str(binding.first);
+                u32(_object_ids[binding.second.get()]);
+            }
+        }
+        return true;
+    }
+
+    std::string release() {
+        return std::move(_out);
+    }
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // 外层环境总是先于内层分配下标
+    uint32_t env(const object::Environment* e) {
+        auto it = _env_ids.find(e);
+        if (it != _env_ids.end()) {
+            return it->second;
+        }
+
+        if (e->outer() != nullptr) {
+            env(e->outer().get());
+        }
+
+        uint32_t id = _envs.size();
+        _env_ids.emplace(e, id);
+        _envs.push_back(e);
+
+        for (auto& binding : e->store()) {
+            object(binding.second.get());
+        }
+        return id;
+    }
+
+    uint32_t code(const object::Function* fn) {
+        auto it = _code_ids.find(fn->body());
+        if (it != _code_ids.end()) {
+            return it->second;
+        }
+
+        uint32_t id = _codes.size();
+        _code_ids.emplace(fn->body(), id);
+        _codes.push_back(cache::encode(fn->parameters(), *fn->body()));
+        return id;
+    }
+
+    // 子对象先于父对象写出，恢复时按顺序构造即可
+    uint32_t object(const object::Object* obj) {
+        auto it = _object_ids.find(obj);
+        if (it != _object_ids.end()) {
+            return it->second;
+        }
+
+        std::string record;
+        record.push_back(char(obj->type().value()));
+
+        if (typeid(*obj) == typeid(object::Integer)) {
+            put(record, obj->cast<object::Integer>()->value());
+        } else if (typeid(*obj) == typeid(object::BigInt)) {
+            put_str(record, obj->cast<object::BigInt>()->value().to_string());
+        } else if (typeid(*obj) == typeid(object::Float)) {
+            put(record, obj->cast<object::Float>()->value());
+        } else if (typeid(*obj) == typeid(object::Boolean)) {
+            record.push_back(char(obj->cast<object::Boolean>()->value()));
+        } else if (typeid(*obj) == typeid(object::Null)) {
+        } else if (typeid(*obj) == typeid(object::String)) {
+            put_str(record, obj->cast<object::String>()->value());
+        } else if (typeid(*obj) == typeid(object::Error)) {
+            put_str(record, obj->cast<object::Error>()->message());
+        } else if (typeid(*obj) == typeid(object::Builtin)) {
+            put_str(record, obj->cast<object::Builtin>()->name());
+        } else if (typeid(*obj) == typeid(object::IntArray)) {
+            auto& values = obj->cast<object::IntArray>()->values();
+            put(record, uint32_t(values.size()));
+            record.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(int64_t));
+        } else if (typeid(*obj) == typeid(object::Array)) {
+            auto& elements = obj->cast<object::Array>()->elements();
+            put(record, uint32_t(elements.size()));
+            for (auto& e : elements) {
+                put(record, object(e.get()));
+            }
+        } else if (typeid(*obj) == typeid(object::Hash)) {
+            auto& pairs = obj->cast<object::Hash>()->pairs();
+            put(record, uint32_t(pairs.size()));
+            for (auto& pair : pairs) {
+                put(record, object(pair.second.first.get()));
+                put(record, object(pair.second.second.get()));
+            }
+        } else if (typeid(*obj) == typeid(object::Function)) {
+            auto fn = obj->cast<object::Function>();
+            put(record, code(fn));
+            put(record, env(fn->env().get()));
+        } else {
+            _ok = false;
+        }
+
+        uint32_t id = _object_count++;
+        _object_ids.emplace(obj, id);
+        _objects.append(record);
+        return id;
+    }
+
+    template <typename T>
+    static void put(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    static void put_str(std::string& out, const std::string& s) {
+        put(out, uint32_t(s.size()));
+        out.append(s);
+    }
+
+    void u32(uint32_t value) {
+        put(_out, value);
+    }
+
+    void str(const std::string& s) {
+        put_str(_out, s);
+    }
+private:
+    std::string _out;
+    bool _ok = true;
+
+    std::vector<const object::Environment*> _envs;
+    std::unordered_map<const object::Environment*, uint32_t> _env_ids;
+    std::vector<std::string> _codes;
+    std::unordered_map<const ast::BlockStatment*, uint32_t> _code_ids;
+    std::string _objects;
+    uint32_t _object_count = 0;
+    std::unordered_map<const object::Object*, uint32_t> _object_ids;
+};
+
+// 与 Writer 对应，读到非法数据时 _ok 置为 false，之后的读取都返回空值
+class Reader {
+public:
+    explicit Reader(std::string_view data) : _data(data) {
+    }
+
+    std::shared_ptr<object::Environment> load() {
+        uint32_t root = u32();
+
+        std::vector<std::pair<std::vector<std::shared_ptr<ast::Identifier>>, std::shared_ptr<ast::BlockStatment>>> codes(u32_count());
+        for (auto& code : codes) {
+            if (!cache::decode(str(), code.first, code.second)) {
+                return nullptr;
+            }
+        }
+
+        std::vector<std::shared_ptr<object::Environment>> envs(u32_count());
+        for (size_t i = 0; _ok && i < envs.size(); ++i) {
+            uint32_t outer = u32();
+            if (outer == UINT32_MAX) {
+                envs[i] = std::make_shared<object::Environment>();
+            } else if (outer < i) {
+                envs[i] = std::make_shared<object::Environment>(envs[outer]);
+            } else {
+                _ok = false;
+            }
+        }
+
+        std::vector<std::shared_ptr<object::Object>> objects(u32_count());
+        for (size_t i = 0; _ok && i < objects.size(); ++i) {
+            objects[i] = object(i, objects, codes, envs);
+        }
+
+        for (size_t i = 0; _ok && i < envs.size(); ++i) {
+            uint32_t count = u32();
+            for (uint32_t j = 0; _ok && j < count; ++j) {
+                auto name = str();
+                uint32_t id = u32();
+                if (id >= objects.size()) {
+                    _ok = false;
+                    break;
+                }
+                envs[i]->set(std::string(name), objects[id]);
+            }
+        }
+
+        if (!_ok || _pos != _data.size() || root >= envs.size()) {
+            return nullptr;
+        }
+        return envs[root];
+    }
+private:
+    template <typename Codes, typename Envs>
+    std::shared_ptr<object::Object> object(
+            size_t id,
+            const std::vector<std::shared_ptr<object::Object>>& objects,
+            Codes& codes,
+            Envs& envs) {
+        // 只能引用已经构造好的对象
+        auto ref = [&]() -> const std::shared_ptr<object::Object>& {
+            uint32_t i = u32();
+            if (i >= id) {
+                _ok = false;
+                return object::constants::Null;
+            }
+            return objects[i];
+        };
+
+        switch (u8()) {
+        case object::Type::INTEGER_OBJECT:
+            return std::make_shared<object::Integer>(get<int64_t>());
+        case object::Type::BIGINT_OBJECT: {
+            Bignum value;
+            if (!Bignum::parse(str(), value)) {
+                break;
+            }
+            return std::make_shared<object::BigInt>(std::move(value));
+        }
+        case object::Type::FLOAT_OBJECT:
+            return std::make_shared<object::Float>(get<double>());
+        case object::Type::BOOLEAN_OBJECT:
+            // true/false/null 在进程内只有一份，求值器按指针比较
+            return u8() ? object::constants::True : object::constants::False;
+        case object::Type::NULL_OBJECT:
+            return object::constants::Null;
+        case object::Type::STRING_OBJECT:
+            return std::make_shared<object::String>(std::string(str()));
+        case object::Type::ERROR_OBJECT:
+            return std::make_shared<object::Error>(std::string(str()));
+        case object::Type::BUILTIN_OBJECT: {
+            int index = builtin::lookup(std::string(str()));
+            if (index < 0) {
+                break;
+            }
+            return builtin::BUILTINS[index];
+        }
+        case object::Type::INT_ARRAY_OBJECT: {
+            uint32_t count = u32();
+            auto bytes = raw(size_t(count) * sizeof(int64_t));
+            std::vector<int64_t> values(count);
+            if (!bytes.empty()) {
+                std::memcpy(values.data(), bytes.data(), bytes.size());
+            }
+            return std::make_shared<object::IntArray>(std::move(values));
+        }
+        case object::Type::ARRAY_OBJECT: {
+            std::vector<std::shared_ptr<object::Object>> elements(u32_count());
+            for (auto& e : elements) {
+                e = ref();
+            }
+            return std::make_shared<object::Array>(std::move(elements));
+        }
+        case object::Type::HASH_OBJECT: {
+            auto ret = std::make_shared<object::Hash>();
+            uint32_t count = u32_count();
+            for (uint32_t i = 0; _ok && i < count; ++i) {
+                auto& key = ref();
+                auto& value = ref();
+                ret->append(key, value);
+            }
+            return ret;
+        }
+        case object::Type::FUNCTION_OBJECT: {
+            uint32_t code = u32();
+            uint32_t env = u32();
+            if (code >= codes.size() || env >= envs.size()) {
+                break;
+            }
+            return std::make_shared<object::Function>(codes[code].first, codes[code].second, envs[env]);
+        }
+        default:
+            break;
+        }
+
+        _ok = false;
+        return object::constants::Null;
+    }
+
+    bool need(size_t n) {
+        if (!_ok || _data.size() - _pos < n) {
+            _ok = false;
+            return false;
+        }
+        return true;
+    }
+
+    std::string_view raw(size_t n) {
+        if (!need(n)) {
+            return std::string_view();
+        }
+        auto ret = _data.substr(_pos, n);
+        _pos += n;
+        return ret;
+    }
+
+    template <typename T>
+    T get() {
+        T ret{};
+        auto bytes = raw(sizeof(T));
+        if (_ok) {
+            std::memcpy(&ret, bytes.data(), sizeof(T));
+        }
+        return ret;
+    }
+
+    uint8_t u8() {
+        return get<uint8_t>();
+    }
+
+    uint32_t u32() {
+        return get<uint32_t>();
+    }
+
+    // 元素个数，至少要有这么多字节剩余，避免损坏的文件导致巨大的分配
+    uint32_t u32_count() {
+        uint32_t ret = u32();
+        if (ret > _data.size() - _pos) {
+            _ok = false;
+            return 0;
+        }
+        return ret;
+    }
+
+    std::string_view str() {
+        return raw(u32());
+    }
+private:
+    std::string_view _data;
+    size_t _pos = 0;
+    bool _ok = true;
+};
+
+} // namespace
+
+bool save(const std::string& path, const object::Environment& env) {
+    Writer writer;
+    if (!writer.save(env)) {
+        return false;
+    }
+    std::string payload = writer.release();
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.payload_size = payload.size();
+    header.payload = cache::fingerprint(payload);
+
+    std::string tmp = path + ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(payload.data(), payload.size());
+        if (!out) {
+            out.close();
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<object::Environment> load(const std::string& path) {
+    MappedFile file(path);
+    if (!file.ok() || file.data().size() < sizeof(Header)) {
+        return nullptr;
+    }
+
+    Header header;
+    std::memcpy(&header, file.data().data(), sizeof(header));
+    auto payload = file.data().substr(sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+            || header.version != VERSION
+            || header.payload_size != payload.size()
+            || header.payload != cache::fingerprint(payload)) {
+        return nullptr;
+    }
+
+    Reader reader(payload);
+    return reader.load();
+}
+
+} // namespace snapshot
+} // namespace autumn
@@ -0,0 +1,161 @@
+#include "thread_pool.h"
+
+#include <chrono>
+#include <limits>
+
+namespace autumn {
+
+namespace {
+
+constexpr size_t NOT_WORKER = std::numeric_limits<size_t>::max();
+
+// 当前线程所属的线程池以及它在池中的下标
+thread_local ThreadPool* t_pool = nullptr;
+thread_local size_t t_index = NOT_WORKER;
+
+}
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    for (size_t i = 0; i < threads; ++i) {
+        _queues.emplace_back(new Queue);
+    }
+
+    for (size_t i = 0; i < threads; ++i) {
+        _threads.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_all();
+
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+}
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool(std::thread::hardware_concurrency());
+    return pool;
+}
+
+void ThreadPool::parallel_for(size_t n, const std::function<void(size_t)>& fn) {
+    if (n == 0) {
+        return;
+    }
+
+    struct Group {
+        std::atomic<size_t> remaining{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    auto group = std::make_shared<Group>();
+    group->remaining = n;
+
+    // 工作线程把任务放进自己的队列，其它线程轮流分发到各个队列
+    size_t self = t_pool == this ? t_index : NOT_WORKER;
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t target = self != NOT_WORKER ? self : i % _queues.size();
+        push(target, [group, &fn, i] {
+            fn(i);
+            if (--group->remaining == 0) {
+                std::lock_guard<std::mutex> lock(group->mutex);
+                group->cv.notify_all();
+            }
+        });
+    }
+
+    while (group->remaining > 0) {
+        if (try_run_one(self)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(group->mutex);
+        group->cv.wait_for(lock, std::chrono::microseconds(100), [&group] {
+            return group->remaining == 0;
+        });
+    }
+}
+
+void ThreadPool::push(size_t index, Task&& task) {
+    {
+        std::lock_guard<std::mutex> lock(_queues[index]->mutex);
+        _queues[index]->tasks.emplace_back(std::move(task));
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_pending;
+    _cv.notify_one();
+}
+
+bool ThreadPool::pop(size_t index, Task& task) {
+    auto& queue = *_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    --_pending;
+    return true;
+}
+
+bool ThreadPool::steal(size_t index, Task& task) {
+    size_t n = _queues.size();
+    size_t start = index == NOT_WORKER ? 0 : index + 1;
+
+    for (size_t i = 0; i < n; ++i) {
+        auto& queue = *_queues[(start + i) % n];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        --_pending;
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::try_run_one(size_t index) {
+    Task task;
+    if ((index != NOT_WORKER && pop(index, task)) || steal(index, task)) {
+        task();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t index) {
+    t_pool = this;
+    t_index = index;
+
+    while (true) {
+        if (try_run_one(index)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [this] {
+            return _stop || _pending > 0;
+        });
+
+        if (_stop && _pending == 0) {
+            return;
+        }
+    }
+}
+
+} // namespace autumn
@@ -9,6 +9,9 @@ std::map<std::string, Token::Type> Token::keywords = {
     {"if", Token::IF},
     {"else", Token::ELSE},
     {"return", Token::RETURN},
+    {"while", Token::WHILE},
+    {"for", Token::FOR},
+    {"in", Token::IN},
 };
 
 static std::map<Token::Type, std::string> s_token_type = {
@@ -38,11 +41,15 @@ static std::map<Token::Type, std::string> s_token_type = {
     {Token::IDENT, "IDENT"},
     {Token::FUNCTION, "FUNCTION"},
     {Token::INT, "INT"},
+    {Token::FLOAT, "FLOAT"},
     {Token::TRUE, "TRUE"},
     {Token::FALSE, "FALSE"},
     {Token::IF, "IF"},
     {Token::ELSE, "ELSE"},
     {Token::RETURN, "RETURN"},
+    {Token::WHILE, "WHILE"},
+    {Token::FOR, "FOR"},
+    {Token::IN, "IN"},
     {Token::STRING, "STRING"},
     {Token::END, "END"},
 };
@@ -0,0 +1,783 @@
+#include "transpiler.h"
+
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <unordered_map>
+
+#include "aot.h"
+#include "cache.h"
+
+namespace autumn {
+namespace aot {
+
+namespace {
+
+const std::string ANONYMOUS_FRAME = "<anonymous>";
+
+// C++ 字符串字面量，不可打印的字节一律写成三位八进制转义
+std::string quote(std::string_view text) {
+    std::string ret(1, '"');
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            ret.append(1, '\\');
+            ret.append(1, c);
+        } else if (c >= 0x20 && c < 0x7f && c != '?') {
+            ret.append(1, c);
+        } else {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\%03o", c);
+            ret.append(buf);
+        }
+    }
+    ret.append(1, '"');
+    return ret;
+}
+
+bool is_comparison(const std::string& op) {
+    return op == "<" || op == "<=" || op == ">" || op == ">="
+        || op == "==" || op == "!=";
+}
+
+class Generator {
+public:
+    Generator(const ast::Program& program, const std::string& name) :
+            _program(program),
+            _name(name),
+            _literals(function_literals(program)) {
+        for (size_t i = 0; i < _literals.size(); ++i) {
+            _indexes[_literals[i]] = i;
+        }
+    }
+
+    std::string generate(bool with_main);
+private:
+    // 名字、运算符和字符串字面量都放在常量池中，运行时不再构造 std::string
+    std::string constant(const std::string& value);
+    std::string temp() {
+        return "v" + std::to_string(_temps++);
+    }
+
+    void line(const std::string& text) {
+        _out->append(_indent * 4, ' ');
+        _out->append(text);
+        _out->append(1, '\n');
+    }
+    void open(const std::string& text) {
+        line(text.empty() ? "{" : text + " {");
+        ++_indent;
+    }
+    void close(const std::string& text = "}") {
+        --_indent;
+        line(text);
+    }
+    // 出错时把错误对象作为当前函数的结果
+    void check(const std::string& var) {
+        line("if (is_error(" + var + ")) return " + var + ";");
+    }
+
+    void function(size_t index);
+    // result 为空时丢弃语句序列的值
+    void statments(
+            const std::vector<std::unique_ptr<ast::Statment>>& statments,
+            const std::string& result);
+    std::string expression(const ast::Expression* exp);
+    std::string if_expression(const ast::IfExpression* exp);
+    std::string for_expression(const ast::ForExpression* exp);
+    std::string assign_expression(const ast::AssignExpression* exp);
+    std::string hash_literal(const ast::HashLiteral* exp);
+
+    // 整数快速路径，函数不满足条件时返回 false
+    bool fast(size_t index, std::string& self);
+    bool fast_statments(
+            const std::vector<std::unique_ptr<ast::Statment>>& statments,
+            const std::string* result,
+            bool top);
+    bool fast_expression(const ast::Expression* exp, std::string& var);
+    bool fast_condition(const ast::Expression* exp, std::string& cond);
+    bool fast_if(const ast::IfExpression* exp, const std::string* result);
+private:
+    const ast::Program& _program;
+    std::string _name;
+    std::vector<const ast::FunctionLiteral*> _literals;
+    std::unordered_map<const ast::FunctionLiteral*, size_t> _indexes;
+
+    std::unordered_map<std::string, std::string> _constants;
+    std::string _constant_defs;
+    std::string _natives;
+    std::string* _out = nullptr;
+    int _indent = 0;
+    size_t _temps = 0;
+
+    // 生成快速路径时的状态
+    struct Fast {
+        size_t index;
+        const ast::FunctionLiteral* literal;
+        // 变量名对应的 C++ 局部变量
+        std::unordered_map<std::string, std::string> locals;
+        // 所有形参和 let 定义的名字，被调函数不能与它们重名
+        std::set<std::string> names;
+        std::string self;
+    };
+    Fast* _fast = nullptr;
+};
+
+std::string Generator::constant(const std::string& value) {
+    auto it = _constants.find(value);
+    if (it != _constants.end()) {
+        return it->second;
+    }
+    auto name = "S" + std::to_string(_constants.size());
+    _constants[value] = name;
+    _constant_defs.append("const std::string " + name + "(" + quote(value)
+            + ", " + std::to_string(value.size()) + ");\n");
+    return name;
+}
+
+std::string Generator::generate(bool with_main) {
+    std::string run;
+    _out = &run;
+    _indent = 0;
+    _temps = 0;
+    open("Value run(const autumn::Evaluator& evaluator, Env& env)");
+    line("Runtime rt(evaluator);");
+    line("Value result;");
+    statments(_program.statments(), "result");
+    line("return result;");
+    close();
+
+    for (size_t i = 0; i < _literals.size(); ++i) {
+        function(i);
+    }
+
+    std::string ret;
+    ret.append("// 由 autumn compile 生成，请勿手动修改\n");
+    ret.append("#include <atomic>\n");
+    ret.append("#include <limits>\n");
+    ret.append("#include <typeinfo>\n\n");
+    ret.append("#include \"aot.h\"\n\n");
+    ret.append("namespace " + _name + " {\n\n");
+    ret.append("namespace object = autumn::object;\n");
+    ret.append("using autumn::aot::Env;\n");
+    ret.append("using autumn::aot::Runtime;\n");
+    ret.append("using autumn::aot::Value;\n");
+    ret.append("using autumn::aot::is_error;\n\n");
+
+    // 编码后的语法树，函数对象需要它
+    auto encoded = cache::encode(_program);
+    ret.append("const char ENCODED[] =\n");
+    for (size_t i = 0; i < encoded.size() || i == 0; i += 64) {
+        ret.append("    " + quote(std::string_view(encoded).substr(i, 64)));
+        ret.append(i + 64 >= encoded.size() ? ";\n\n" : "\n");
+    }
+
+    ret.append(_constant_defs);
+    ret.append("\n");
+
+    for (size_t i = 0; i < _literals.size(); ++i) {
+        ret.append("Value fn" + std::to_string(i)
+                + "(const autumn::Evaluator& evaluator, const object::Function* self, Env& env);\n");
+    }
+    ret.append("\nconst autumn::aot::Module& module() {\n");
+    ret.append("    static const autumn::aot::Module instance(\n");
+    ret.append("            std::string_view(ENCODED, sizeof(ENCODED) - 1),\n");
+    ret.append("            {");
+    for (size_t i = 0; i < _literals.size(); ++i) {
+        ret.append(i == 0 ? "" : ", ");
+        ret.append("fn" + std::to_string(i));
+    }
+    ret.append("});\n");
+    ret.append("    return instance;\n");
+    ret.append("}\n\n");
+
+    ret.append(_natives);
+    ret.append(run);
+    ret.append("\n} // namespace " + _name + "\n");
+
+    if (with_main) {
+        ret.append("\nint main(int argc, char* argv[]) {\n");
+        ret.append("    return autumn::aot::main(argc, argv, " + _name + "::run);\n");
+        ret.append("}\n");
+    }
+    return ret;
+}
+
+void Generator::function(size_t index) {
+    auto literal = _literals[index];
+    auto id = std::to_string(index);
+
+    std::string self;
+    bool has_fast = fast(index, self);
+
+    _out = &_natives;
+    _indent = 0;
+    _temps = 0;
+    open("Value fn" + id + "(const autumn::Evaluator& evaluator, const object::Function* self, Env& env)");
+    line("Runtime rt(evaluator);");
+    if (has_fast) {
+        auto& params = literal->parameters();
+        open("if (fast" + id + "_failures.load(std::memory_order_relaxed) < autumn::aot::MAX_FAST_FAILURES)");
+        std::string args;
+        std::string guard;
+        for (size_t i = 0; i < params.size(); ++i) {
+            line("int64_t a" + std::to_string(i) + ";");
+            guard.append(i == 0 ? "" : " && ");
+            guard.append("Runtime::integer_argument(env, " + constant(params[i]->value())
+                    + ", a" + std::to_string(i) + ")");
+            args.append("a" + std::to_string(i) + ", ");
+        }
+        if (!self.empty()) {
+            guard.append(params.empty() ? "" : " && ");
+            guard.append("Runtime::bound_to(env, " + constant(self) + ", self)");
+        }
+        if (guard.empty()) {
+            guard = "true";
+        }
+        open("if (" + guard + ")");
+        line("int64_t out;");
+        open("if (fast" + id + "(" + args + "out))");
+        line("return Runtime::integer(out);");
+        close();
+        line("fast" + id + "_failures.fetch_add(1, std::memory_order_relaxed);");
+        close();
+        close();
+    }
+    line("Value result;");
+    statments(literal->body()->statments(), "result");
+    line("return result;");
+    close();
+    _natives.append("\n");
+}
+
+void Generator::statments(
+        const std::vector<std::unique_ptr<ast::Statment>>& statments,
+        const std::string& result) {
+    for (size_t i = 0; i < statments.size(); ++i) {
+        auto stat = statments[i].get();
+        bool last = i + 1 == statments.size();
+
+        // 每条语句单独一个作用域，临时值及时释放，不影响写时复制的引用计数
+        open("");
+        if (auto n = stat->cast<ast::ExpressionStatment>()) {
+            auto val = expression(n->expression());
+            if (last && !result.empty()) {
+                line(result + " = std::move(" + val + ");");
+            }
+        } else if (auto n = stat->cast<ast::LetStatment>()) {
+            auto val = expression(n->expression());
+            line("env->set(" + constant(n->identifier()->value()) + ", " + val + ");");
+        } else if (auto n = stat->cast<ast::ReturnStatment>()) {
+            auto val = expression(n->expression());
+            line("return " + val + ";");
+        }
+        close();
+    }
+}
+
+std::string Generator::expression(const ast::Expression* exp) {
+    auto var = temp();
+
+    if (exp == nullptr) {
+        line("Value " + var + ";");
+
+    } else if (auto n = exp->cast<ast::IntegerLiteral>()) {
+        if (n->overflow()) {
+            line("Value " + var + " = Runtime::big_integer(" + quote(n->token_literal()) + ");");
+        } else {
+            line("Value " + var + " = Runtime::integer(int64_t(" + std::to_string(n->value()) + "));");
+        }
+
+    } else if (auto n = exp->cast<ast::FloatLiteral>()) {
+        std::string value;
+        if (std::isinf(n->value())) {
+            value = "std::numeric_limits<double>::infinity()";
+        } else {
+            // 十六进制浮点数，不丢失精度
+            char buf[64];
+            std::snprintf(buf, sizeof(buf), "%a", n->value());
+            value = buf;
+        }
+        line("Value " + var + " = Runtime::floating(" + value + ");");
+
+    } else if (auto n = exp->cast<ast::StringLiteral>()) {
+        line("Value " + var + " = Runtime::string(" + constant(n->value()) + ");");
+
+    } else if (auto n = exp->cast<ast::BooleanLiteral>()) {
+        line("Value " + var + " = Runtime::boolean(" + (n->value() ? "true" : "false") + ");");
+
+    } else if (auto n = exp->cast<ast::Identifier>()) {
+        line("Value " + var + " = rt.identifier(env, " + constant(n->value())
+                + ", " + std::to_string(n->builtin()) + ");");
+        check(var);
+
+    } else if (auto n = exp->cast<ast::PrefixExpression>()) {
+        auto right = expression(n->right());
+        line("Value " + var + " = rt.prefix(" + constant(n->op()) + ", " + right + ", env);");
+        check(var);
+
+    } else if (auto n = exp->cast<ast::InfixExpression>()) {
+        auto left = expression(n->left());
+        auto right = expression(n->right());
+        line("Value " + var + " = rt.infix(" + constant(n->op()) + ", "
+                + left + ", " + right + ", env);");
+        check(var);
+
+    } else if (auto n = exp->cast<ast::IfExpression>()) {
+        return if_expression(n);
+
+    } else if (auto n = exp->cast<ast::WhileExpression>()) {
+        line("Value " + var + " = object::constants::Null;");
+        if (n->condition() != nullptr && n->body() != nullptr) {
+            open("while (true)");
+            auto condition = expression(n->condition());
+            open("if (!rt.truthy(" + condition + "))");
+            line("break;");
+            close();
+            statments(n->body()->statments(), "");
+            close();
+        }
+
+    } else if (auto n = exp->cast<ast::ForExpression>()) {
+        return for_expression(n);
+
+    } else if (auto n = exp->cast<ast::AssignExpression>()) {
+        return assign_expression(n);
+
+    } else if (auto n = exp->cast<ast::FunctionLiteral>()) {
+        line("Value " + var + " = module().function(" + std::to_string(_indexes.at(n)) + ", env);");
+
+    } else if (auto n = exp->cast<ast::CallExpression>()) {
+        auto function = expression(n->function());
+        auto args = temp();
+        line("autumn::ArgumentList " + args + ";");
+        for (auto& arg : n->arguments()) {
+            auto val = expression(arg.get());
+            line(args + ".push_back(std::move(" + val + "));");
+        }
+        auto identifier = n->function()->cast<ast::Identifier>();
+        auto& frame = identifier != nullptr ? identifier->value() : ANONYMOUS_FRAME;
+        line("Value " + var + " = rt.call(" + constant(frame) + ", " + function + ", " + args + ");");
+        check(var);
+
+    } else if (auto n = exp->cast<ast::IndexExpression>()) {
+        auto left = expression(n->left());
+        auto index = expression(n->index());
+        line("Value " + var + " = rt.index(" + left + ", " + index + ");");
+        check(var);
+
+    } else if (auto n = exp->cast<ast::ArrayLiteral>()) {
+        auto elems = temp();
+        line("std::vector<Value> " + elems + ";");
+        line(elems + ".reserve(" + std::to_string(n->elements().size()) + ");");
+        for (auto& elem : n->elements()) {
+            auto val = expression(elem.get());
+            line(elems + ".push_back(std::move(" + val + "));");
+        }
+        line("Value " + var + " = std::make_shared<object::Array>(std::move(" + elems + "));");
+
+    } else if (auto n = exp->cast<ast::HashLiteral>()) {
+        return hash_literal(n);
+
+    } else {
+        line("Value " + var + ";");
+    }
+
+    return var;
+}
+
+std::string Generator::if_expression(const ast::IfExpression* exp) {
+    auto var = temp();
+    line("Value " + var + " = object::constants::Null;");
+    if (exp->condition() == nullptr) {
+        return var;
+    }
+
+    open("");
+    auto condition = expression(exp->condition());
+    if (exp->consequence() != nullptr) {
+        open("if (rt.truthy(" + condition + "))");
+        line(var + " = nullptr;");
+        statments(exp->consequence()->statments(), var);
+        close();
+    }
+    if (exp->alternative() != nullptr) {
+        open(exp->consequence() != nullptr ? "else" : "");
+        line(var + " = nullptr;");
+        statments(exp->alternative()->statments(), var);
+        close();
+    }
+    close();
+    return var;
+}
+
+std::string Generator::for_expression(const ast::ForExpression* exp) {
+    auto var = temp();
+    line("Value " + var + " = object::constants::Null;");
+    if (exp->variable() == nullptr || exp->iterable() == nullptr || exp->body() == nullptr) {
+        return var;
+    }
+
+    open("");
+    auto iterable = expression(exp->iterable());
+    auto name = constant(exp->variable()->value());
+    auto i = temp();
+    open("if (typeid(*" + iterable + ") == typeid(object::Array))");
+    line("auto& elems = " + iterable + "->cast<object::Array>()->elements();");
+    open("for (size_t " + i + " = 0; " + i + " < elems.size(); ++" + i + ")");
+    line("env->set(" + name + ", elems[" + i + "]);");
+    statments(exp->body()->statments(), "");
+    close();
+    close();
+    open("else if (typeid(*" + iterable + ") == typeid(object::IntArray))");
+    line("auto& values = " + iterable + "->cast<object::IntArray>()->values();");
+    open("for (size_t " + i + " = 0; " + i + " < values.size(); ++" + i + ")");
+    line("env->set(" + name + ", Runtime::integer(values[" + i + "]));");
+    statments(exp->body()->statments(), "");
+    close();
+    close();
+    open("else");
+    line("return rt.not_iterable(" + iterable + ");");
+    close();
+    close();
+    return var;
+}
+
+std::string Generator::assign_expression(const ast::AssignExpression* exp) {
+    auto val = expression(exp->value());
+    auto var = temp();
+
+    if (auto identifier = exp->target()->cast<ast::Identifier>()) {
+        line("Value " + var + " = rt.assign(env, " + constant(identifier->value()) + ", " + val + ");");
+        check(var);
+        return var;
+    }
+
+    // 与求值器相同：先从外到内求出所有下标，再从变量开始逐层修改
+    auto indexes = temp();
+    line("std::vector<Value> " + indexes + ";");
+    auto target = exp->target();
+    while (auto index_exp = target->cast<ast::IndexExpression>()) {
+        auto index = expression(index_exp->index());
+        line(indexes + ".push_back(std::move(" + index + "));");
+        target = index_exp->left();
+    }
+
+    if (auto identifier = target->cast<ast::Identifier>()) {
+        line("Value " + var + " = rt.assign_index(env, " + constant(identifier->value())
+                + ", " + indexes + ", " + val + ");");
+    } else {
+        line("Value " + var + " = rt.invalid_target(" + constant(exp->target()->to_string()) + ");");
+    }
+    check(var);
+    return var;
+}
+
+// 哈希字面量中键和值的错误不向外传递，每个键和值在单独的 lambda 中求值，
+// 出错时 lambda 的返回值就是错误对象
+std::string Generator::hash_literal(const ast::HashLiteral* exp) {
+    auto var = temp();
+    open("Value " + var + " = [&]() -> Value");
+    line("auto hash = std::make_shared<object::Hash>();");
+    for (auto& pair : exp->pairs()) {
+        open("");
+        std::string kv[2];
+        const ast::Expression* exps[2] = {pair.first.get(), pair.second.get()};
+        for (int i = 0; i < 2; ++i) {
+            kv[i] = temp();
+            open("Value " + kv[i] + " = [&]() -> Value");
+            auto val = expression(exps[i]);
+            line("return " + val + ";");
+            close("}();");
+        }
+        open("if (" + kv[0] + " == nullptr || " + kv[1] + " == nullptr)");
+        line("return nullptr;");
+        close();
+        line("hash->append(" + kv[0] + ", " + kv[1] + ");");
+        close();
+    }
+    line("return hash;");
+    close("}();");
+    return var;
+}
+
+bool Generator::fast(size_t index, std::string& self) {
+    auto literal = _literals[index];
+    auto id = std::to_string(index);
+    auto& params = literal->parameters();
+    auto& body = literal->body()->statments();
+
+    Fast fast{index, literal, {}, {}, {}};
+    for (auto& param : params) {
+        fast.names.insert(param->value());
+    }
+    for (auto& stat : body) {
+        if (auto let = stat->cast<ast::LetStatment>()) {
+            fast.names.insert(let->identifier()->value());
+        }
+    }
+
+    std::string code;
+    _out = &code;
+    _indent = 0;
+    _temps = 0;
+    _fast = &fast;
+
+    std::string signature = "bool fast" + id + "(";
+    for (size_t i = 0; i < params.size(); ++i) {
+        signature.append("int64_t p" + std::to_string(i) + ", ");
+    }
+    signature.append("int64_t& out)");
+    open(signature);
+    for (size_t i = 0; i < params.size(); ++i) {
+        auto local = "x" + std::to_string(i);
+        line("int64_t " + local + " = p" + std::to_string(i) + ";");
+        fast.locals[params[i]->value()] = local;
+    }
+
+    bool ok = !body.empty() && fast_statments(body, nullptr, true);
+    close();
+    _fast = nullptr;
+    if (!ok) {
+        return false;
+    }
+
+    self = fast.self;
+    _natives.append("bool fast" + id + "(");
+    for (size_t i = 0; i < params.size(); ++i) {
+        _natives.append("int64_t p" + std::to_string(i) + ", ");
+    }
+    _natives.append("int64_t& out);\n");
+    _natives.append("std::atomic<uint32_t> fast" + id + "_failures{0};\n\n");
+    _natives.append(code);
+    _natives.append("\n");
+    return true;
+}
+
+// result 为空时：语句序列位于函数体的末尾（top）时最后一个值就是返回值，否则丢弃
+bool Generator::fast_statments(
+        const std::vector<std::unique_ptr<ast::Statment>>& statments,
+        const std::string* result,
+        bool top) {
+    for (size_t i = 0; i < statments.size(); ++i) {
+        auto stat = statments[i].get();
+        bool last = i + 1 == statments.size();
+
+        if (auto n = stat->cast<ast::LetStatment>()) {
+            // 只允许函数体顶层的 let，且函数不能以 let 结尾（返回 null）
+            if (!top || last) {
+                return false;
+            }
+            std::string val;
+            if (!fast_expression(n->expression(), val)) {
+                return false;
+            }
+            auto& name = n->identifier()->value();
+            auto it = _fast->locals.find(name);
+            if (it != _fast->locals.end()) {
+                line(it->second + " = " + val + ";");
+            } else {
+                auto local = "x" + std::to_string(_fast->locals.size());
+                line("int64_t " + local + " = " + val + ";");
+                _fast->locals[name] = local;
+            }
+        } else if (auto n = stat->cast<ast::ReturnStatment>()) {
+            std::string val;
+            if (!fast_expression(n->expression(), val)) {
+                return false;
+            }
+            line("out = " + val + ";");
+            line("return true;");
+        } else if (auto n = stat->cast<ast::ExpressionStatment>()) {
+            auto exp = n->expression();
+            bool value = last && (result != nullptr || top);
+            if (auto if_exp = exp->cast<ast::IfExpression>()) {
+                if (!value) {
+                    if (!fast_if(if_exp, nullptr)) {
+                        return false;
+                    }
+                    continue;
+                }
+                auto var = "t" + std::to_string(_temps++);
+                line("int64_t " + var + " = 0;");
+                if (!fast_if(if_exp, &var)) {
+                    return false;
+                }
+                line((top ? "out = " : *result + " = ") + var + ";");
+            } else {
+                std::string val;
+                if (!fast_expression(exp, val)) {
+                    return false;
+                }
+                if (value) {
+                    line((top ? "out = " : *result + " = ") + val + ";");
+                }
+            }
+            if (value && top) {
+                line("return true;");
+            }
+        } else {
+            return false;
+        }
+    }
+
+    // 作为值的语句序列必须以表达式或 return 结尾，否则结果是 null
+    if (result != nullptr || top) {
+        if (statments.empty()) {
+            return false;
+        }
+        auto last = statments.back().get();
+        if (last->cast<ast::ExpressionStatment>() == nullptr
+                && last->cast<ast::ReturnStatment>() == nullptr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Generator::fast_if(const ast::IfExpression* exp, const std::string* result) {
+    // 作为值时必须有 else，否则条件不成立时结果是 null
+    if (exp->condition() == nullptr || exp->consequence() == nullptr
+            || (result != nullptr && exp->alternative() == nullptr)) {
+        return false;
+    }
+    std::string cond;
+    if (!fast_condition(exp->condition(), cond)) {
+        return false;
+    }
+    open("if (" + cond + ")");
+    if (!fast_statments(exp->consequence()->statments(), result, false)) {
+        return false;
+    }
+    close();
+    if (exp->alternative() != nullptr) {
+        open("else");
+        if (!fast_statments(exp->alternative()->statments(), result, false)) {
+            return false;
+        }
+        close();
+    }
+    return true;
+}
+
+bool Generator::fast_condition(const ast::Expression* exp, std::string& cond) {
+    auto n = exp->cast<ast::InfixExpression>();
+    if (n == nullptr || !is_comparison(n->op())) {
+        return false;
+    }
+    std::string left, right;
+    if (!fast_expression(n->left(), left) || !fast_expression(n->right(), right)) {
+        return false;
+    }
+    cond = left + " " + n->op() + " " + right;
+    return true;
+}
+
+// 整数运算溢出、除以 0 时放弃快速路径，由通用版本从头执行（函数没有副作用）
+bool Generator::fast_expression(const ast::Expression* exp, std::string& var) {
+    if (exp == nullptr) {
+        return false;
+    }
+
+    if (auto n = exp->cast<ast::IntegerLiteral>()) {
+        if (n->overflow()) {
+            return false;
+        }
+        var = "int64_t(" + std::to_string(n->value()) + ")";
+        return true;
+
+    } else if (auto n = exp->cast<ast::Identifier>()) {
+        auto it = _fast->locals.find(n->value());
+        if (it == _fast->locals.end()) {
+            return false;
+        }
+        var = it->second;
+        return true;
+
+    } else if (auto n = exp->cast<ast::PrefixExpression>()) {
+        std::string right;
+        if (n->op() != "-" || !fast_expression(n->right(), right)) {
+            return false;
+        }
+        var = "t" + std::to_string(_temps++);
+        line("int64_t " + var + ";");
+        open("if (__builtin_sub_overflow(int64_t(0), " + right + ", &" + var + "))");
+        line("return false;");
+        close();
+        return true;
+
+    } else if (auto n = exp->cast<ast::InfixExpression>()) {
+        static const std::unordered_map<std::string, std::string> BUILTINS = {
+            {"+", "__builtin_add_overflow"},
+            {"-", "__builtin_sub_overflow"},
+            {"*", "__builtin_mul_overflow"},
+        };
+        auto& op = n->op();
+        if (op != "/" && BUILTINS.count(op) == 0) {
+            return false;
+        }
+        std::string left, right;
+        if (!fast_expression(n->left(), left) || !fast_expression(n->right(), right)) {
+            return false;
+        }
+        var = "t" + std::to_string(_temps++);
+        line("int64_t " + var + ";");
+        if (op == "/") {
+            open("if (" + right + " == 0 || (" + right + " == -1 && "
+                    + left + " == std::numeric_limits<int64_t>::min()))");
+            line("return false;");
+            close();
+            line(var + " = " + left + " / " + right + ";");
+        } else {
+            open("if (" + BUILTINS.at(op) + "(" + left + ", " + right + ", &" + var + "))");
+            line("return false;");
+            close();
+        }
+        return true;
+
+    } else if (auto n = exp->cast<ast::IfExpression>()) {
+        var = "t" + std::to_string(_temps++);
+        line("int64_t " + var + " = 0;");
+        return fast_if(n, &var);
+
+    } else if (auto n = exp->cast<ast::CallExpression>()) {
+        // 只能调用自身：名字不是形参或局部变量，运行时由入口守卫确认它绑定到当前函数
+        auto identifier = n->function()->cast<ast::Identifier>();
+        if (identifier == nullptr || _fast->names.count(identifier->value()) != 0) {
+            return false;
+        }
+        if (!_fast->self.empty() && _fast->self != identifier->value()) {
+            return false;
+        }
+        _fast->self = identifier->value();
+
+        auto& params = _fast->literal->parameters();
+        if (n->arguments().size() != params.size()) {
+            return false;
+        }
+        std::string args;
+        for (auto& arg : n->arguments()) {
+            std::string val;
+            if (!fast_expression(arg.get(), val)) {
+                return false;
+            }
+            args.append(val + ", ");
+        }
+        var = "t" + std::to_string(_temps++);
+        line("int64_t " + var + ";");
+        open("if (!fast" + std::to_string(_fast->index) + "(" + args + var + "))");
+        line("return false;");
+        close();
+        return true;
+    }
+
+    return false;
+}
+
+}
+
+std::string transpile(const ast::Program& program, const std::string& name, bool with_main) {
+    return Generator(program, name).generate(with_main);
+}
+
+} // namespace aot
+} // namespace autumn
@@ -0,0 +1,127 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "evaluator.h"
+#include "transpiler.h"
+
+using namespace autumn;
+
+namespace {
+
+std::string inspect(const std::shared_ptr<const object::Object>& result) {
+    return result == nullptr ? "nullptr" : result->inspect();
+}
+
+}
+
+// 把所有程序翻译到同一个文件中，只调用一次编译器，结果应当与解释执行完全相同
+TEST(Aot, TestSameAsEvaluator) {
+    std::vector<std::string> tests = {
+        "1 + 2 * 3 - 4 / 2",
+        "9223372036854775807 + 1",
+        "99999999999999999999 * 2",
+        "1.5 * 2 + 0.25",
+        "\"hello\" + \" \" + \"world\"",
+        "\"a\" == \"a\"",
+        "!true == false",
+        "-5 < 3",
+        "if (1 > 2) { 10 }",
+        "if (1 > 2) { 10 } else { 20 }",
+        "if (true) { }",
+        "let x = 5; x",
+        "let x = 5;",
+        "return 3; 4",
+        "5 * \"a\"",
+        "foo",
+        "1 / 0",
+        "let f = fn(x) { return x * 2; x }; f(21)",
+        "let add = fn(a) { fn(b) { a + b } }; let plus = add(2); plus(40)",
+        "let fib = fn(n) { if (n < 2) { n } else { fib(n - 1) + fib(n - 2) } }; fib(20)",
+        "let fact = fn(n) { if (n < 2) { return 1; } n * fact(n - 1) }; fact(30)",
+        "let f = fn(a, b) { let c = a * b; let d = c - a / b; if (d > 10) { d } else { -d } }; [f(7, 3), f(1, 3)]",
+        "let f = fn(n) { if (n == 0) { 1 } else { f(n - 1) * 1 / (n - n) } }; f(3)",
+        "let f = fn(n) { n + 1 }; let g = f; let f = 1; g(1)",
+        "let f = fn(n) { if (n < 1) { 0 } else { f(n - 1) + 1 } }; f(\"x\")",
+        "let even = fn(n) { if (n == 0) { true } else { odd(n - 1) } }; "
+            "let odd = fn(n) { if (n == 0) { false } else { even(n - 1) } }; even(10)",
+        "fn(x, y) { x + y }",
+        "let a = [1, 2, 3]; a[0] = 10; a[-1] = 30; a",
+        "let a = [1, 2]; let b = a; b[0] = 5; [a, b]",
+        "let a = [[1, 2], [3, 4]]; a[1][0] = 9; a",
+        "let h = {\"a\": 1}; h[\"b\"] = 2; h[\"a\"] = 3; [h[\"a\"], h[\"b\"], h[\"c\"]]",
+        "let h = {\"a\": 1 + \"x\", 1 + \"y\": 2, [1]: 3, \"b\": 4}; h",
+        "let a = [1]; a[5] = 1",
+        "b = 1",
+        "[1][0] = 2",
+        "let s = 0; for (x in [1, 2, 3]) { s = s + x; } s",
+        "let s = 0; for (x in int_array([4, 5, 6])) { s = s + x; } s",
+        "for (x in 1) { x }",
+        "let i = 0; let s = 0; while (i < 10) { i = i + 1; if (i == 5) { s = s * 100 } s = s + i; } s",
+        "let f = fn() { let i = 0; while (true) { i = i + 1; if (i > 3) { return i; } } }; f()",
+        "len(\"abcd\") + len([1, 2])",
+        "pmap([1, 2, 3], fn(x) { x * x })",
+        "preduce([1, 2, 3, 4], fn(a, b) { a + b })",
+        "let len = fn(x) { 42 }; len(\"a\")",
+        "let f = fn(x) { x }; f()",
+        "5(1)",
+        "[1, 2 * \"a\", 3]",
+        "len(1)",
+        "{1: if (false) { 2 }}",
+    };
+
+    std::string source;
+    for (size_t i = 0; i < tests.size(); ++i) {
+        Parser parser;
+        auto program = parser.parse(tests[i]);
+        ASSERT_TRUE(parser.errors().empty()) << tests[i];
+        source.append(aot::transpile(*program, "p" + std::to_string(i), false));
+    }
+    source.append("\n#include <iostream>\n\nint main() {\n");
+    source.append("    autumn::Evaluator::Native programs[] = {");
+    for (size_t i = 0; i < tests.size(); ++i) {
+        source.append(i == 0 ? "" : ", ");
+        source.append("p" + std::to_string(i) + "::run");
+    }
+    source.append("};\n");
+    source.append("    for (auto program : programs) {\n");
+    source.append("        autumn::Evaluator evaluator;\n");
+    source.append("        auto result = evaluator.eval_native(program);\n");
+    source.append("        std::cout << (result == nullptr ? \"nullptr\" : result->inspect()) << '\\0';\n");
+    source.append("    }\n");
+    source.append("}\n");
+
+    std::string path = "aot_test_program";
+    {
+        std::ofstream out(path + ".cc");
+        out << source;
+    }
+    std::string command = "g++ -std=c++17 -I../include -o " + path + " " + path + ".cc "
+        "-L../lib -lautumn -lpthread";
+    ASSERT_EQ(std::system(command.c_str()), 0);
+
+    FILE* pipe = popen(("./" + path).c_str(), "r");
+    ASSERT_NE(pipe, nullptr);
+    std::string output;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), pipe)) > 0) {
+        output.append(buf, n);
+    }
+    ASSERT_EQ(pclose(pipe), 0);
+    std::remove((path + ".cc").c_str());
+    std::remove(path.c_str());
+
+    std::vector<std::string> results;
+    size_t start = 0;
+    for (size_t end; (end = output.find('\0', start)) != std::string::npos; start = end + 1) {
+        results.push_back(output.substr(start, end - start));
+    }
+    ASSERT_EQ(results.size(), tests.size());
+
+    for (size_t i = 0; i < tests.size(); ++i) {
+        Evaluator evaluator;
+        EXPECT_EQ(results[i], inspect(evaluator.eval(tests[i]))) << tests[i];
+    }
+}
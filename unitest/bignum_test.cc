@@ -0,0 +1,103 @@
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <gtest/gtest.h>
+#include "bignum.h"
+
+using namespace autumn;
+
+namespace {
+
+Bignum parse(const std::string& text) {
+    Bignum ret;
+    EXPECT_TRUE(Bignum::parse(text, ret)) << text;
+    return ret;
+}
+
+TEST(Bignum, TestParse) {
+    std::vector<std::string> tests = {
+        "0",
+        "1",
+        "-1",
+        "4294967295",
+        "4294967296",
+        "-9223372036854775808",
+        "123456789012345678901234567890",
+        "-1000000000000000000000000000000000000",
+    };
+
+    for (auto& text : tests) {
+        EXPECT_EQ(text, parse(text).to_string());
+    }
+
+    Bignum value;
+    EXPECT_FALSE(Bignum::parse("", value));
+    EXPECT_FALSE(Bignum::parse("-", value));
+    EXPECT_FALSE(Bignum::parse("12a", value));
+    EXPECT_EQ("0", parse("-0").to_string());
+    EXPECT_EQ("7", parse("0007").to_string());
+}
+
+TEST(Bignum, TestInt64) {
+    std::vector<int64_t> tests = {0, 1, -1, INT64_MAX, INT64_MIN, 4294967296, -4294967297};
+    for (auto v : tests) {
+        Bignum value(v);
+        EXPECT_TRUE(value.fits_int64());
+        EXPECT_EQ(v, value.to_int64());
+        EXPECT_EQ(std::to_string(v), value.to_string());
+    }
+
+    EXPECT_FALSE(parse("9223372036854775808").fits_int64());
+    EXPECT_TRUE(parse("-9223372036854775808").fits_int64());
+    EXPECT_FALSE(parse("-9223372036854775809").fits_int64());
+}
+
+TEST(Bignum, TestArithmetic) {
+    std::vector<std::tuple<std::string, char, std::string, std::string>> tests = {
+        {"9223372036854775807", '+', "1", "9223372036854775808"},
+        {"-9223372036854775808", '-', "1", "-9223372036854775809"},
+        {"1", '-', "100000000000000000000", "-99999999999999999999"},
+        {"-5", '+', "5", "0"},
+        {"18446744073709551616", '*', "18446744073709551616", "340282366920938463463374607431768211456"},
+        {"-3", '*', "100000000000000000000", "-300000000000000000000"},
+        {"0", '*', "-100000000000000000000", "0"},
+        {"340282366920938463463374607431768211456", '/', "18446744073709551616", "18446744073709551616"},
+        {"340282366920938463463374607431768211457", '/', "18446744073709551617", "18446744073709551615"},
+        {"-100000000000000000000", '/', "3", "-33333333333333333333"},
+        {"7", '/', "-100000000000000000000", "0"},
+        {"-100000000000000000000", '/', "-100000000000000000000", "1"},
+    };
+
+    for (auto& test : tests) {
+        auto lhs = parse(std::get<0>(test));
+        auto rhs = parse(std::get<2>(test));
+        Bignum result;
+        switch (std::get<1>(test)) {
+        case '+':
+            result = lhs + rhs;
+            break;
+        case '-':
+            result = lhs - rhs;
+            break;
+        case '*':
+            result = lhs * rhs;
+            break;
+        case '/':
+            result = lhs / rhs;
+            break;
+        }
+        EXPECT_EQ(std::get<3>(test), result.to_string())
+            << std::get<0>(test) << ' ' << std::get<1>(test) << ' ' << std::get<2>(test);
+    }
+}
+
+TEST(Bignum, TestCompare) {
+    EXPECT_EQ(0, compare(parse("100000000000000000000"), parse("100000000000000000000")));
+    EXPECT_EQ(-1, compare(parse("-100000000000000000000"), parse("1")));
+    EXPECT_EQ(1, compare(parse("100000000000000000000"), parse("99999999999999999999")));
+    EXPECT_EQ(1, compare(parse("-1"), parse("-100000000000000000000")));
+    EXPECT_EQ(parse("100000000000000000000").hash(), parse("100000000000000000000").hash());
+}
+
+}
@@ -1,6 +1,7 @@
 #include <any>
 #include <string>
 #include <tuple>
+#include <vector>
 #include <gtest/gtest.h>
 #include "evaluator.h"
 
@@ -165,4 +166,452 @@ TEST(Builtin, TestPuts) {
     test_null_object(obj.get());
 }
 
+// puts 写入求值器的输出缓冲区，求值结束或调用 flush() 时才交给 sink
+TEST(Builtin, TestFlush) {
+    std::vector<std::string> chunks;
+    Evaluator evaluator;
+    evaluator.output().set_sink([&chunks](std::string_view data) {
+        chunks.emplace_back(data);
+    });
+
+    evaluator.eval(R"(puts(1, "a"); puts([true]))");
+    EXPECT_EQ(chunks, std::vector<std::string>({"1\n\"a\"\n[true]\n"}));
+
+    chunks.clear();
+    evaluator.eval(R"(puts(1); flush(); puts(2))");
+    EXPECT_EQ(chunks, std::vector<std::string>({"1\n", "2\n"}));
+
+    chunks.clear();
+    auto obj = evaluator.eval("flush()");
+    test_null_object(obj.get());
+    EXPECT_TRUE(chunks.empty());
+
+    obj = evaluator.eval("flush(1)");
+    EXPECT_EQ(obj->inspect(), "error: wrong number of arguments. expected 0, got 1");
+}
+
+// 并行分块的输出按分块顺序写到调用方的输出中，位于之前和之后的输出之间
+TEST(Builtin, TestParallelOutput) {
+    const int n = 5000;
+    std::string array = "[";
+    std::string expect = "\"start\"\n";
+    for (int i = 0; i < n; ++i) {
+        array.append(std::to_string(i)).append(i + 1 < n ? ", " : "]");
+        expect.append(std::to_string(i)).append("\n");
+    }
+    expect.append("\"end\"\n");
+
+    std::string out;
+    Evaluator evaluator;
+    evaluator.output().set_sink(Output::string_sink(out));
+
+    evaluator.eval(R"(puts("start"); pmap()" + array + R"(, fn(x) { puts(x); x }); puts("end"))");
+    EXPECT_EQ(expect, out);
+
+    // preduce 的合并在所有分块之后
+    out.clear();
+    evaluator.eval(R"(preduce()" + array + R"(, fn(acc, x) { puts("chunk"); acc + x }, 0, fn(l, r) { puts("combine"); l + r }))");
+    auto first_combine = out.find("combine");
+    ASSERT_NE(std::string::npos, first_combine);
+    EXPECT_GT(first_combine, out.rfind("chunk"));
+
+    out.clear();
+    evaluator.eval(R"(puts("start"); pfilter([1, 2], fn(x) { puts(x); true }); puts("end"))");
+    EXPECT_EQ("\"start\"\n1\n2\n\"end\"\n", out);
+}
+
+// 并行执行的函数不能修改被多个线程共享的变量
+TEST(Builtin, TestParallelMutation) {
+    std::vector<std::tuple<std::string, std::string>> tests = {
+        {"let total = 0; pmap([1, 2, 3], fn(x) { total = total + x })",
+            "error: cannot assign to shared variable in parallel task: `total`"},
+        {"let f = fn() { let t = 0; pfilter([1], fn(x) { t = x }) }; f()",
+            "error: cannot assign to shared variable in parallel task: `t`"},
+        {"let h = {}; pmap([1], fn(x) { h[x] = x })",
+            "error: cannot assign to shared variable in parallel task: `h`"},
+        {"let a = [[0]]; preduce([1], fn(acc, x) { a[0][0] = x }, 0)",
+            "error: cannot assign to shared variable in parallel task: `a`"},
+        // 分块自己创建的变量可以修改，复制出来的数组不影响原来的数组
+        {"pmap([1, 2], fn(x) { let a = [x]; a[0] = a[0] * 10; let s = 0; s = s + 1; a[0] + s })", "[11, 21]"},
+        {"let g = [1]; pmap([5], fn(x) { let a = g; a[0] = x; a[0] }) + g", "[5, 1]"},
+        // 分块结束后在调用方修改分块中创建的变量
+        {"let fs = pmap([1], fn(x) { let c = x; fn() { c = c + 1; c } }); fs[0](); fs[0]()", "3"},
+    };
+
+    Evaluator evaluator;
+    for (auto& test : tests) {
+        evaluator.reset_env();
+        auto object = evaluator.eval(std::get<0>(test));
+        EXPECT_EQ(std::get<1>(test), object->inspect()) << std::get<0>(test);
+    }
+
+    // 大数组被切成多块并行执行
+    std::string array = "[";
+    for (int i = 0; i < 10000; ++i) {
+        array.append(std::to_string(i)).append(i + 1 < 10000 ? ", " : "]");
+    }
+    evaluator.reset_env();
+    auto object = evaluator.eval("let total = 0; pmap(" + array + ", fn(x) { total = total + x }); total");
+    EXPECT_EQ("error: cannot assign to shared variable in parallel task: `total`", object->inspect());
+}
+
+TEST(Builtin, TestExit) {
+    std::string array = "[";
+    for (int i = 0; i < 10000; ++i) {
+        array.append(std::to_string(i)).append(i + 1 < 10000 ? ", " : "]");
+    }
+
+    // exit 不结束进程，只中断求值并在求值器上记下退出码
+    std::vector<std::tuple<std::string, int, std::string>> exits = {
+        {"exit()", 0, ""},
+        {"exit(3)", 3, ""},
+        {"puts(1); exit(3); puts(2)", 3, "1\n"},
+        {"let f = fn() { exit(5); puts(1) }; f(); puts(2)", 5, ""},
+        // 工作线程中的 exit 同样中断调用方的求值
+        {"pmap(" + array + ", fn(x) { if (x == 4000) { exit(3) } x }); puts(1)", 3, ""},
+        {"pmap([1, 2], fn(x) { exit(4) })", 4, ""},
+    };
+
+    for (auto& test : exits) {
+        Evaluator evaluator;
+        std::string text;
+        evaluator.output().set_sink(Output::string_sink(text));
+        EXPECT_FALSE(evaluator.exit_requested());
+        auto object = evaluator.eval(std::get<0>(test));
+        ASSERT_NE(object, nullptr);
+        EXPECT_EQ(object->type(), object::Type::ERROR_OBJECT);
+        EXPECT_TRUE(evaluator.exit_requested());
+        EXPECT_EQ(evaluator.exit_status(), std::get<1>(test));
+        EXPECT_EQ(text, std::get<2>(test));
+    }
+
+    Evaluator evaluator;
+    evaluator.eval("let f = fn(x) { exit(x) }");
+    auto fn = evaluator.lookup("f");
+    std::shared_ptr<object::Object> status = std::make_shared<object::Integer>(6);
+    evaluator.call(fn.get(), object::Arguments(&status, 1));
+    EXPECT_TRUE(evaluator.exit_requested());
+    EXPECT_EQ(evaluator.exit_status(), 6);
+
+    std::vector<std::tuple<std::string, std::string>> tests = {
+        {R"(exit("1"))", "argument to `exit` must be INTEGER, got STRING"},
+        {"exit(1, 2)", "wrong number of arguments. expected 0 or 1, got 2"},
+    };
+
+    for (auto& test : tests) {
+        auto object = evaluator.eval(std::get<0>(test));
+        test_error_object(object.get(), std::get<1>(test));
+    }
+}
+
+TEST(Builtin, TestPmap) {
+    std::vector<std::tuple<std::string, std::string>> tests = {
+        {"pmap([1, 2, 3], fn(x) { x * 2 })", "[2, 4, 6]"},
+        {"pmap([], fn(x) { x })", "[]"},
+        {"let k = 10; pmap([1, 2], fn(x) { x + k })", "[11, 12]"},
+        {"pmap([[1], [2, 3]], len)", "[1, 2]"},
+        {"pmap(int_array([1, 2]), fn(x) { x * 2 })", "[2, 4]"},
+        {"pmap([1, true], fn(x) { -x })", "unknown operator: `-BOOLEAN`"},
+        {"pmap(1, len)", "argument to `pmap` not supported, got INTEGER"},
+        {"pmap([1], 1)", "argument to `pmap` must be FUNCTION, got INTEGER"},
+    };
+
+    Evaluator evaluator;
+
+    for (auto& test : tests) {
+        auto& input = std::get<0>(test);
+        auto& expect = std::get<1>(test);
+
+        evaluator.reset_env();
+        auto object = evaluator.eval(input);
+
+        if (object->type() == object::Type::ERROR_OBJECT) {
+            test_error_object(object.get(), expect);
+        } else {
+            EXPECT_EQ(expect, object->inspect());
+        }
+    }
+}
+
+TEST(Builtin, TestPfilter) {
+    std::vector<std::tuple<std::string, std::string>> tests = {
+        {"pfilter([1, 2, 3, 4], fn(x) { x > 2 })", "[3, 4]"},
+        {"pfilter([1, 2, 3], fn(x) { false })", "[]"},
+        {"sum(pfilter(int_array([1, 2, 3]), fn(x) { x > 1 }) * 2)", "10"},
+        {"pfilter([1, 2], fn(x) { x + true })", "type mismatch: `INTEGER + BOOLEAN`"},
+    };
+
+    Evaluator evaluator;
+
+    for (auto& test : tests) {
+        auto& input = std::get<0>(test);
+        auto& expect = std::get<1>(test);
+
+        evaluator.reset_env();
+        auto object = evaluator.eval(input);
+
+        if (object->type() == object::Type::ERROR_OBJECT) {
+            test_error_object(object.get(), expect);
+        } else {
+            EXPECT_EQ(expect, object->inspect());
+        }
+    }
+}
+
+TEST(Builtin, TestPreduce) {
+    std::vector<std::tuple<std::string, std::any>> tests = {
+        {"preduce([1, 2, 3, 4], fn(a, b) { a + b }, 0)", 10},
+        {"preduce([], fn(a, b) { a + b }, 7)", 7},
+        {"preduce([2, 3], fn(a, b) { a * b }, 1)", 6},
+        {"preduce([1, 2, 3], fn(acc, x) { acc * 10 + x }, 0)", 123},
+        {"preduce([1, 2, 3], fn(acc, x) { acc + 1 }, 0, fn(l, r) { l + r })", 3},
+        {"preduce([], fn(a, b) { a + b }, 7, fn(a, b) { a + b })", 7},
+        {"preduce([1], fn(a, b) { a + b })", "wrong number of arguments. expected 3 or 4, got 2"},
+        {"preduce([1], fn(a, b) { a + b }, 0, 1)", "argument to `preduce` must be FUNCTION or BOOLEAN, got INTEGER"},
+        {"preduce([1, 2, 3], fn(a, b) { a + b }, 0, true)", 6},
+        {"preduce([1, 2, 3], fn(acc, x) { acc * 10 + x }, 0, false)", 123},
+        {"preduce(int_array([1, 2, 3]), fn(a, b) { a + b }, 0, true)", 6},
+    };
+
+    Evaluator evaluator;
+
+    for (auto& test : tests) {
+        auto& input = std::get<0>(test);
+        auto& expect = std::get<1>(test);
+
+        evaluator.reset_env();
+        auto object = evaluator.eval(input);
+
+        if (expect.type() == typeid(int)) {
+            test_integer_object(object.get(), std::any_cast<int>(expect));
+        } else {
+            test_error_object(object.get(), std::any_cast<const char*>(expect));
+        }
+    }
+}
+
+// 数组足够大时会被切块并行执行，结果顺序必须和输入一致
+TEST(Builtin, TestParallelLargeArray) {
+    const int n = 20000;
+    std::string array = "[";
+    for (int i = 0; i < n; ++i) {
+        if (i != 0) {
+            array.append(", ");
+        }
+        array.append(std::to_string(i));
+    }
+    array.append("]");
+
+    Evaluator evaluator;
+    evaluator.eval("let a = " + array + ";");
+
+    auto mapped = evaluator.eval("pmap(a, fn(x) { x * 2 })");
+    auto mapped_array = mapped->cast<Array>();
+    ASSERT_TRUE(mapped_array != nullptr);
+    ASSERT_EQ(size_t(n), mapped_array->elements().size());
+    for (int i = 0; i < n; ++i) {
+        test_integer_object(mapped_array->elements()[i].get(), i * 2);
+    }
+
+    auto filtered = evaluator.eval("pfilter(a, fn(x) { x / 2 * 2 == x })");
+    auto filtered_array = filtered->cast<Array>();
+    ASSERT_TRUE(filtered_array != nullptr);
+    ASSERT_EQ(size_t(n / 2), filtered_array->elements().size());
+    for (int i = 0; i < n / 2; ++i) {
+        test_integer_object(filtered_array->elements()[i].get(), i * 2);
+    }
+
+    auto sum = evaluator.eval("preduce(a, fn(x, y) { x + y }, 0)");
+    test_integer_object(sum.get(), n * (n - 1) / 2);
+
+    // 不满足结合律的归约函数：分块结果不能交给 fn 合并
+    auto count = evaluator.eval("preduce(a, fn(acc, x) { acc + 1 }, 0)");
+    test_integer_object(count.get(), n);
+    auto parallel_count = evaluator.eval("preduce(a, fn(acc, x) { acc + 1 }, 0, fn(l, r) { l + r })");
+    test_integer_object(parallel_count.get(), n);
+    auto parallel_sum = evaluator.eval("preduce(a, fn(x, y) { x + y }, 0, fn(x, y) { x + y })");
+    test_integer_object(parallel_sum.get(), n * (n - 1) / 2);
+    auto associative_sum = evaluator.eval("preduce(a, fn(x, y) { x + y }, 0, true)");
+    test_integer_object(associative_sum.get(), n * (n - 1) / 2);
+
+    // IntArray 的元素在各分块中装箱
+    evaluator.eval("let b = int_array(a);");
+    auto int_mapped = evaluator.eval("pmap(b, fn(x) { x * 2 })");
+    EXPECT_EQ(mapped->inspect(), int_mapped->inspect());
+    auto int_filtered = evaluator.eval("pfilter(b, fn(x) { x / 2 * 2 == x })");
+    ASSERT_TRUE(int_filtered->cast<IntArray>() != nullptr);
+    EXPECT_EQ(filtered->inspect(), int_filtered->inspect());
+    auto int_sum = evaluator.eval("preduce(b, fn(x, y) { x + y }, 0, true)");
+    test_integer_object(int_sum.get(), n * (n - 1) / 2);
+    // combine 按分块顺序合并
+    auto ordered = evaluator.eval("preduce(a, fn(acc, x) { push(acc, x) }, [], fn(l, r) { l + r })");
+    auto ordered_array = ordered->cast<Array>();
+    ASSERT_TRUE(ordered_array != nullptr);
+    ASSERT_EQ(size_t(n), ordered_array->elements().size());
+    for (int i = 0; i < n; ++i) {
+        test_integer_object(ordered_array->elements()[i].get(), i);
+    }
+}
+
+TEST(Builtin, TestStats) {
+    Evaluator evaluator;
+    evaluator.eval("let f = fn(x) { x }; f(1); f(2);");
+    auto object = evaluator.eval("stats()");
+    auto hash = object->cast<Hash>();
+    ASSERT_TRUE(hash != nullptr);
+
+    auto calls = hash->get(std::make_unique<String>("calls").get());
+    test_integer_object(calls.get(), 2);
+    auto builtin_calls = hash->get(std::make_unique<String>("builtin_calls").get());
+    test_integer_object(builtin_calls.get(), 1);
+
+    auto objects = hash->get(std::make_unique<String>("objects").get())->cast<Hash>();
+    ASSERT_TRUE(objects != nullptr);
+    auto functions = objects->get(std::make_unique<String>("FUNCTION").get());
+    test_integer_object(functions.get(), 1);
+
+    // pmap 在工作线程中的调用也要计入
+    evaluator.reset_stats();
+    evaluator.eval("pmap([1, 2, 3], fn(x) { x })");
+    EXPECT_EQ(3u, evaluator.stats().calls);
+    EXPECT_EQ(1u, evaluator.stats().builtin_calls);
+
+    object = evaluator.eval("stats(1)");
+    test_error_object(object.get(), "wrong number of arguments. expected 0, got 1");
+}
+
+TEST(Builtin, TestShadowing) {
+    std::vector<std::tuple<std::string, int>> tests = {
+        {"let len = fn(x) { 42 }; len([1, 2])", 42},
+        {"let f = fn(len) { len }; f(7)", 7},
+        {"let f = fn(first) { len([first]) }; f(7)", 1},
+    };
+
+    Evaluator evaluator;
+
+    for (auto& test : tests) {
+        auto& input = std::get<0>(test);
+        auto expect = std::get<1>(test);
+
+        evaluator.reset_env();
+        auto object = evaluator.eval(input);
+
+        test_integer_object(object.get(), expect);
+    }
+}
+
+// 内置函数对象是共享的，查找时不再分配
+TEST(Builtin, TestSharedBuiltinObject) {
+    Evaluator evaluator;
+    auto a = evaluator.eval("len");
+    auto b = evaluator.eval("len");
+    ASSERT_TRUE(a->cast<Builtin>() != nullptr);
+    EXPECT_EQ(a.get(), b.get());
+    EXPECT_EQ("len", a->cast<Builtin>()->name());
+
+    evaluator.reset_stats();
+    evaluator.eval("len([1]) + len([2])");
+    EXPECT_EQ(0u, evaluator.stats().objects[object::Type::BUILTIN_OBJECT]);
+    EXPECT_EQ(2u, evaluator.stats().builtin_calls);
+}
+
+
+TEST(Builtin, TestIntArray) {
+    std::vector<std::tuple<std::string, std::string>> tests = {
+        {"int_array([1, 2, 3])", "[1, 2, 3]"},
+        {"int_array(3)", "[0, 0, 0]"},
+        {"int_array([])", "[]"},
+        {"let a = int_array([1, 2]); int_array(a)", "[1, 2]"},
+        {"push(int_array([1]), 2)", "[1, 2]"},
+        {"rest(int_array([1, 2, 3]))", "[2, 3]"},
+        {"filter_gt(int_array([5, 1, 7, 3, 9]), 4)", "[5, 7, 9]"},
+        {"filter_gt([1, 2, 3], 5)", "[]"},
+        {"int_array([1, 2]) + int_array([10, 20])", "[11, 22]"},
+        {"int_array([1, 2]) * int_array([10, 20])", "[10, 40]"},
+        {"int_array([1, 2]) * 3", "[3, 6]"},
+        {"10 + int_array([1, 2])", "[11, 12]"},
+        {"let a = int_array(2); a[1] = 5; a", "[0, 5]"},
+        {"let a = int_array([1]); let b = a; b[0] = 9; a", "[1]"},
+        {"push(int_array([1]), \"x\")", "[1, \"x\"]"},
+        // 溢出时和整数运算一样改用大整数，按元素运算的结果变为普通数组
+        {"sum(int_array([9223372036854775807, 1, 0, 0, 0]))", "9223372036854775808"},
+        {"sum([9223372036854775807, 1, -1, 0, 0])", "9223372036854775807"},
+        {"sum([-9223372036854775807, -1, -1, 0, 0])", "-9223372036854775809"},
+        {"dot(int_array([4294967296, 0, 0, 0, 1]), [4294967296, 0, 0, 0, 1])", "18446744073709551617"},
+        {"int_array([9223372036854775807, 1, 2, 3, 4]) + 1", "[9223372036854775808, 2, 3, 4, 5]"},
+        {"int_array([4294967296, 2, 3, 4, 5]) * int_array([4294967296, 1, 1, 1, 1])", "[18446744073709551616, 2, 3, 4, 5]"},
+        {"len(int_array([4294967296, 2, 3, 4, 5]) * 2)", "5"},
+        {"int_array([4294967296, 2, 3, 4, 5]) * 2", "[8589934592, 4, 6, 8, 10]"},
+        {"int_array(100000000000000)", "error: argument to `int_array` too large, got 100000000000000"},
+        {"int_array(9223372036854775807)", "error: argument to `int_array` too large, got 9223372036854775807"},
+    };
+
+    Evaluator evaluator;
+
+    for (auto& test : tests) {
+        auto& input = std::get<0>(test);
+        auto& expect = std::get<1>(test);
+
+        evaluator.reset_env();
+        auto object = evaluator.eval(input);
+
+        EXPECT_EQ(expect, object->inspect()) << input;
+    }
+}
+
+TEST(Builtin, TestIntArrayReduce) {
+    std::vector<std::tuple<std::string, std::any>> tests = {
+        {"sum(int_array([1, 2, 3, 4, 5]))", 15},
+        {"sum([1, 2, 3])", 6},
+        {"sum(int_array(0))", 0},
+        {"min(int_array([3, -1, 2, 8, 0]))", -1},
+        {"max([3, -1, 2, 8, 0])", 8},
+        {"dot(int_array([1, 2, 3]), [4, 5, 6])", 32},
+        {"len(int_array(7))", 7},
+        {"first(int_array([4, 5]))", 4},
+        {"last(int_array([4, 5]))", 5},
+        {"int_array([4, 5])[-1]", 5},
+        {"let s = 0; for (x in int_array([1, 2, 3])) { s = s + x; }; s", 6},
+        {"sum([1, \"a\"])", "argument to `sum` must be INT_ARRAY or ARRAY of INTEGER, got ARRAY"},
+        {"min(1)", "argument to `min` must be INT_ARRAY or ARRAY of INTEGER, got INTEGER"},
+        {"dot([1], [1, 2])", "arguments to `dot` must have the same length, got 1 and 2"},
+        {"filter_gt([1], true)", "argument to `filter_gt` must be INTEGER, got BOOLEAN"},
+        {"int_array(-1)", "argument to `int_array` must be non-negative, got -1"},
+        {"int_array(\"a\")", "argument to `int_array` not supported, got STRING"},
+        {"int_array([1]) + int_array([1, 2])", "length mismatch: `1 + 2`"},
+        {"int_array([1]) - 1", "unknown operator: `INT_ARRAY - INTEGER`"},
+        {"int_array([1]) + \"a\"", "type mismatch: `INT_ARRAY + STRING`"},
+        {"let a = int_array(1); a[0] = \"a\"", "type mismatch: `INT_ARRAY[] = STRING`"},
+    };
+
+    Evaluator evaluator;
+
+    for (auto& test : tests) {
+        auto& input = std::get<0>(test);
+        auto& expect = std::get<1>(test);
+
+        evaluator.reset_env();
+        auto object = evaluator.eval(input);
+
+        if (expect.type() == typeid(int)) {
+            test_integer_object(object.get(), std::any_cast<int>(expect));
+        } else {
+            test_error_object(object.get(), std::any_cast<const char*>(expect));
+        }
+    }
+
+    test_null_object(evaluator.eval("min([])").get());
+    test_null_object(evaluator.eval("max(int_array(0))").get());
+}
+
+TEST(Builtin, TestIntArrayNoBoxing) {
+    Evaluator evaluator;
+    auto object = evaluator.eval("let a = int_array(100000); let b = a + 1; sum(b * b)");
+    test_integer_object(object.get(), 100000);
+
+    // 数组元素不装箱，Integer 只有两个字面量和最终结果
+    EXPECT_EQ(3u, evaluator.stats().objects[Type::INTEGER_OBJECT]);
+    EXPECT_EQ(3u, evaluator.stats().objects[Type::INT_ARRAY_OBJECT]);
+}
+
 }
@@ -0,0 +1,124 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <gtest/gtest.h>
+#include "builtin.h"
+#include "cache.h"
+#include "evaluator.h"
+#include "parser.h"
+
+using namespace autumn;
+
+namespace {
+
+const std::vector<std::string> SCRIPTS = {
+    "let a = 5; let b = a * 2 + -1;",
+    "let f = fn(x, y) { if (x > y) { return x; } else { y } }; f(1, 2.5);",
+    "let h = {\"a\": [1, 2], true: 3}; h[\"a\"][0] = len(h);",
+    "let s = 0; for (x in [1, 2, 3]) { s = s + x; } while (s < 10) { s = s * 2; }",
+    "puts(!true, 100000000000000000000);",
+};
+
+std::string write_file(const std::string& path, const std::string& content) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << content;
+    return path;
+}
+
+TEST(Cache, TestRoundTrip) {
+    Parser parser;
+
+    for (auto& script : SCRIPTS) {
+        auto program = parser.parse(script);
+        ASSERT_TRUE(parser.errors().empty()) << script;
+
+        auto decoded = cache::decode(cache::encode(*program));
+        ASSERT_TRUE(decoded != nullptr) << script;
+        EXPECT_EQ(program->to_string(), decoded->to_string());
+    }
+
+    // 内置函数的绑定在解码时重新建立
+    auto program = cache::decode(cache::encode(*parser.parse("len")));
+    ASSERT_TRUE(program != nullptr);
+    auto stmt = program->statments()[0]->cast<ast::ExpressionStatment>();
+    auto identifier = stmt->expression()->cast<ast::Identifier>();
+    ASSERT_TRUE(identifier != nullptr);
+    EXPECT_EQ(builtin::lookup("len"), identifier->builtin());
+}
+
+TEST(Cache, TestCorruptData) {
+    Parser parser;
+    auto data = cache::encode(*parser.parse(SCRIPTS[1]));
+
+    // 任意位置截断都应该被发现
+    for (size_t i = 0; i < data.size(); ++i) {
+        EXPECT_TRUE(cache::decode(std::string_view(data.data(), i)) == nullptr) << i;
+    }
+
+    EXPECT_TRUE(cache::decode(data + "x") == nullptr);
+    EXPECT_TRUE(cache::decode(std::string(1, '\xff')) == nullptr);
+}
+
+TEST(Cache, TestLoadAndStore) {
+    std::string path = "cache_test.atmc";
+    Parser parser;
+    auto program = parser.parse(SCRIPTS[0]);
+    uint64_t fingerprint = cache::fingerprint(SCRIPTS[0]);
+
+    ASSERT_TRUE(cache::store(path, fingerprint, *program));
+    auto loaded = cache::load(path, fingerprint);
+    ASSERT_TRUE(loaded != nullptr);
+    EXPECT_EQ(program->to_string(), loaded->to_string());
+
+    // 源码改变后缓存失效
+    EXPECT_TRUE(cache::load(path, cache::fingerprint(SCRIPTS[1])) == nullptr);
+    EXPECT_TRUE(cache::load("no_such_file.atmc", fingerprint) == nullptr);
+
+    // 文件内容被改动
+    std::string content;
+    {
+        std::ifstream in(path, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    content.back() ^= 1;
+    write_file(path, content);
+    EXPECT_TRUE(cache::load(path, fingerprint) == nullptr);
+
+    std::remove(path.c_str());
+}
+
+TEST(Cache, TestEvalFile) {
+    std::vector<std::tuple<std::string, std::string>> tests = {
+        {"let f = fn(n) { n * 2 }; f(21)", "42"},
+        {"let f = fn(n) { n * 3 }; f(21)", "63"},
+        {"let h = {\"k\": 1.5}; h[\"k\"] + 1", "2.5"},
+    };
+
+    std::string path = "cache_test.atm";
+    std::string cache_path = cache::path_for(path);
+    Evaluator evaluator;
+
+    for (auto& test : tests) {
+        write_file(path, std::get<0>(test));
+
+        // 第一次从源码解析并写缓存，第二次直接读缓存
+        for (int i = 0; i < 2; ++i) {
+            evaluator.reset_env();
+            auto object = evaluator.eval_file(path);
+            EXPECT_EQ(std::get<1>(test), object->inspect()) << std::get<0>(test);
+            EXPECT_TRUE(cache::load(cache_path, cache::fingerprint(std::get<0>(test))) != nullptr);
+        }
+    }
+
+    std::remove(path.c_str());
+    std::remove(cache_path.c_str());
+
+    auto object = evaluator.eval_file("no_such_file.atm");
+    auto error = object->cast<object::Error>();
+    ASSERT_TRUE(error != nullptr);
+    EXPECT_EQ("cannot open file: `no_such_file.atm`", error->message());
+}
+
+}
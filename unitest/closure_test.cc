@@ -0,0 +1,87 @@
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "evaluator.h"
+
+using namespace autumn;
+
+namespace {
+
+std::string inspect(const std::shared_ptr<const object::Object>& result) {
+    return result == nullptr ? "nullptr" : result->inspect();
+}
+
+}
+
+TEST(Closure, TestSameAsTree) {
+    std::vector<std::string> tests = {
+        "1 + 2 * 3 - 4 / 2",
+        "9223372036854775807 + 1",
+        "99999999999999999999 * 2",
+        "1.5 * 2 + 0.25",
+        "\"hello\" + \" \" + \"world\"",
+        "!true == false",
+        "-5 < 3",
+        "if (1 > 2) { 10 }",
+        "if (1 > 2) { 10 } else { 20 }",
+        "if (true) { }",
+        "let x = 5; x",
+        "let x = 5;",
+        "return 3; 4",
+        "5 * \"a\"",
+        "foo",
+        "1 / 0",
+        "let f = fn(x) { return x * 2; x }; f(21)",
+        "let add = fn(a) { fn(b) { a + b } }; let plus = add(2); plus(40)",
+        "let counter = fn() { let n = 0; fn() { n = n + 1; n } }; let c = counter(); c(); c()",
+        "let f = fn(n) { let go = fn(k) { if (k == 0) { 0 } else { go(k - 1) + 1 } }; go(n) }; f(5)",
+        "let fib = fn(n) { if (n < 2) { n } else { fib(n - 1) + fib(n - 2) } }; fib(20)",
+        "let fact = fn(n) { if (n < 2) { return 1; } n * fact(n - 1) }; fact(30)",
+        "fn(x, y) { x + y }",
+        "let a = [1, 2, 3]; a[0] = 10; a[-1] = 30; a",
+        "let a = [1, 2]; let b = a; b[0] = 5; [a, b]",
+        "let a = [[1, 2], [3, 4]]; a[1][0] = 9; a",
+        "let h = {\"a\": 1}; h[\"b\"] = 2; h[\"a\"] = 3; [h[\"a\"], h[\"b\"], h[\"c\"]]",
+        "let h = {\"a\": 1 + \"x\", 1 + \"y\": 2, [1]: 3, \"b\": 4}; h",
+        "let a = [1]; a[5] = 1",
+        "b = 1",
+        "[1][0] = 2",
+        "let s = 0; for (x in [1, 2, 3]) { s = s + x; } s",
+        "let s = 0; for (x in int_array([4, 5, 6])) { s = s + x; } s",
+        "for (x in 1) { x }",
+        "let i = 0; let s = 0; while (i < 10) { i = i + 1; if (i == 5) { s = s * 100 } s = s + i; } s",
+        "let f = fn() { let i = 0; while (true) { i = i + 1; if (i > 3) { return i; } } }; f()",
+        "len(\"abcd\") + len([1, 2])",
+        "pmap([1, 2, 3], fn(x) { x * x })",
+        "let len = fn(x) { 42 }; len(\"a\")",
+        "let f = fn(x) { x }; f()",
+        "5(1)",
+        "[1, 2 * \"a\", 3]",
+        "let x = ",
+    };
+
+    for (auto& input : tests) {
+        Evaluator tree;
+        Evaluator closure;
+        closure.set_backend(Evaluator::Backend::CLOSURE);
+        EXPECT_EQ(inspect(closure.eval(input)), inspect(tree.eval(input))) << input;
+    }
+}
+
+// 闭包后端创建的函数切换回树遍历后仍然执行转换好的函数体，反之亦然
+TEST(Closure, TestSwitchBackend) {
+    Evaluator evaluator;
+    evaluator.set_backend(Evaluator::Backend::CLOSURE);
+    evaluator.eval("let sq = fn(x) { x * x };");
+    auto sq = evaluator.lookup("sq");
+    ASSERT_NE(sq, nullptr);
+    EXPECT_NE(sq->cast<object::Function>()->compiled(), nullptr);
+
+    evaluator.set_backend(Evaluator::Backend::TREE);
+    evaluator.eval("let cube = fn(x) { x * sq(x) };");
+    EXPECT_EQ(evaluator.lookup("cube")->cast<object::Function>()->compiled(), nullptr);
+    EXPECT_EQ("27", inspect(evaluator.eval("cube(3)")));
+
+    evaluator.set_backend(Evaluator::Backend::CLOSURE);
+    EXPECT_EQ("64", inspect(evaluator.eval("cube(4)")));
+}
@@ -9,7 +9,7 @@ using namespace autumn::object;
 
 namespace {
 
-void test_integer_object(const Object* object, int expect) {
+void test_integer_object(const Object* object, int64_t expect) {
     auto result = object->cast<Integer>();
     ASSERT_TRUE(result != nullptr);
     EXPECT_EQ(expect, result->value());
@@ -155,6 +155,10 @@ TEST(Evaluator, TestReturnStatment) {
                     return 1;
                 }
             )", 10},
+        {"let f = fn() { let x = if (true) { return 5; }; 10 }; f()", 5},
+        {"let f = fn() { 1 + if (true) { return 2; } }; f()", 2},
+        {"let f = fn() { let g = fn() { return 1; }; g(); 3 }; f()", 3},
+        {"let f = fn(x) { if (x > 0) { return x; } return 0 - x; }; f(-4) + f(5)", 9},
     };
 
     Evaluator evaluator;
@@ -183,6 +187,11 @@ TEST(Evaluator, TestErrorHandling) {
                     return 1;
                 }
             )", "unknown operator: `BOOLEAN + BOOLEAN`"},
+        {"len(1) + 1", "argument to `len` not supported, got INTEGER"},
+        {"let f = fn() { return -true; 1 }; f() + 1", "unknown operator: `-BOOLEAN`"},
+        {"x = 1", "identifier not found: `x`"},
+        {"for (x in 1) { x }", "for loop not supported: `INTEGER`"},
+        {"let i = 0; while (true) { i = i + 1; if (i > 3) { i + true } }", "type mismatch: `INTEGER + BOOLEAN`"},
     };
 
     Evaluator evaluator;
@@ -219,6 +228,244 @@ TEST(Evaluator, TestLetStatment) {
     }
 }
 
+TEST(Evaluator, TestIntegerOverflow) {
+    std::vector<std::tuple<std::string, std::string>> tests = {
+        {"9223372036854775807 + 1", "9223372036854775808"},
+        {"-9223372036854775807 - 2", "-9223372036854775809"},
+        {"4294967296 * 4294967296", "18446744073709551616"},
+        {"-9223372036854775808", "-9223372036854775808"},
+        {"-(-9223372036854775807 - 1)", "9223372036854775808"},
+        {"(-9223372036854775807 - 1) / -1", "9223372036854775808"},
+        {"9223372036854775807 * 4 / 4", "9223372036854775807"},
+        {"100000000000000000000 - 99999999999999999999", "1"},
+        {"100000000000000000000 > 9223372036854775807", "true"},
+        {"-100000000000000000000 < 1", "true"},
+        {"100000000000000000000 == 100000000000000000000", "true"},
+        {"-100000000000000000000 / 7", "-14285714285714285714"},
+        {"let h = {100000000000000000000: 1}; h[100000000000000000000]", "1"},
+        {"let f = fn(n) { if (n == 0) { 1 } else { n * f(n - 1) } }; f(25)", "15511210043330985984000000"},
+    };
+
+    Evaluator evaluator;
+
+    for (auto& test : tests) {
+        auto& input = std::get<0>(test);
+        auto& expect = std::get<1>(test);
+
+        evaluator.reset_env();
+        auto object = evaluator.eval(input);
+
+        EXPECT_EQ(expect, object->inspect()) << input;
+    }
+
+    // 能放进 64 位的结果总是 Integer
+    test_integer_object(evaluator.eval("100000000000000000000 - 99999999999999999999").get(), 1);
+    test_integer_object(evaluator.eval("-9223372036854775808").get(), INT64_MIN);
+
+    std::vector<std::tuple<std::string, std::string>> errors = {
+        {"1 / 0", "division by zero"},
+        {"100000000000000000000 / 0", "division by zero"},
+        {"100000000000000000000 + true", "type mismatch: `BIGINT + BOOLEAN`"},
+        {"-true", "unknown operator: `-BOOLEAN`"},
+    };
+
+    for (auto& test : errors) {
+        auto object = evaluator.eval(std::get<0>(test));
+        test_error_object(object.get(), std::get<1>(test));
+    }
+}
+
+TEST(Evaluator, TestFloatExpression) {
+    std::vector<std::tuple<std::string, std::string>> tests = {
+        {"1.5", "1.5"},
+        {"-2.5", "-2.5"},
+        {"1.5 + 1.5", "3.0"},
+        {"0.1 + 0.2", "0.30000000000000004"},
+        {"1 + 0.5", "1.5"},
+        {"0.5 * 4", "2.0"},
+        {"7 / 2.0", "3.5"},
+        {"7 / 2", "3"},
+        {"100000000000000000000 * 0.5", "5e+19"},
+        {"1.0 / 0", "inf"},
+        {"-1.0 / 0", "-inf"},
+        {"1 == 1.0", "true"},
+        {"1.5 < 2", "true"},
+        {"2.5 >= 2.5", "true"},
+        {"0.1 + 0.2 != 0.3", "true"},
+        {"let h = {1.5: 1}; h[1.5]", "1"},
+        {"let s = 0.0; let i = 0; while (i < 4) { s = s + 0.25; i = i + 1; }; s", "1.0"},
+    };
+
+    Evaluator evaluator;
+
+    for (auto& test : tests) {
+        auto& input = std::get<0>(test);
+        auto& expect = std::get<1>(test);
+
+        evaluator.reset_env();
+        auto object = evaluator.eval(input);
+
+        EXPECT_EQ(expect, object->inspect()) << input;
+    }
+
+    std::vector<std::tuple<std::string, std::string>> errors = {
+        {"1.5 + true", "type mismatch: `FLOAT + BOOLEAN`"},
+        {"\"a\" + 1.5", "type mismatch: `STRING + FLOAT`"},
+        {"-\"a\"", "unknown operator: `-STRING`"},
+    };
+
+    for (auto& test : errors) {
+        auto object = evaluator.eval(std::get<0>(test));
+        test_error_object(object.get(), std::get<1>(test));
+    }
+}
+
+TEST(Evaluator, TestAssignExpression) {
+    std::vector<std::tuple<std::string, int>> tests = {
+        {"let a = 5; a = 6; a", 6},
+        {"let a = 5; let b = 0; a = b = 7; a + b", 14},
+        {"let a = 1; let f = fn() { a = a + 1; }; f(); f(); a", 3},
+        // 函数内 let 定义的变量遮蔽外层变量，赋值只作用于最近一层
+        {"let a = 1; let f = fn() { let a = 10; a = 20; a }; f() + a", 21},
+        {"let make = fn() { let n = 0; fn() { n = n + 1 } }; let c = make(); c(); c(); c()", 3},
+    };
+
+    Evaluator evaluator;
+
+    for (auto& test : tests) {
+        auto& input = std::get<0>(test);
+        auto expect = std::get<1>(test);
+
+        evaluator.reset_env();
+        auto object = evaluator.eval(input);
+
+        test_integer_object(object.get(), expect);
+    }
+}
+
+TEST(Evaluator, TestIndexAssignExpression) {
+    std::vector<std::tuple<std::string, int>> tests = {
+        {"let a = [1, 2, 3]; a[0] = 10; a[0] + a[1] + a[2]", 15},
+        {"let a = [1, 2, 3]; a[-1] = 10; a[2]", 10},
+        {"let a = [[1, 2], [3, 4]]; a[1][0] = 30; a[1][0] + a[0][0]", 31},
+        {"let h = {}; h[\"x\"] = 1; h[\"x\"] = h[\"x\"] + 1; h[\"x\"]", 2},
+        {"let h = {1: [0, 0]}; h[1][1] = 5; h[1][1]", 5},
+        {"let a = [0, 0]; let i = 1; a[i] = a[i - 1] = 7; a[0] + a[1]", 14},
+        // 写时复制：赋值不影响共享同一数组的其它变量
+        {"let a = [1, 2]; let b = a; b[0] = 10; a[0]", 1},
+        {"let b = [1]; let a = [b]; a[0][0] = 10; b[0]", 1},
+        {"let h = {\"k\": 1}; let g = h; g[\"k\"] = 2; h[\"k\"]", 1},
+        {"let a = [1]; let f = fn(x) { x[0] = 5; x[0] }; f(a) + a[0]", 6},
+        {"let a = [1]; a[0] = a; len(a[0])", 1},
+        // 闭包修改外层变量
+        {"let a = [0]; let inc = fn() { a[0] = a[0] + 1; }; inc(); inc(); a[0]", 2},
+    };
+
+    Evaluator evaluator;
+
+    for (auto& test : tests) {
+        auto& input = std::get<0>(test);
+        auto expect = std::get<1>(test);
+
+        evaluator.reset_env();
+        auto object = evaluator.eval(input);
+
+        test_integer_object(object.get(), expect);
+    }
+
+    std::vector<std::tuple<std::string, std::string>> errors = {
+        {"let a = [1]; a[1] = 2", "index out of range: `1`"},
+        {"let a = 1; a[0] = 2", "index operator not supported: `INTEGER`"},
+        {"let a = [1]; a[\"x\"] = 2", "index operator not supported: `ARRAY`"},
+        {"let h = {}; h[[1]] = 2", "unusable as hash key: `ARRAY`"},
+        {"let h = {}; h[\"x\"][0] = 2", "index operator not supported: `NULL`"},
+        {"b[0] = 1", "identifier not found: `b`"},
+        {"let a = [1]; a[-true] = 1", "unknown operator: `-BOOLEAN`"},
+    };
+
+    for (auto& test : errors) {
+        evaluator.reset_env();
+        auto object = evaluator.eval(std::get<0>(test));
+        test_error_object(object.get(), std::get<1>(test));
+    }
+}
+
+TEST(Evaluator, TestIndexAssignInPlace) {
+    std::string input = R"(
+        let a = [0, 0, 0];
+        let h = {};
+        let i = 0;
+        while (i < 1000) {
+            a[1] = a[1] + 1;
+            h[i] = i;
+            i = i + 1;
+        }
+        a[1] + h[999]
+    )";
+
+    Evaluator evaluator;
+    auto object = evaluator.eval(input);
+    test_integer_object(object.get(), 1999);
+
+    // 数组和哈希表都只被一个变量引用，循环中不发生复制
+    auto& stats = evaluator.stats();
+    EXPECT_EQ(1u, stats.objects[object::Type::ARRAY_OBJECT]);
+    EXPECT_EQ(1u, stats.objects[object::Type::HASH_OBJECT]);
+}
+
+TEST(Evaluator, TestLoopExpression) {
+    std::vector<std::tuple<std::string, int>> tests = {
+        {"let i = 0; let s = 0; while (i < 10) { s = s + i; i = i + 1; }; s", 45},
+        {"let s = 0; for (x in [1, 2, 3, 4]) { s = s + x; }; s", 10},
+        {"let s = 0; for (x in []) { s = s + 1; }; s", 0},
+        {"let s = 0; for (x in [1, 2]) { for (y in [10, 20]) { s = s + x * y; } }; s", 90},
+        // 循环变量绑定在当前作用域，循环结束后保留最后一个值
+        {"for (x in [1, 2, 3]) { }; x", 3},
+        // 遍历的是开始时的数组，循环体中重新赋值不影响遍历
+        {"let a = [1, 2, 3]; let s = 0; for (x in a) { a = []; s = s + x; }; s", 6},
+        {"let f = fn() { let i = 0; while (true) { if (i == 5) { return i; } i = i + 1; } }; f()", 5},
+        {"let f = fn(a) { for (x in a) { if (x > 2) { return x; } } 0 }; f([1, 2, 3, 4])", 3},
+    };
+
+    Evaluator evaluator;
+
+    for (auto& test : tests) {
+        auto& input = std::get<0>(test);
+        auto expect = std::get<1>(test);
+
+        evaluator.reset_env();
+        auto object = evaluator.eval(input);
+
+        test_integer_object(object.get(), expect);
+    }
+
+    evaluator.reset_env();
+    auto object = evaluator.eval("while (false) { 1 }");
+    test_null_object(object.get());
+}
+
+TEST(Evaluator, TestLoopWithoutCalls) {
+    // 迭代次数远超递归所能承受的深度，循环既不调用函数也不新建环境
+    std::string input = R"(
+        let i = 0;
+        let s = 0;
+        while (i < 100000) {
+            s = s + 2;
+            i = i + 1;
+        }
+        s
+    )";
+
+    Evaluator evaluator;
+    auto object = evaluator.eval(input);
+    test_integer_object(object.get(), 200000);
+
+    auto& stats = evaluator.stats();
+    EXPECT_EQ(0u, stats.calls);
+    EXPECT_EQ(0u, stats.environments);
+    EXPECT_EQ(0u, stats.max_depth);
+}
+
 TEST(Evaluator, TestFunctionObject) {
     std::string input = "fn(x) { x + 2; }";
     Evaluator evaluator;
@@ -279,6 +526,140 @@ TEST(Evaluator, TestClosures) {
     test_integer_object(object.get(), 12);
 }
 
+// 扁平闭包只复制用到的变量，可变的绑定和还未执行的 let 仍然与环境链语义相同
+TEST(Evaluator, TestFlatClosures) {
+    std::vector<std::tuple<std::string, std::string>> tests = {
+        {"let a = fn(x) { fn(y) { fn(z) { x + y + z } } }; a(1)(2)(3)", "6"},
+        {"let x = 10; let f = fn(x) { fn() { x } }; f(1)()", "1"},
+        {"let counter = fn() { let n = 0; fn() { n = n + 1; n } }; let c = counter(); c(); c(); c()", "3"},
+        {"let f = fn() { let n = 1; let set = fn(v) { n = v }; set(5); n }; f()", "5"},
+        {"let f = fn() { let x = 1; let g = fn() { x }; let x = 2; g() }; f()", "2"},
+        {"let f = fn() { fn() { later } }; let g = f(); let later = 7; g()", "7"},
+        {"let total = 0; let f = fn() { let k = 2; fn() { total = total + k } }; let g = f(); g(); g(); total", "4"},
+        {"let f = fn() { let fs = []; let i = 0; while (i < 3) { let j = i; fs = push(fs, fn() { j }); i = i + 1; } fs }; f()[0]()", "2"},
+        {"let f = fn() { let r = 0; for (x in [1, 2, 3]) { r = fn() { x }; } r() }; f()", "3"},
+        {"let f = fn(n) { let go = fn(k) { if (k == 0) { 0 } else { go(k - 1) + 1 } }; go(n) }; f(5)", "5"},
+        {"let f = fn(n) { let even = fn(k) { if (k == 0) { true } else { odd(k - 1) } }; "
+            "let odd = fn(k) { if (k == 0) { false } else { even(k - 1) } }; even(n) }; f(7)", "false"},
+        {"let f = fn(a) { let g = fn(b) { fn() { a + b } }; g(2) }; f(1)()", "3"},
+        // 下标赋值修改的是变量指向的容器，不能按值复制
+        {"let f = fn() { let a = [1, 2, 3]; let g = fn() { a[0] }; a[0] = 99; g() }; f()", "99"},
+        {"let f = fn() { let a = [1, 2, 3]; let g = fn() { a[0] = 7 }; g(); a[0] }; f()", "7"},
+        {"let f = fn() { let h = {\"k\": 1}; let g = fn() { h[\"k\"] = 2 }; g(); h[\"k\"] }; f()", "2"},
+        {"let f = fn() { let a = [[1]]; let g = fn() { a[0][0] }; a[0][0] = 5; g() }; f()", "5"},
+    };
+
+    for (auto& [input, expected] : tests) {
+        Evaluator evaluator;
+        EXPECT_EQ(evaluator.eval(input)->inspect(), expected) << input;
+    }
+
+    // 返回的回调只持有它用到的变量，外层函数中的大数组不再被引用
+    Evaluator evaluator;
+    evaluator.eval(R"(
+        let make = fn() {
+            let big = [1, 2, 3];
+            let k = 5;
+            let go = fn(n) { if (n == 0) { k } else { go(n - 1) } };
+            [fn(x) { x + k }, fn(x) { x * 2 }, go]
+        };
+        let fns = make();
+    )");
+    auto& fns = evaluator.lookup("fns")->cast<Array>()->elements();
+    ASSERT_EQ(fns.size(), 3);
+
+    auto& add = fns[0]->cast<Function>()->env();
+    EXPECT_EQ(add->store().size(), 1);
+    EXPECT_EQ(add->store().count("k"), 1);
+    EXPECT_EQ(add->outer()->outer(), nullptr);
+
+    EXPECT_EQ(fns[1]->cast<Function>()->env()->outer(), nullptr);
+
+    auto& go = fns[2]->cast<Function>()->env();
+    EXPECT_EQ(go->store().size(), 2);
+    EXPECT_EQ(go->store().at("go"), fns[2]);
+    EXPECT_EQ(go->outer()->outer(), nullptr);
+    EXPECT_EQ(evaluator.eval("fns[2](3)")->inspect(), "5");
+}
+
+// 函数体中没有捕获变量的闭包时调用帧不会逃逸，在帧栈上复用
+TEST(Evaluator, TestStackFrames) {
+    std::vector<std::tuple<std::string, bool>> tests = {
+        {"fn(x) { let y = x * 2; y + 1 }", true},
+        {"fn(k) { fn(x) { x + k } }", false},
+        {"fn() { fn(x) { x * 2 } }", true},
+        {"fn(n) { let go = fn(k) { if (k == 0) { 0 } else { go(k - 1) } }; go(n) }", true},
+        {"fn(n) { let c = 0; let inc = fn() { c = c + 1 }; inc(); c }", false},
+        {"fn(a) { fn(b) { fn() { a + b } } }", false},
+    };
+
+    for (auto& [input, stack_frame] : tests) {
+        Evaluator evaluator;
+        auto fn = evaluator.eval(input)->cast<Function>();
+        ASSERT_NE(fn, nullptr);
+        EXPECT_EQ(fn->stack_frame(), stack_frame) << input;
+    }
+
+    Evaluator evaluator;
+    auto object = evaluator.eval(R"(
+        let make = fn() { fn(x) { x * 2 } };
+        let leaf = fn(x) { let y = x + 1; y };
+        let twice = make();
+        let s = 0;
+        let i = 0;
+        while (i < 100) { s = s + leaf(i) + twice(i); i = i + 1; }
+        s
+    )");
+    test_integer_object(object.get(), 5050 + 9900);
+    // make、leaf 和 twice 的调用帧都在帧栈的第一层
+    EXPECT_EQ(1u, evaluator.stats().environments);
+    EXPECT_EQ(1u, evaluator._frames.size());
+    EXPECT_EQ(0u, evaluator._frame_depth);
+    EXPECT_TRUE(evaluator._frames[0]->store().empty());
+}
+
+// 全局变量和内置函数的查找结果缓存在标识符上，全局环境新增变量后失效
+TEST(Evaluator, TestInlineCaches) {
+    Parser parser;
+    auto program = parser.parse("let f = fn(len) { g(len) + len(\"ab\") }; f");
+    auto literal = program->statments()[0]->cast<ast::LetStatment>()->expression()->cast<ast::FunctionLiteral>();
+    auto body = literal->body()->statments()[0]->cast<ast::ExpressionStatment>()->expression()->cast<ast::InfixExpression>();
+    auto g = body->left()->cast<ast::CallExpression>()->function()->cast<ast::Identifier>();
+    auto len = body->right()->cast<ast::CallExpression>()->function()->cast<ast::Identifier>();
+    ASSERT_NE(g, nullptr);
+    ASSERT_NE(len, nullptr);
+    EXPECT_TRUE(g->global());
+    EXPECT_FALSE(len->global());
+
+    Evaluator evaluator;
+    evaluator.eval(program.get(), evaluator._env);
+    evaluator.eval("let g = fn(x) { 1 };");
+    auto version = evaluator._env->version();
+    EXPECT_EQ(evaluator.eval("f(len)")->inspect(), "3");
+    EXPECT_EQ(g->cache().version, version);
+    ASSERT_NE(g->cache().slot, nullptr);
+
+    // 重新绑定已有的变量不改变位置，缓存仍然有效
+    evaluator.eval("let g = fn(x) { 10 };");
+    EXPECT_EQ(evaluator._env->version(), version);
+    EXPECT_EQ(evaluator.eval("f(len)")->inspect(), "12");
+    evaluator.eval("g = fn(x) { 100 };");
+    EXPECT_EQ(evaluator.eval("f(len)")->inspect(), "102");
+
+    // 新增的全局变量可能覆盖内置函数，缓存失效后重新查找
+    Parser other;
+    auto call = other.parse("let k = fn() { len(\"ab\") }; k()");
+    EXPECT_EQ(evaluator.eval(call.get(), evaluator._env)->inspect(), "2");
+    evaluator.eval("let len = fn(x) { 42 };");
+    EXPECT_NE(evaluator._env->version(), version);
+    EXPECT_EQ(evaluator.eval(call.get(), evaluator._env)->inspect(), "42");
+
+    evaluator.reset_env();
+    evaluator.eval("let g = fn(x) { 7 };");
+    EXPECT_EQ(evaluator.eval(program.get(), evaluator._env)->cast<Function>()->parameters().size(), 1);
+    EXPECT_EQ(evaluator.eval("f(len)")->inspect(), "9");
+}
+
 TEST(Evaluator, TestStringExpression) {
     std::vector<std::tuple<std::string, std::string>> tests = {
         {R"("hello world")", "hello world"},
@@ -388,4 +769,95 @@ TEST(Evaluator, TestHashLiteral) {
     test_integer_object(hash_obj->get(std::make_unique<object::Boolean>(false).get()).get(), 6);
 }
 
+TEST(Evaluator, TestStats) {
+    std::string input = R"(
+        let fib = fn(n) {
+            if (n < 2) {
+                return n;
+            }
+            return fib(n - 1) + fib(n - 2);
+        };
+        let h = {"a": 1};
+        fib(5) + len([1, 2]) + h["a"];
+    )";
+
+    Evaluator evaluator;
+    auto object = evaluator.eval(input);
+    test_integer_object(object.get(), 8);
+
+    auto& stats = evaluator.stats();
+    // fib(5) 共调用 15 次，最深 5 层
+    EXPECT_EQ(15u, stats.calls);
+    EXPECT_EQ(5u, stats.max_depth);
+    EXPECT_EQ(1u, stats.builtin_calls);
+    // 全局环境由构造函数创建，不计入；fib 的调用帧不会逃逸，帧栈每一层只构造一次
+    EXPECT_EQ(5u, stats.environments);
+    // len 在环境中查找失败后才落到内置函数
+    EXPECT_EQ(1u, stats.env_misses);
+    EXPECT_EQ(2u, stats.hash_probes);
+    EXPECT_EQ(1u, stats.objects[object::Type::FUNCTION_OBJECT]);
+    EXPECT_EQ(1u, stats.objects[object::Type::HASH_OBJECT]);
+    EXPECT_EQ(1u, stats.objects[object::Type::ARRAY_OBJECT]);
+    EXPECT_EQ(0u, stats.depth);
+
+    evaluator.reset_stats();
+    EXPECT_EQ(0u, evaluator.stats().calls);
+    EXPECT_EQ(0u, evaluator.stats().objects[object::Type::INTEGER_OBJECT]);
+}
+
+TEST(Evaluator, TestQuickening) {
+    using Quick = ast::InfixExpression::Quick;
+    // 同一个节点依次用不同的操作数求值：<操作数, 结果, 求值后节点的状态>
+    std::vector<std::tuple<std::string, std::vector<std::tuple<std::string, std::string, Quick>>>> tests = {
+        {"a < b", {
+            {"let a = 1; let b = 2;", "true", Quick::INTEGER},
+            {"let a = 5; let b = 3;", "false", Quick::INTEGER},
+            {"let a = 1.5; let b = 2;", "true", Quick::GENERIC},
+            {"let a = 1; let b = 2;", "true", Quick::GENERIC},
+        }},
+        {"a + b", {
+            {"let a = 9223372036854775807; let b = 1;", "9223372036854775808", Quick::INTEGER},
+            {"let a = 2; let b = 3;", "5", Quick::INTEGER},
+            {"let a = \"x\"; let b = \"y\";", "xy", Quick::GENERIC},
+        }},
+        {"a + b", {
+            {"let a = \"x\"; let b = \"y\";", "xy", Quick::STRING},
+            {"let a = 1; let b = 2;", "3", Quick::GENERIC},
+        }},
+        {"a / b", {
+            {"let a = 7; let b = 2;", "3", Quick::INTEGER},
+            {"let a = 7; let b = 0;", "error: division by zero", Quick::INTEGER},
+            {"let a = 1.0; let b = 4.0;", "0.25", Quick::GENERIC},
+        }},
+        {"a * b", {
+            {"let a = 1.5; let b = 2.0;", "3.0", Quick::FLOAT},
+            {"let a = 1.5; let b = 2;", "3.0", Quick::GENERIC},
+        }},
+        {"a == b", {
+            {"let a = \"x\"; let b = a;", "error: unknown operator: `STRING == STRING`", Quick::GENERIC},
+        }},
+    };
+
+    for (auto& [input, steps] : tests) {
+        Parser parser;
+        auto program = parser.parse(input);
+        auto exp = program->statments()[0]->cast<ast::ExpressionStatment>()
+            ->expression()->cast<ast::InfixExpression>();
+        ASSERT_NE(exp, nullptr);
+        EXPECT_EQ(exp->quick(), Quick::UNINITIALIZED);
+
+        Evaluator evaluator;
+        for (auto& [operands, expected, quick] : steps) {
+            evaluator.eval(operands);
+            auto result = evaluator.eval(program.get(), evaluator._env);
+            evaluator._signal = Evaluator::Signal::NONE;
+            auto actual = result->type() == object::Type::STRING_OBJECT
+                ? result->cast<object::String>()->value()
+                : result->inspect();
+            EXPECT_EQ(actual, expected) << input << " with " << operands;
+            EXPECT_EQ(exp->quick(), quick) << input << " with " << operands;
+        }
+    }
+}
+
 }
@@ -0,0 +1,154 @@
+#include <string>
+#include <tuple>
+#include <vector>
+#include <gtest/gtest.h>
+#include "evaluator.h"
+#include "jit.h"
+
+using namespace autumn;
+
+namespace {
+
+const object::Function* lookup_function(Evaluator& evaluator, const std::string& name) {
+    auto obj = evaluator.lookup(name);
+    return obj == nullptr ? nullptr : obj->cast<object::Function>();
+}
+
+// 调用足够多次，让函数达到编译阈值
+void warm_up(Evaluator& evaluator, const std::string& call) {
+    evaluator.eval("let i = 0; while (i < " + std::to_string(jit::THRESHOLD + 10) + ") { "
+            + call + "; i = i + 1 }");
+}
+
+}
+
+TEST(Jit, TestCompile) {
+    if (!jit::supported()) {
+        GTEST_SKIP();
+    }
+
+    std::vector<std::tuple<std::string, std::vector<int64_t>, int64_t>> tests = {
+        {"let f = fn(n) { if (n < 2) { return n; } return f(n - 1) + f(n - 2); };", {20}, 6765},
+        {"let f = fn(a, b) { let c = a * b; let d = c - a / b; if (d > 10) { d } else { -d } };", {7, 3}, 19},
+        {"let f = fn(a, b) { let c = a * b; let d = c - a / b; if (d > 10) { d } else { -d } };", {1, 3}, -3},
+        {"let sq = fn(x) { x * x }; let f = fn(a, b) { sq(a) + sq(b) };", {3, 4}, 25},
+        {"let f = fn(a, b) { a / b };", {-7, 2}, -3},
+        {"let f = fn(a, b) { a / b };", {7, -1}, -7},
+        {"let f = fn(a, b) { if (b == 0) { a } else { f(b, a - a / b * b) } };", {1071, 462}, 21},
+        {"let f = fn(a, b) { if (a != b) { 1 } else { 0 } + if (a <= b) { 10 } else { 20 } };", {2, 2}, 10},
+        {"let f = fn(x) { let x = x + 1; let x = x * 2; x };", {4}, 10},
+        {"let f = fn(x) { if (true) { x } else { 0 } };", {5}, 5},
+    };
+
+    for (auto& [input, args, expected] : tests) {
+        Evaluator evaluator;
+        evaluator.eval(input);
+        auto code = jit::compile(lookup_function(evaluator, "f"));
+        ASSERT_NE(code, nullptr) << input;
+        ASSERT_EQ(code->arity(), args.size());
+        EXPECT_TRUE(code->valid());
+
+        auto result = code->run(args.data());
+        EXPECT_EQ(result.deopt, 0) << input;
+        EXPECT_EQ(result.value, expected) << input;
+    }
+}
+
+TEST(Jit, TestReject) {
+    std::vector<std::string> tests = {
+        R"(let f = fn(x) { x + "a" };)",
+        "let f = fn(x) { len(x) };",
+        "let f = fn(x) { x + 1.5 };",
+        "let f = fn(x) { 100000000000000000000 * x };",
+        "let f = fn(x) { x < 1 };",
+        "let f = fn(x) { if (x > 1) { x } };",
+        "let f = fn(x) { if (x > 1) { let y = 1; } x };",
+        "let f = fn(x) { let y = 1; };",
+        "let f = fn(x) { y };",
+        "let f = fn(x) { x = 1 };",
+        "let f = fn() { };",
+        "let g = 1; let f = fn(x) { g(x) };",
+        "let g = fn(x, y) { x }; let f = fn(x) { g(x) };",
+        "let g = fn(x) { f(x) }; let f = fn(x) { if (x > 0) { g(x - 1) } else { 0 } };",
+    };
+
+    for (auto& input : tests) {
+        Evaluator evaluator;
+        evaluator.eval(input);
+        EXPECT_EQ(jit::compile(lookup_function(evaluator, "f")), nullptr) << input;
+    }
+}
+
+// 机器码处理不了的情况回到解释器，结果与关闭 JIT 时相同
+TEST(Jit, TestDeopt) {
+    if (!jit::supported()) {
+        GTEST_SKIP();
+    }
+
+    const std::string prelude = R"(
+        let mul = fn(a, b) { a * b };
+        let div = fn(a, b) { a / b };
+        let neg = fn(a) { -a };
+    )";
+
+    std::vector<std::tuple<std::string, std::string>> tests = {
+        {"mul(3, 4)", "12"},
+        {"mul(4611686018427387904, 4)", "18446744073709551616"},
+        {"mul(100000000000000000000, 2)", "200000000000000000000"},
+        {"mul(1.5, 2)", "3.0"},
+        {R"(mul("a", 2))", "error: type mismatch: `STRING * INTEGER`"},
+        {"mul(1)", "error: identifier not found: `b`"},
+        {"div(-9223372036854775807 - 1, -1)", "9223372036854775808"},
+        {"div(1, 0)", "error: division by zero"},
+        {"neg(-9223372036854775807 - 1)", "9223372036854775808"},
+    };
+
+    Evaluator evaluator;
+    evaluator.eval(prelude);
+    warm_up(evaluator, "mul(i, 2); div(i, 3); neg(i)");
+    for (auto name : {"mul", "div", "neg"}) {
+        EXPECT_NE(lookup_function(evaluator, name)->tier().code, nullptr) << name;
+    }
+
+    Evaluator interpreter;
+    interpreter.set_jit(false);
+    interpreter.eval(prelude);
+
+    for (auto& [input, expected] : tests) {
+        EXPECT_EQ(evaluator.eval(input)->inspect(), expected) << input;
+        EXPECT_EQ(interpreter.eval(input)->inspect(), expected) << input;
+    }
+}
+
+// 被调函数重新绑定后，入口守卫让旧的机器码失效
+TEST(Jit, TestRebind) {
+    if (!jit::supported()) {
+        GTEST_SKIP();
+    }
+
+    Evaluator evaluator;
+    evaluator.eval("let g = fn(x) { x + 1 }; let f = fn(x) { g(x) * 2 };");
+    warm_up(evaluator, "f(i)");
+
+    auto f = lookup_function(evaluator, "f");
+    ASSERT_NE(f->tier().code, nullptr);
+    EXPECT_EQ(evaluator.eval("f(1)")->inspect(), "4");
+
+    evaluator.eval("g = fn(x) { x + 2 }");
+    EXPECT_EQ(evaluator.eval("f(1)")->inspect(), "6");
+    EXPECT_EQ(f->tier().code, nullptr);
+
+    evaluator.eval("g = 1");
+    EXPECT_EQ(evaluator.eval("f(1)")->inspect(), "error: type mismatch: `NULL * INTEGER`");
+}
+
+// 出现过非整数参数的函数不会被编译
+TEST(Jit, TestObserve) {
+    Evaluator evaluator;
+    evaluator.eval("let f = fn(x) { x }; f(true);");
+    warm_up(evaluator, "f(i)");
+
+    auto& tier = lookup_function(evaluator, "f")->tier();
+    EXPECT_TRUE(tier.rejected);
+    EXPECT_EQ(tier.code, nullptr);
+}
@@ -216,3 +216,87 @@ TEST(Lexer, TestNontrivial) {
         EXPECT_EQ(expect_token.type, token.type);
     }
 }
+
+TEST(Lexer, TestLoop) {
+    std::string input = R"(
+        while (i < 3) { i = i + 1; }
+        for (x in arr) { x }
+    )";
+
+    Token expect_tokens[] = {
+        {Token::WHILE, "while"},
+        {Token::LPAREN, "("},
+        {Token::IDENT, "i"},
+        {Token::LT, "<"},
+        {Token::INT, "3"},
+        {Token::RPAREN, ")"},
+        {Token::LBRACE, "{"},
+        {Token::IDENT, "i"},
+        {Token::ASSIGN, "="},
+        {Token::IDENT, "i"},
+        {Token::PLUS, "+"},
+        {Token::INT, "1"},
+        {Token::SEMICOLON, ";"},
+        {Token::RBRACE, "}"},
+        {Token::FOR, "for"},
+        {Token::LPAREN, "("},
+        {Token::IDENT, "x"},
+        {Token::IN, "in"},
+        {Token::IDENT, "arr"},
+        {Token::RPAREN, ")"},
+        {Token::LBRACE, "{"},
+        {Token::IDENT, "x"},
+        {Token::RBRACE, "}"},
+        {Token::END, ""},
+    };
+
+    Lexer lexer(input);
+
+    for (auto& expect_token: expect_tokens) {
+        auto token = lexer.next_token();
+        EXPECT_EQ(expect_token.literal, token.literal);
+        EXPECT_EQ(expect_token.type, token.type);
+    }
+}
+
+TEST(Lexer, TestFloat) {
+    std::string input = "1.5 + 10.25 * 3;";
+
+    Token expect_tokens[] = {
+        {Token::FLOAT, "1.5"},
+        {Token::PLUS, "+"},
+        {Token::FLOAT, "10.25"},
+        {Token::ASTERISK, "*"},
+        {Token::INT, "3"},
+        {Token::SEMICOLON, ";"},
+        {Token::END, ""},
+    };
+
+    Lexer lexer(input);
+
+    for (auto& expect_token: expect_tokens) {
+        auto token = lexer.next_token();
+        EXPECT_EQ(expect_token.literal, token.literal);
+        EXPECT_EQ(expect_token.type, token.type);
+    }
+}
+
+TEST(Lexer, TestUnterminatedString) {
+    std::string input = R"(let s = "abc)";
+
+    Token expect_tokens[] = {
+        {Token::LET, "let"},
+        {Token::IDENT, "s"},
+        {Token::ASSIGN, "="},
+        {Token::STRING, "abc"},
+        {Token::END, ""},
+    };
+
+    Lexer lexer(input);
+
+    for (auto& expect_token: expect_tokens) {
+        auto token = lexer.next_token();
+        EXPECT_EQ(expect_token.literal, token.literal);
+        EXPECT_EQ(expect_token.type, token.type);
+    }
+}
@@ -0,0 +1,45 @@
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+#include "line_reader.h"
+
+// 把 input 写入临时文件，用很小的块读取，覆盖跨块和超长行的情况
+std::vector<std::string> read_lines(const std::string& input, size_t chunk_size) {
+    FILE* file = tmpfile();
+    fwrite(input.data(), 1, input.size(), file);
+    fflush(file);
+    lseek(fileno(file), 0, SEEK_SET);
+
+    std::vector<std::string> lines;
+    autumn::LineReader reader(fileno(file), chunk_size);
+    std::string_view line;
+    while (reader.next(line)) {
+        lines.emplace_back(line);
+    }
+    fclose(file);
+    return lines;
+}
+
+TEST(LineReader, TestNext) {
+    std::vector<std::tuple<std::string, std::vector<std::string>>> tests = {
+        {"", {}},
+        {"\n", {""}},
+        {"a\nbb\nccc\n", {"a", "bb", "ccc"}},
+        {"a\n\nb", {"a", "", "b"}},
+        {"abcdefghijklmnopqrstuvwxyz\n1\n", {"abcdefghijklmnopqrstuvwxyz", "1"}},
+        {"0123456789abcdef", {"0123456789abcdef"}},
+    };
+
+    for (auto& [input, expected] : tests) {
+        for (size_t chunk_size : {2, 4, 7, 1 << 20}) {
+            EXPECT_EQ(read_lines(input, chunk_size), expected)
+                << "input: " << input << " chunk_size: " << chunk_size;
+        }
+    }
+}
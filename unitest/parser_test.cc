@@ -2,6 +2,7 @@
 #include <string>
 #include <tuple>
 #include <gtest/gtest.h>
+#include "builtin.h"
 #include "parser.h"
 
 using namespace autumn;
@@ -178,6 +179,28 @@ TEST(Parser, TestIdentifierExpression) {
     ASSERT_TRUE(exp != nullptr);
     auto ident = exp->cast<Identifier>();
     test_literal(std::string("foobar"), ident);
+    EXPECT_EQ(-1, ident->builtin());
+}
+
+TEST(Parser, TestBuiltinIdentifier) {
+    std::string input = "len(a);";
+    Parser parser;
+
+    auto program = parser.parse(input);
+    ASSERT_TRUE(program != nullptr);
+    auto stmt = program->statments()[0]->cast<ExpressionStatment>();
+    ASSERT_TRUE(stmt != nullptr);
+    auto call = stmt->expression()->cast<CallExpression>();
+    ASSERT_TRUE(call != nullptr);
+
+    auto fn = call->function()->cast<Identifier>();
+    ASSERT_TRUE(fn != nullptr);
+    EXPECT_EQ(builtin::lookup("len"), fn->builtin());
+    EXPECT_GE(fn->builtin(), 0);
+
+    auto arg = call->arguments()[0]->cast<Identifier>();
+    ASSERT_TRUE(arg != nullptr);
+    EXPECT_EQ(-1, arg->builtin());
 }
 
 TEST(Parser, TestIntegerLiteralExpression) {
@@ -198,6 +221,53 @@ TEST(Parser, TestIntegerLiteralExpression) {
     ASSERT_TRUE(int_literal != nullptr);
     EXPECT_STREQ("123", int_literal->token_literal().c_str());
     EXPECT_EQ(123, int_literal->value());
+    EXPECT_FALSE(int_literal->overflow());
+}
+
+TEST(Parser, TestLargeIntegerLiteral) {
+    std::vector<std::tuple<std::string, int64_t, bool>> tests = {
+        {"9223372036854775807", INT64_MAX, false},
+        {"9223372036854775808", 0, true},
+        {"100000000000000000000", 0, true},
+    };
+
+    Parser parser;
+
+    for (auto& test : tests) {
+        auto program = parser.parse(std::get<0>(test));
+        ASSERT_TRUE(program != nullptr);
+        EXPECT_TRUE(parser.errors().empty());
+        auto stmt = program->statments()[0]->cast<ExpressionStatment>();
+        ASSERT_TRUE(stmt != nullptr);
+        auto int_literal = stmt->expression()->cast<IntegerLiteral>();
+        ASSERT_TRUE(int_literal != nullptr);
+        EXPECT_EQ(std::get<2>(test), int_literal->overflow());
+        if (!std::get<2>(test)) {
+            EXPECT_EQ(std::get<1>(test), int_literal->value());
+        }
+    }
+}
+
+TEST(Parser, TestFloatLiteralExpression) {
+    std::vector<std::tuple<std::string, double>> tests = {
+        {"1.5", 1.5},
+        {"0.125", 0.125},
+        {"10.0", 10.0},
+    };
+
+    Parser parser;
+
+    for (auto& test : tests) {
+        auto program = parser.parse(std::get<0>(test));
+        ASSERT_TRUE(program != nullptr);
+        EXPECT_TRUE(parser.errors().empty());
+        auto stmt = program->statments()[0]->cast<ExpressionStatment>();
+        ASSERT_TRUE(stmt != nullptr);
+        auto float_literal = stmt->expression()->cast<FloatLiteral>();
+        ASSERT_TRUE(float_literal != nullptr);
+        EXPECT_EQ(std::get<0>(test), float_literal->to_string());
+        EXPECT_EQ(std::get<1>(test), float_literal->value());
+    }
 }
 
 TEST(Parser, TestStringLiteralExpression) {
@@ -322,6 +392,11 @@ TEST(Parser, TestOperatorPrecedenceParsing) {
         {"add(a + b + c * d / f + g)", "add((((a + b) + ((c * d) / f)) + g))"},
         {"a * [1, 2, 3, 4][b * c] * d", "((a * ([1, 2, 3, 4][(b * c)])) * d)"},
         {"add(a * b[2], b[1], 2 * [1, 2][1])", "add((a * (b[2])), (b[1]), (2 * ([1, 2][1])))"},
+        {"a = b + c", "(a = (b + c))"},
+        {"a = b = 1 * 2", "(a = (b = (1 * 2)))"},
+        {"a = b == c", "(a = (b == c))"},
+        {"a[i + 1] = b[0] * 2", "((a[(i + 1)]) = ((b[0]) * 2))"},
+        {"h[\"k\"][0] = 1", "(((h[k])[0]) = 1)"},
     };
 
     Parser parser;
@@ -434,6 +509,75 @@ TEST(Parser, TestIfElseExpression) {
     test_literal(std::string("y"), stmt->expression());
 }
 
+TEST(Parser, TestWhileExpression) {
+    std::string input = "while (x < y) { x = x + 1; }";
+
+    Parser parser;
+    auto program = parser.parse(input);
+    for (auto& error : parser.errors()) {
+        std::cout << error << std::endl;
+    }
+
+    ASSERT_TRUE(program != nullptr);
+    auto& statments = program->statments();
+    ASSERT_EQ(1u, statments.size());
+    auto stmt = statments[0]->cast<ExpressionStatment>();
+    ASSERT_TRUE(stmt != nullptr);
+    auto while_exp = stmt->expression()->cast<WhileExpression>();
+    ASSERT_TRUE(while_exp != nullptr);
+    test_infix_expression("x", "<", "y", while_exp->condition());
+
+    auto body = while_exp->body();
+    ASSERT_TRUE(body != nullptr);
+    ASSERT_EQ(1u, body->statments().size());
+    stmt = body->statments()[0]->cast<ExpressionStatment>();
+    ASSERT_TRUE(stmt != nullptr);
+    auto assign_exp = stmt->expression()->cast<AssignExpression>();
+    ASSERT_TRUE(assign_exp != nullptr);
+    test_literal(std::string("x"), assign_exp->target());
+    test_infix_expression("x", "+", 1, assign_exp->value());
+}
+
+TEST(Parser, TestForExpression) {
+    std::string input = "for (x in [1, 2]) { x }";
+
+    Parser parser;
+    auto program = parser.parse(input);
+    for (auto& error : parser.errors()) {
+        std::cout << error << std::endl;
+    }
+
+    ASSERT_TRUE(program != nullptr);
+    auto& statments = program->statments();
+    ASSERT_EQ(1u, statments.size());
+    auto stmt = statments[0]->cast<ExpressionStatment>();
+    ASSERT_TRUE(stmt != nullptr);
+    auto for_exp = stmt->expression()->cast<ForExpression>();
+    ASSERT_TRUE(for_exp != nullptr);
+    test_literal(std::string("x"), for_exp->variable());
+    ASSERT_TRUE(for_exp->iterable()->cast<ArrayLiteral>() != nullptr);
+
+    auto body = for_exp->body();
+    ASSERT_TRUE(body != nullptr);
+    ASSERT_EQ(1u, body->statments().size());
+    EXPECT_EQ("for (x in [1, 2]) {x}", program->to_string());
+}
+
+TEST(Parser, TestErrorAssignExpression) {
+    std::vector<std::string> tests = {
+        "1 = 2",
+        "a + b = c",
+        "f() = 1",
+    };
+
+    Parser parser;
+
+    for (auto& input : tests) {
+        parser.parse(input);
+        EXPECT_FALSE(parser.errors().empty()) << input;
+    }
+}
+
 TEST(Parser, TestFunctionLiteralParsing) {
     std::string input = "fn(x, y) { x + y; }";
 
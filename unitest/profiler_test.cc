@@ -0,0 +1,71 @@
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "evaluator.h"
+
+using namespace autumn;
+
+namespace {
+
+TEST(Profiler, TestCollapsedStack) {
+    std::string input = R"(
+        let fib = fn(n) {
+            if (n < 2) {
+                return n;
+            }
+            return fib(n - 1) + fib(n - 2);
+        };
+        fib(20);
+    )";
+
+    Evaluator evaluator;
+    evaluator.start_profiler(std::chrono::microseconds(100));
+    EXPECT_TRUE(evaluator.profiling());
+    evaluator.eval(input);
+
+    std::stringstream out;
+    evaluator.stop_profiler(out);
+    EXPECT_FALSE(evaluator.profiling());
+
+    std::string line;
+    size_t fib_stacks = 0;
+    while (std::getline(out, line)) {
+        // 每一行形如 <program>;fib;fib 12
+        ASSERT_EQ(0u, line.find("<program>"));
+        auto space = line.rfind(' ');
+        ASSERT_NE(std::string::npos, space);
+        EXPECT_GT(std::stoi(line.substr(space + 1)), 0);
+        if (line.find("<program>;fib;fib") == 0) {
+            ++fib_stacks;
+        }
+    }
+    EXPECT_GT(fib_stacks, 0u);
+}
+
+TEST(Profiler, TestAnonymousFrame) {
+    Profiler profiler(std::chrono::microseconds(100));
+    profiler.enter("<anonymous>");
+    profiler.enter("len");
+    profiler.start();
+    while (profiler.samples() == 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    profiler.stop();
+    profiler.leave();
+    profiler.leave();
+
+    std::stringstream out;
+    profiler.write_collapsed(out);
+    EXPECT_EQ(0u, out.str().find("<program>;<anonymous>;len "));
+}
+
+TEST(Profiler, TestDisabled) {
+    Evaluator evaluator;
+    EXPECT_FALSE(evaluator.profiling());
+
+    std::stringstream out;
+    evaluator.stop_profiler(out);
+    EXPECT_TRUE(out.str().empty());
+}
+
+}
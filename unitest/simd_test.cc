@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+#include "simd.h"
+
+using namespace autumn;
+
+namespace {
+
+// 覆盖向量化主循环和各种长度的尾部
+const size_t SIZES[] = {1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 100, 1023};
+
+std::vector<int64_t> random_values(size_t n, std::mt19937_64& rng,
+        int64_t low = std::numeric_limits<int64_t>::min(),
+        int64_t high = std::numeric_limits<int64_t>::max()) {
+    std::uniform_int_distribution<int64_t> dist(low, high);
+    std::vector<int64_t> values(n);
+    for (auto& v : values) {
+        v = dist(rng);
+    }
+    return values;
+}
+
+bool fits(__int128 v) {
+    return v >= std::numeric_limits<int64_t>::min() && v <= std::numeric_limits<int64_t>::max();
+}
+
+// 每种可用的实现都与朴素实现比较，结果按 64 位回绕
+// 求和与按元素加法精确报告溢出；乘法允许多报，但真正溢出时必须报告
+void check_all(std::mt19937_64& rng, int64_t low, int64_t high) {
+    for (size_t n : SIZES) {
+        auto a = random_values(n, rng, low, high);
+        auto b = random_values(n, rng, low, high);
+
+        uint64_t sum = 0;
+        uint64_t dot = 0;
+        __int128 exact_sum = 0;
+        bool dot_overflow = false;
+        std::vector<int64_t> add(n);
+        std::vector<int64_t> mul(n);
+        std::vector<int64_t> add_scalar(n);
+        std::vector<int64_t> mul_scalar(n);
+        bool add_overflow = false;
+        bool mul_overflow = false;
+        bool add_scalar_overflow = false;
+        bool mul_scalar_overflow = false;
+        std::vector<int64_t> gt;
+        for (size_t i = 0; i < n; ++i) {
+            sum += a[i];
+            dot += uint64_t(a[i]) * uint64_t(b[i]);
+            exact_sum += a[i];
+            dot_overflow |= !fits(__int128(a[i]) * b[i]);
+            add[i] = uint64_t(a[i]) + uint64_t(b[i]);
+            mul[i] = uint64_t(a[i]) * uint64_t(b[i]);
+            add_scalar[i] = uint64_t(a[i]) + uint64_t(b[0]);
+            mul_scalar[i] = uint64_t(a[i]) * uint64_t(b[0]);
+            add_overflow |= !fits(__int128(a[i]) + b[i]);
+            mul_overflow |= !fits(__int128(a[i]) * b[i]);
+            add_scalar_overflow |= !fits(__int128(a[i]) + b[0]);
+            mul_scalar_overflow |= !fits(__int128(a[i]) * b[0]);
+            if (a[i] > b[0]) {
+                gt.push_back(a[i]);
+            }
+        }
+
+        int64_t result = 0;
+        EXPECT_EQ(!fits(exact_sum), simd::sum(a.data(), n, &result)) << n;
+        EXPECT_EQ(int64_t(sum), result) << n;
+        EXPECT_EQ(*std::min_element(a.begin(), a.end()), simd::min(a.data(), n)) << n;
+        EXPECT_EQ(*std::max_element(a.begin(), a.end()), simd::max(a.data(), n)) << n;
+        bool overflow = simd::dot(a.data(), b.data(), n, &result);
+        EXPECT_TRUE(overflow || !dot_overflow) << n;
+        EXPECT_EQ(int64_t(dot), result) << n;
+
+        std::vector<int64_t> out(n);
+        EXPECT_EQ(add_overflow, simd::add(a.data(), b.data(), out.data(), n)) << n;
+        EXPECT_EQ(add, out) << n;
+        overflow = simd::mul(a.data(), b.data(), out.data(), n);
+        EXPECT_TRUE(overflow || !mul_overflow) << n;
+        EXPECT_EQ(mul, out) << n;
+        EXPECT_EQ(add_scalar_overflow, simd::add(a.data(), b[0], out.data(), n)) << n;
+        EXPECT_EQ(add_scalar, out) << n;
+        overflow = simd::mul(a.data(), b[0], out.data(), n);
+        EXPECT_TRUE(overflow || !mul_scalar_overflow) << n;
+        EXPECT_EQ(mul_scalar, out) << n;
+
+        out.assign(n, 0);
+        out.resize(simd::filter_gt(a.data(), n, b[0], out.data()));
+        EXPECT_EQ(gt, out) << n;
+    }
+}
+
+// 数值较小时不会溢出，所有运算都不能报告溢出
+void check_small(std::mt19937_64& rng) {
+    for (size_t n : SIZES) {
+        auto a = random_values(n, rng, -1000000, 1000000);
+        auto b = random_values(n, rng, -1000000, 1000000);
+        std::vector<int64_t> out(n);
+        int64_t result;
+        EXPECT_FALSE(simd::sum(a.data(), n, &result)) << n;
+        EXPECT_FALSE(simd::dot(a.data(), b.data(), n, &result)) << n;
+        EXPECT_FALSE(simd::add(a.data(), b.data(), out.data(), n)) << n;
+        EXPECT_FALSE(simd::mul(a.data(), b.data(), out.data(), n)) << n;
+        EXPECT_FALSE(simd::add(a.data(), b[0], out.data(), n)) << n;
+        EXPECT_FALSE(simd::mul(a.data(), b[0], out.data(), n)) << n;
+    }
+}
+
+void check_isa() {
+    std::mt19937_64 rng(1);
+    check_all(rng, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max());
+    // 32 位范围内的数相乘不会溢出，求和可能溢出也可能不溢出
+    check_all(rng, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max());
+    check_all(rng, std::numeric_limits<int64_t>::max() / 8, std::numeric_limits<int64_t>::max() / 4);
+    check_small(rng);
+
+    // 中间结果溢出但总和在范围内
+    std::vector<int64_t> values = {std::numeric_limits<int64_t>::max(), 1, 1, 1, 1, -1, -1, -1, -1};
+    int64_t result;
+    EXPECT_FALSE(simd::sum(values.data(), values.size(), &result));
+    EXPECT_EQ(std::numeric_limits<int64_t>::max(), result);
+}
+
+TEST(Simd, TestScalar) {
+    auto isa = simd::isa();
+    ASSERT_TRUE(simd::set_isa(simd::Isa::SCALAR));
+    check_isa();
+    simd::set_isa(isa);
+}
+
+TEST(Simd, TestAvx2) {
+    auto isa = simd::isa();
+    if (!simd::set_isa(simd::Isa::AVX2)) {
+        GTEST_SKIP() << "AVX2 not supported";
+    }
+    check_isa();
+    simd::set_isa(isa);
+}
+
+TEST(Simd, TestEmpty) {
+    int64_t result = -1;
+    EXPECT_FALSE(simd::sum(nullptr, 0, &result));
+    EXPECT_EQ(0, result);
+    result = -1;
+    EXPECT_FALSE(simd::dot(nullptr, nullptr, 0, &result));
+    EXPECT_EQ(0, result);
+    EXPECT_EQ(0u, simd::filter_gt(nullptr, 0, 0, nullptr));
+}
+
+}
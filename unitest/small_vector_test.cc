@@ -0,0 +1,77 @@
+#include <memory>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "small_vector.h"
+#include "span.h"
+
+using namespace autumn;
+
+namespace {
+
+TEST(SmallVector, TestInline) {
+    SmallVector<std::shared_ptr<int>, 4> v;
+    for (int i = 0; i < 4; ++i) {
+        v.emplace_back(std::make_shared<int>(i));
+    }
+    EXPECT_TRUE(v.is_inline());
+    ASSERT_EQ(4u, v.size());
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(i, *v[i]);
+    }
+}
+
+TEST(SmallVector, TestGrow) {
+    auto shared = std::make_shared<int>(42);
+    {
+        SmallVector<std::shared_ptr<int>, 2> v;
+        for (int i = 0; i < 10; ++i) {
+            v.push_back(shared);
+        }
+        EXPECT_FALSE(v.is_inline());
+        EXPECT_EQ(10u, v.size());
+        EXPECT_EQ(11, shared.use_count());
+
+        SmallVector<std::shared_ptr<int>, 2> moved(std::move(v));
+        EXPECT_EQ(0u, v.size());
+        EXPECT_EQ(10u, moved.size());
+        EXPECT_EQ(11, shared.use_count());
+    }
+    EXPECT_EQ(1, shared.use_count());
+}
+
+TEST(SmallVector, TestMoveInline) {
+    SmallVector<std::string, 4> v;
+    v.emplace_back("hello");
+    v.emplace_back("autumn");
+
+    SmallVector<std::string, 4> moved(std::move(v));
+    EXPECT_TRUE(moved.is_inline());
+    ASSERT_EQ(2u, moved.size());
+    EXPECT_EQ("hello", moved[0]);
+    EXPECT_EQ("autumn", moved[1]);
+    EXPECT_TRUE(v.empty());
+}
+
+TEST(Span, TestView) {
+    std::vector<int> vec = {1, 2, 3};
+    Span<const int> span(vec);
+    ASSERT_EQ(3u, span.size());
+    EXPECT_EQ(1, span.front());
+    EXPECT_EQ(3, span.back());
+
+    int sum = 0;
+    for (auto i : span) {
+        sum += i;
+    }
+    EXPECT_EQ(6, sum);
+
+    SmallVector<int, 4> small;
+    small.push_back(7);
+    Span<int> small_span(small);
+    EXPECT_EQ(1u, small_span.size());
+    EXPECT_EQ(7, small_span[0]);
+    EXPECT_TRUE(Span<int>().empty());
+}
+
+}
@@ -0,0 +1,105 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <gtest/gtest.h>
+#include "evaluator.h"
+
+using namespace autumn;
+
+namespace {
+
+const std::string PRELUDE = R"(
+let fib = fn(n) { if (n < 2) { n } else { fib(n - 1) + fib(n - 2) } };
+let make_counter = fn() { let n = 0; fn() { n = n + 1; n } };
+let counter = make_counter();
+counter();
+let add = fn(x) { fn(y) { x + y } };
+let add_ten = add(10);
+let make = fn(x) { fn(y) { fn(z) { x + y + z } } };
+let adder = make(1);
+let size = len;
+let a = [1, "two", 3.5, true, [4]];
+let b = a;
+let h = {"k": a, "f": fn(x) { x * 2 }, true: 100000000000000000000};
+let ints = int_array([1, 2, 3]);
+)";
+
+TEST(Snapshot, TestRestore) {
+    std::string path = "snapshot_test.atms";
+
+    Evaluator origin;
+    origin.eval(PRELUDE);
+    ASSERT_TRUE(origin.save_snapshot(path));
+
+    std::vector<std::tuple<std::string, std::string>> tests = {
+        {"fib(15)", "610"},
+        {"counter()", "2"},
+        {"add_ten(5)", "15"},
+        // 恢复出的函数体中再创建的闭包仍然能看到原来外层函数的变量
+        {"adder(2)(3)", "6"},
+        {"size(a)", "5"},
+        {"a", R"([1, "two", 3.5, true, [4]])"},
+        {"a[4][0]", "4"},
+        {"h[\"k\"][1]", R"("two")"},
+        {"h[\"f\"](21)", "42"},
+        {"h[true] + 1", "100000000000000000001"},
+        {"sum(ints * 2)", "12"},
+        {"a[3] == true", "true"},
+        // a 和 b 仍然共享同一个数组，修改其中一个不影响另一个
+        {"b[0] = 9; a[0]", "1"},
+    };
+
+    Evaluator evaluator;
+    ASSERT_TRUE(evaluator.load_snapshot(path));
+    for (auto& test : tests) {
+        auto object = evaluator.eval(std::get<0>(test));
+        EXPECT_EQ(std::get<1>(test), object->inspect()) << std::get<0>(test);
+    }
+
+    // 保存快照不会改变原来的环境
+    EXPECT_EQ("2", origin.eval("counter()")->inspect());
+
+    std::remove(path.c_str());
+}
+
+TEST(Snapshot, TestCorruptImage) {
+    std::string path = "snapshot_test.atms";
+
+    Evaluator origin;
+    origin.eval(PRELUDE);
+    ASSERT_TRUE(origin.save_snapshot(path));
+
+    std::string content;
+    {
+        std::ifstream in(path, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    Evaluator evaluator;
+    evaluator.eval("let x = 1;");
+
+    std::vector<std::string> images = {
+        content.substr(0, content.size() / 2),
+        content.substr(0, 4),
+        content + "x",
+        "",
+    };
+    content.back() ^= 1;
+    images.push_back(content);
+
+    for (auto& image : images) {
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out << image;
+        }
+        EXPECT_FALSE(evaluator.load_snapshot(path));
+        EXPECT_EQ("1", evaluator.eval("x")->inspect());
+    }
+
+    EXPECT_FALSE(evaluator.load_snapshot("no_such_file.atms"));
+    std::remove(path.c_str());
+}
+
+}
@@ -0,0 +1,59 @@
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "evaluator.h"
+#include "writer.h"
+
+using namespace autumn;
+
+std::string inspect(const object::Object* obj, size_t max_depth, size_t max_length) {
+    std::string ret;
+    StringWriter out(ret);
+    out.set_color(false);
+    out.set_max_depth(max_depth);
+    out.set_max_length(max_length);
+    obj->inspect(out);
+    return ret;
+}
+
+TEST(Writer, TestLimits) {
+    std::vector<std::tuple<std::string, size_t, size_t, std::string>> tests = {
+        {"[1, [2, [3, [4]]]]", Writer::UNLIMITED, Writer::UNLIMITED, "[1, [2, [3, [4]]]]"},
+        {"[1, [2, [3, [4]]]]", 2, Writer::UNLIMITED, "[1, [2, [...]]]"},
+        {"[1, [2, [3, [4]]]]", 0, Writer::UNLIMITED, "[...]"},
+        {"[1, [], [3]]", 1, Writer::UNLIMITED, "[1, [], [...]]"},
+        {"[1, 2, 3, 4, 5]", Writer::UNLIMITED, 3, "[1, 2, 3, ...]"},
+        {"[1, 2, 3]", Writer::UNLIMITED, 3, "[1, 2, 3]"},
+        {"[1, 2, 3]", Writer::UNLIMITED, 0, "[...]"},
+        {"int_array(5)", Writer::UNLIMITED, 2, "[0, 0, ...]"},
+        {R"({"a": [1, 2, 3]})", 1, Writer::UNLIMITED, R"({"a":[...]})"},
+        {R"({"a": [1, 2, 3]})", 2, 1, R"({"a":[1, ...]})"},
+        {R"([["x", 1.5], fn(x) { x }])", 2, 1, R"([["x", ...], ...])"},
+    };
+
+    Evaluator evaluator;
+    for (auto& [input, max_depth, max_length, expected] : tests) {
+        auto obj = evaluator.eval(input);
+        EXPECT_EQ(inspect(obj.get(), max_depth, max_length), expected) << input;
+    }
+}
+
+// 不限制时与 inspect() 的结果相同
+TEST(Writer, TestSameAsInspect) {
+    std::vector<std::string> tests = {
+        R"([1, "two", 3.5, true, [null], {"k": fn(x) { x }}, len, 100000000000000000000])",
+        R"(1 + "a")",
+    };
+
+    Evaluator evaluator;
+    for (auto& input : tests) {
+        auto obj = evaluator.eval(input);
+        std::string ret;
+        StringWriter out(ret);
+        obj->inspect(out);
+        EXPECT_EQ(ret, obj->inspect()) << input;
+    }
+}